@@ -12,194 +12,914 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
 #include "common/exception.h"
 #include "common/macros.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
 
+static auto MakeReplacer(ReplacerType replacer_type, size_t num_frames, size_t replacer_k)
+    -> std::unique_ptr<Replacer> {
+  switch (replacer_type) {
+    case ReplacerType::LRUK:
+      return std::make_unique<LRUKReplacer>(num_frames, replacer_k);
+    case ReplacerType::LRU:
+      return std::make_unique<LRUReplacer>(num_frames);
+    case ReplacerType::Clock:
+      return std::make_unique<ClockReplacer>(num_frames);
+    case ReplacerType::ClockPro:
+      return std::make_unique<ClockProReplacer>(num_frames);
+  }
+  UNREACHABLE("unknown replacer type");
+}
+
+/** Wait for a request of the disk scheduler, which forwards the errors of the disk manager. */
+static auto WaitIo(std::future<bool> *future) -> bool {
+  try {
+    return future->get();
+  } catch (...) {
+    return false;
+  }
+}
+
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                     LogManager *log_manager, size_t num_instances, ReplacerType replacer_type,
+                                     const FrameArenaOptions &arena_options, size_t num_disk_workers)
+    : pool_size_(pool_size),
+      arena_(std::make_unique<FrameArena>(pool_size, disk_manager->GetPageSize(), arena_options)),
+      disk_manager_(disk_manager),
+      disk_scheduler_(std::make_unique<DiskScheduler>(disk_manager, num_disk_workers)),
+      log_manager_(log_manager),
+      free_space_map_(disk_manager->GetPageSize()) {
   // TODO(students): remove this line after you have implemented the buffer pool manager
   //  throw NotImplementedException(
   //      "BufferPoolManager is not implemented yet. If you have finished implementing BPM, please remove the throw "
   //      "exception line in `buffer_pool_manager.cpp`.");
+  BUSTUB_ENSURE(num_instances > 0 && num_instances <= pool_size_, "invalid number of buffer pool instances");
 
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
+  // The page data of the frames lives in one consecutive arena, and their metadata in a separate array, so that
+  // scanning the metadata does not touch the page data.
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page), std::align_val_t(alignof(Page))));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (pages_ + i) Page(arena_->FrameData(i), arena_->GetPageSize());
+  }
 
-  // Initially, every page is in the free list.
+  // Split the frames into consecutive slices, the first `pool_size % num_instances` instances get one extra frame.
+  size_t frame_offset = 0;
+  for (size_t i = 0; i < num_instances; ++i) {
+    size_t num_frames = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+    instances_.emplace_back(
+        std::make_unique<BufferPoolInstance>(i, pages_ + frame_offset, num_frames, replacer_k, replacer_type));
+    frame_offset += num_frames;
+  }
+  free_space_map_.Load(disk_manager_);
+  InitFreePages();
+
+  std::vector<char *> buffers;
+  buffers.reserve(pool_size_);
   for (size_t i = 0; i < pool_size_; ++i) {
+    buffers.push_back(pages_[i].data_);
+  }
+  disk_manager_->RegisterBuffers(buffers);
+}
+
+BufferPoolManager::BufferPoolInstance::BufferPoolInstance(size_t instance_index, Page *frames, size_t num_frames,
+                                                          size_t replacer_k, ReplacerType replacer_type)
+    : instance_index_(instance_index),
+      frames_(frames),
+      num_frames_(num_frames),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      page_table_(num_frames),
+      replacer_(MakeReplacer(replacer_type, num_frames, replacer_k)),
+      frame_states_(num_frames),
+      frame_cvs_(num_frames) {
+  // Initially, every page is in the free list.
+  for (size_t i = 0; i < num_frames_; ++i) {
+    frame_states_[i] = FrameState::Free;
     free_list_.emplace_back(static_cast<int>(i));
   }
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }
+BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundWriter();
+  // Drain the scheduler first, pending prefetches write into the frames and update the instances when they complete.
+  disk_scheduler_.reset();
+  disk_manager_->UnregisterBuffers();
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t(alignof(Page)));
+}
 
-auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
-  frame_id_t fid;
-  std::unique_lock<std::mutex> lock(latch_);
-
-  if (free_list_.empty()) {
-    if (replacer_->Evict(&fid)) {
-      BUSTUB_ENSURE(page_table_.find(f2p_[fid]) != page_table_.end(), "N: evit page not in page table")
-      BUSTUB_ENSURE(this->DeletePageUnlocked(f2p_[fid]), "N: delete page failed")
-      BUSTUB_ENSURE(!free_list_.empty(), "N: free list size is 0")
-    } else {
-      return nullptr;
+auto BufferPoolManager::NewPage(page_id_t *page_id, page_id_t hint, bool *io_failed) -> Page * {
+  // Start from a different instance each time so that new pages are spread evenly, and fall back to the other
+  // instances when the preferred one has all of its frames pinned. With a hint, the instance of the hint goes first.
+  size_t start = hint == INVALID_PAGE_ID ? next_instance_.fetch_add(1) % instances_.size()
+                                         : static_cast<size_t>(hint) % instances_.size();
+  // A failed write back is reported even if the other instances only had all of their frames pinned.
+  bool write_failed = false;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    auto &instance = *instances_[(start + i) % instances_.size()];
+    std::unique_lock<std::mutex> lock(instance.latch_);
+    auto *page = NewPage(instance, lock, page_id, hint, &write_failed);
+    if (page != nullptr) {
+      if (io_failed != nullptr) {
+        *io_failed = false;
+      }
+      return page;
     }
-    BUSTUB_ENSURE(!free_list_.empty(), "N1: free list size is 0")
   }
-  BUSTUB_ENSURE(!free_list_.empty(), "N2: free list size is 0")
-
-  fid = free_list_.front();
-  free_list_.pop_front();
-  while (page_used_[next_page_id_]) {
-    next_page_id_++;
+  if (io_failed != nullptr) {
+    *io_failed = write_failed;
   }
-  *page_id = AllocatePage();
-
-  page_table_[*page_id] = fid;
-  f2p_[fid] = *page_id;
-  page_used_[*page_id] = true;
-  //  lock.unlock();
+  return nullptr;
+}
 
-  pages_[fid].page_id_ = *page_id;
-  pages_[fid].ResetMemory();
-  disk_manager_->ReadPage(*page_id, pages_[fid].data_);
-  pages_[fid].pin_count_ = 1;
+auto BufferPoolManager::NewPage(BufferPoolInstance &instance, std::unique_lock<std::mutex> &lock, page_id_t *page_id,
+                                page_id_t hint, bool *io_failed) -> Page * {
+  frame_id_t fid;
+  if (!AcquireFrame(instance, lock, &fid, io_failed)) {
+    return nullptr;
+  }
+  bool reused;
+  *page_id = AllocatePage(instance, hint, &reused);
+
+  instance.page_table_.Insert(*page_id, fid);
+  instance.frame_states_[fid] = FrameState::Resident;
+
+  // A freshly allocated page has never been written, so there is nothing to read from disk.
+  Page *page = instance.frames_ + fid;
+  page->BeginFrameChange();
+  page->page_id_ = *page_id;
+  page->ResetMemory();
+  page->EndFrameChange();
+  page->pin_count_ = 1;
+  if (reused) {
+    // The disk still holds the deleted page, which the zeroed page must replace even if it is never modified.
+    page->is_dirty_ = true;
+  }
 
-  replacer_->RecordAccess(fid);
-  return pages_ + fid;
+  instance.replacer_->RecordAccess(fid);
+  return page;
 }
 
-auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType access_type) -> Page * {
+auto BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type, bool *io_failed) -> Page * {
+  if (io_failed != nullptr) {
+    *io_failed = false;
+  }
+  auto &instance = InstanceOf(page_id);
   frame_id_t fid;
-  std::unique_lock<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
-    if (free_list_.empty()) {
-      if (replacer_->Evict(&fid)) {
-        BUSTUB_ENSURE(page_table_.find(f2p_[fid]) != page_table_.end(), "F: evit page not in page table")
-        BUSTUB_ENSURE(this->DeletePageUnlocked(f2p_[fid]), "F: delete page failed")
-        BUSTUB_ENSURE(!free_list_.empty(), "F: free list size is 0")
+  if (instance.page_table_.Find(page_id, &fid) && TryPinResident(instance, fid, page_id)) {
+    DeferAccess(instance, {page_id, fid, access_type, true});
+    counters_.Add(BufferPoolCounter::Hit);
+    return instance.frames_ + fid;
+  }
+
+  // The page is not resident, or it is being loaded or written back, or the lookup raced with a change of the page
+  // table. Look again with the latch held.
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  while (true) {
+    if (instance.page_table_.Find(page_id, &fid)) {
+      Page *page = instance.frames_ + fid;
+
+      // Pinning a page that is being written back cancels its eviction, and pinning a page that is being loaded makes
+      // us share the read. Either way, we only have to wait until this very frame becomes resident. An eviction holds
+      // its claim on the frame during the write, which becomes our pin.
+      if (page->pin_count_ == Page::CLAIMED) {
+        page->pin_count_ = 1;
       } else {
-        return nullptr;
+        page->pin_count_++;
+      }
+      instance.replacer_->RecordAccess(fid, access_type);
+      instance.replacer_->SetEvictable(fid, false);
+      // A page being written back is still valid in memory, a page being loaded is not there yet.
+      counters_.Add(instance.frame_states_[fid] == FrameState::Loading ? BufferPoolCounter::SharedRead
+                                                                       : BufferPoolCounter::Hit);
+      if (instance.frame_states_[fid] != FrameState::Resident) {
+        counters_.Add(BufferPoolCounter::PinWait);
+        instance.frame_cvs_[fid].wait(lock, [&] {
+          return instance.frame_states_[fid] != FrameState::Loading &&
+                 instance.frame_states_[fid] != FrameState::WritingBack;
+        });
+        if (instance.frame_states_[fid] == FrameState::Failed) {
+          // The read we shared failed and the frame left the page table, look again and read the page ourselves.
+          ReleaseFailedPin(instance, fid);
+          continue;
+        }
+      }
+      return page;
+    }
+
+    if (!AcquireFrame(instance, lock, &fid, io_failed)) {
+      return nullptr;
+    }
+    frame_id_t other_fid;
+    if (instance.page_table_.Find(page_id, &other_fid)) {
+      // Another thread started loading the page while we were writing back the victim.
+      instance.free_list_.emplace_front(fid);
+      continue;
+    }
+
+    instance.page_table_.Insert(page_id, fid);
+    MarkPageUsed(instance, page_id);
+    instance.frame_states_[fid] = FrameState::Loading;
+
+    Page *page = instance.frames_ + fid;
+    page->BeginFrameChange();
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    instance.replacer_->RecordAccess(fid, access_type);
+    instance.replacer_->SetEvictable(fid, false);
+
+    counters_.Add(BufferPoolCounter::Miss);
+
+    lock.unlock();
+    page->ResetMemory();
+    auto start = std::chrono::steady_clock::now();
+    auto future = ScheduleIo(false, page_id, page->data_);
+    bool read = WaitIo(&future);
+    counters_.AddTimed(BufferPoolCounter::DiskRead, BufferPoolCounter::DiskReadNs, start);
+    lock.lock();
+
+    if (!read) {
+      FailLoad(instance, fid);
+      if (io_failed != nullptr) {
+        *io_failed = true;
+      }
+      return nullptr;
+    }
+    page->EndFrameChange();
+    instance.frame_states_[fid] = FrameState::Resident;
+    instance.frame_cvs_[fid].notify_all();
+    return page;
+  }
+}
+
+auto BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) -> size_t {
+  std::vector<DiskRequest> requests;
+  for (auto page_id : page_ids) {
+    if (page_id == INVALID_PAGE_ID) {
+      continue;
+    }
+    auto &instance = InstanceOf(page_id);
+    std::unique_lock<std::mutex> lock(instance.latch_);
+    frame_id_t fid;
+    if (!IsPageUsed(page_id) || instance.page_table_.Find(page_id, &fid)) {
+      continue;
+    }
+    if (instance.free_list_.empty()) {
+      DrainAccesses(instance);
+      auto candidates = instance.replacer_->EvictionCandidates(1);
+      if (candidates.empty() || instance.frames_[candidates.front()].is_dirty_) {
+        continue;
       }
-      BUSTUB_ENSURE(!free_list_.empty(), "F1: free list size is 0")
     }
-    BUSTUB_ENSURE(!free_list_.empty(), "F2: free list size is 0")
-    fid = free_list_.front();
-    free_list_.pop_front();
+    if (!AcquireFrame(instance, lock, &fid)) {
+      continue;
+    }
+    frame_id_t other_fid;
+    if (instance.page_table_.Find(page_id, &other_fid)) {
+      // Another thread started loading the page while AcquireFrame had the latch released.
+      instance.free_list_.emplace_front(fid);
+      continue;
+    }
+
+    // The prefetch holds a pin until the read completes, exactly like a FetchPage that is loading the page.
+    instance.page_table_.Insert(page_id, fid);
+    instance.frame_states_[fid] = FrameState::Loading;
+    Page *page = instance.frames_ + fid;
+    page->BeginFrameChange();
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    page->ResetMemory();
+    instance.replacer_->RecordAccess(fid, AccessType::Prefetch);
+    instance.replacer_->SetEvictable(fid, false);
+    counters_.Add(BufferPoolCounter::Prefetch);
+
+    requests.push_back({false, page->data_, page_id, disk_scheduler_->CreatePromise(),
+                        [this, &instance, fid](bool success) { FinishPrefetch(instance, fid, success); }});
+  }
 
-    page_table_[page_id] = fid;
-    f2p_[fid] = page_id;
-    page_used_[page_id] = true;
+  size_t num_requests = requests.size();
+  disk_scheduler_->ScheduleBatch(std::move(requests));
+  return num_requests;
+}
 
-    pages_[fid].page_id_ = page_id;
-    pages_[fid].pin_count_ = 0;
-    pages_[fid].ResetMemory();
-    disk_manager_->ReadPage(page_id, pages_[fid].data_);
+void BufferPoolManager::FinishPrefetch(BufferPoolInstance &instance, frame_id_t frame_id, bool success) {
+  std::scoped_lock lock(instance.latch_);
+  if (!success) {
+    FailLoad(instance, frame_id);
+    return;
   }
-  fid = page_table_[page_id];
-  //  lock.unlock();
+  Page *page = instance.frames_ + frame_id;
+  page->pin_count_--;
+  page->EndFrameChange();
+  instance.frame_states_[frame_id] = FrameState::Resident;
+  instance.frame_cvs_[frame_id].notify_all();
+  instance.replacer_->SetEvictable(frame_id, page->pin_count_ == 0);
+}
 
-  pages_[fid].pin_count_++;
-  replacer_->RecordAccess(fid);
+void BufferPoolManager::FailLoad(BufferPoolInstance &instance, frame_id_t frame_id) {
+  Page *page = instance.frames_ + frame_id;
+  // The frame change begun by the read is never ended, so optimistic readers of the frame do not validate either.
+  instance.replacer_->SetEvictable(frame_id, true);
+  instance.replacer_->Remove(frame_id);
+  instance.page_table_.Erase(page->page_id_);
+  instance.frame_states_[frame_id] = FrameState::Failed;
+  instance.frame_cvs_[frame_id].notify_all();
+  ReleaseFailedPin(instance, frame_id);
+}
 
-  // 我草我终于知道了为啥了, unpin后如果这里fetch不增加pin后更改evictable, 就会一直可以被删除
-  replacer_->SetEvictable(fid, pages_[fid].pin_count_ == 0);
-  return pages_ + fid;
+void BufferPoolManager::ReleaseFailedPin(BufferPoolInstance &instance, frame_id_t frame_id) {
+  if (instance.frames_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    FreeFailedFrame(instance, frame_id);
+  }
+}
+
+void BufferPoolManager::FreeFailedFrame(BufferPoolInstance &instance, frame_id_t frame_id) {
+  Page *page = instance.frames_ + frame_id;
+  // A fetch that found the frame before it left the page table may still pin it for a moment, it then hands the frame
+  // back through DeferAccess().
+  if (instance.frame_states_[frame_id] != FrameState::Failed || !page->TryClaim()) {
+    return;
+  }
+  page->ResetMemory();
+  page->page_id_ = INVALID_PAGE_ID;
+  instance.frame_states_[frame_id] = FrameState::Free;
+  instance.free_list_.emplace_back(frame_id);
 }
 
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
+  auto &instance = InstanceOf(page_id);
+  frame_id_t fid;
+  // Whoever unpins the page holds a pin on it, so the frame cannot be switched to another page meanwhile.
+  if (instance.page_table_.Find(page_id, &fid) && instance.frames_[fid].GetPageId() == page_id) {
+    Page *page = instance.frames_ + fid;
+    int pin_count = page->pin_count_.load(std::memory_order_relaxed);
+    if (pin_count <= 0) {
+      return false;
+    }
+    // The dirty flag is set first, so that an eviction which claims the frame after the unpin sees it.
+    if (is_dirty) {
+      page->is_dirty_ = true;
+    }
+    while (pin_count > 0) {
+      if (page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1, std::memory_order_release)) {
+        if (pin_count == 1) {
+          DeferAccess(instance, {page_id, fid, AccessType::Unknown, false});
+        }
+        return true;
+      }
+    }
     return false;
   }
-  frame_id_t fid = page_table_[page_id];
-  //  lock.unlock();
 
-  if (pages_[fid].pin_count_ == 0) {
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  if (!instance.page_table_.Find(page_id, &fid)) {
     return false;
   }
-  pages_[fid].pin_count_ -= 1;
+  Page *page = instance.frames_ + fid;
+
+  if (page->pin_count_ <= 0) {
+    return false;
+  }
+  page->pin_count_ -= 1;
   if (is_dirty) {
-    pages_[fid].is_dirty_ = true;
+    page->is_dirty_ = true;
   }
-  replacer_->SetEvictable(fid, pages_[fid].pin_count_ == 0);
+  instance.replacer_->SetEvictable(fid, page->pin_count_ == 0);
   return true;
 }
 
 auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
-  return FlushPageUnlocked(page_id);
+  auto &instance = InstanceOf(page_id);
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  while (true) {
+    frame_id_t fid;
+    if (!instance.page_table_.Find(page_id, &fid)) {
+      return false;
+    }
+    Page *page = instance.frames_ + fid;
+    if (instance.frame_states_[fid] == FrameState::WritingBack) {
+      // The eviction is already writing the page, wait for it and look again.
+      counters_.Add(BufferPoolCounter::PinWait);
+      instance.frame_cvs_[fid].wait(lock, [&] { return instance.frame_states_[fid] != FrameState::WritingBack; });
+      continue;
+    }
+
+    // Pin the page so that it stays in its frame while we write it with the latch released. The dirty flag is cleared
+    // up front, so a modification reported during the write keeps the page dirty.
+    page->pin_count_++;
+    instance.replacer_->SetEvictable(fid, false);
+    instance.frame_cvs_[fid].wait(lock, [&] { return instance.frame_states_[fid] != FrameState::Loading; });
+    if (instance.frame_states_[fid] == FrameState::Failed) {
+      // The page could not be read, so there is nothing to flush.
+      ReleaseFailedPin(instance, fid);
+      return false;
+    }
+    page->is_dirty_ = false;
+
+    lock.unlock();
+    auto start = std::chrono::steady_clock::now();
+    auto future = ScheduleIo(true, page_id, page->data_);
+    bool written = WaitIo(&future);
+    counters_.AddTimed(BufferPoolCounter::DiskWrite, BufferPoolCounter::DiskWriteNs, start);
+    lock.lock();
+
+    if (!written) {
+      page->is_dirty_ = true;
+    }
+    page->pin_count_--;
+    instance.replacer_->SetEvictable(fid, page->pin_count_ == 0);
+    return written;
+  }
 }
 
 void BufferPoolManager::FlushAllPages() {
-  std::unique_lock<std::mutex> lock(latch_);
-  for (auto &it : page_table_) {
-    FlushPageUnlocked(it.first);
+  std::vector<WriteBackEntry> batch;
+  for (auto &instance : instances_) {
+    std::unique_lock<std::mutex> lock(instance->latch_);
+    for (size_t fid = 0; fid < instance->num_frames_; ++fid) {
+      // A page being written back by an eviction is only on disk once the eviction is done.
+      instance->frame_cvs_[fid].wait(lock, [&] { return instance->frame_states_[fid] != FrameState::WritingBack; });
+      PinForWriteBack(*instance, static_cast<frame_id_t>(fid), &batch);
+    }
+  }
+  WriteBackBatch(&batch, false);
+  free_space_map_.Flush(disk_manager_);
+}
+
+auto BufferPoolManager::PinForWriteBack(BufferPoolInstance &instance, frame_id_t frame_id,
+                                        std::vector<WriteBackEntry> *batch) -> bool {
+  if (instance.frame_states_[frame_id] != FrameState::Resident) {
+    // Free frames hold nothing, loading frames hold nothing valid yet, and frames being written back are handled by
+    // their eviction.
+    return false;
+  }
+  Page *page = instance.frames_ + frame_id;
+  page->pin_count_++;
+  instance.replacer_->SetEvictable(frame_id, false);
+  page->is_dirty_ = false;
+  batch->push_back({page->page_id_, &instance, frame_id});
+  return true;
+}
+
+auto BufferPoolManager::WriteBackBatch(std::vector<WriteBackEntry> *batch, bool background) -> bool {
+  // The whole batch is handed to the disk manager at once in page id order, e.g. as a single io_uring submission.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> futures;
+  requests.reserve(batch->size());
+  futures.reserve(batch->size());
+  for (const auto &entry : *batch) {
+    auto promise = disk_scheduler_->CreatePromise();
+    futures.push_back(promise.get_future());
+    requests.push_back({true, entry.instance_->frames_[entry.frame_id_].data_, entry.page_id_, std::move(promise)});
+  }
+  disk_scheduler_->ScheduleBatch(std::move(requests));
+  std::vector<bool> written;
+  written.reserve(batch->size());
+  for (auto &future : futures) {
+    written.push_back(WaitIo(&future));
+    counters_.AddTimed(BufferPoolCounter::DiskWrite, BufferPoolCounter::DiskWriteNs, start);
+    if (background && written.back()) {
+      counters_.Add(BufferPoolCounter::BackgroundWrite);
+    }
+  }
+  for (size_t i = 0; i < batch->size(); ++i) {
+    auto &instance = *(*batch)[i].instance_;
+    frame_id_t fid = (*batch)[i].frame_id_;
+    std::unique_lock<std::mutex> lock(instance.latch_);
+    Page *page = instance.frames_ + fid;
+    if (!written[i]) {
+      page->is_dirty_ = true;
+    }
+    page->pin_count_--;
+    instance.replacer_->SetEvictable(fid, page->pin_count_ == 0);
+  }
+  batch->clear();
+  return std::all_of(written.begin(), written.end(), [](bool w) { return w; });
+}
+
+void BufferPoolManager::StartBackgroundWriter(double clean_ratio) {
+  std::scoped_lock lock(writer_latch_);
+  if (writer_running_) {
+    return;
+  }
+  writer_running_ = true;
+  writer_stop_ = false;
+  writer_thread_ = std::thread(&BufferPoolManager::RunBackgroundWriter, this, clean_ratio);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::scoped_lock lock(writer_latch_);
+    if (!writer_running_) {
+      return;
+    }
+    writer_stop_ = true;
+  }
+  writer_cv_.notify_all();
+  writer_thread_.join();
+  std::scoped_lock lock(writer_latch_);
+  writer_running_ = false;
+}
+
+void BufferPoolManager::RunBackgroundWriter(double clean_ratio) {
+  std::vector<WriteBackEntry> batch;
+  std::unique_lock<std::mutex> writer_lock(writer_latch_);
+  while (!writer_stop_) {
+    writer_cv_.wait_for(writer_lock, background_writer_interval, [&] { return writer_stop_ || writer_wakeup_; });
+    if (writer_stop_) {
+      break;
+    }
+    writer_wakeup_ = false;
+    writer_lock.unlock();
+
+    for (auto &instance : instances_) {
+      std::unique_lock<std::mutex> lock(instance->latch_);
+      // Free frames are used before anything is evicted, the rest of the target must be met by the next victims.
+      auto target = static_cast<size_t>(clean_ratio * static_cast<double>(instance->num_frames_) + 0.5);
+      if (instance->free_list_.size() >= target) {
+        continue;
+      }
+      DrainAccesses(*instance);
+      for (auto fid : instance->replacer_->EvictionCandidates(target - instance->free_list_.size())) {
+        if (instance->frames_[fid].is_dirty_) {
+          PinForWriteBack(*instance, fid, &batch);
+        }
+      }
+    }
+    // Batches of different instances are merged, so that pages with consecutive ids are written one after another.
+    WriteBackBatch(&batch, true);
+
+    writer_lock.lock();
   }
 }
 
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
-  return DeletePageUnlocked(page_id);
+  auto &instance = InstanceOf(page_id);
+  std::unique_lock<std::mutex> lock(instance.latch_);
+  while (true) {
+    frame_id_t fid;
+    if (!instance.page_table_.Find(page_id, &fid)) {
+      DeallocatePage(instance, page_id);
+      return true;
+    }
+    Page *page = instance.frames_ + fid;
+    if (page->pin_count_ > 0) {
+      return false;
+    }
+    if (instance.frame_states_[fid] == FrameState::WritingBack) {
+      // The page is being evicted, wait for the eviction to finish and look again.
+      counters_.Add(BufferPoolCounter::PinWait);
+      instance.frame_cvs_[fid].wait(lock, [&] { return instance.frame_states_[fid] != FrameState::WritingBack; });
+      continue;
+    }
+    if (!page->TryClaim()) {
+      // The page was pinned by a fetch that did not take the latch.
+      return false;
+    }
+
+    page->BeginFrameChange();
+    page->ResetMemory();
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+
+    // The replacer may not have seen the last unpin yet.
+    instance.replacer_->SetEvictable(fid, true);
+    instance.replacer_->Remove(fid);
+    instance.page_table_.Erase(page_id);
+    instance.frame_states_[fid] = FrameState::Free;
+    instance.free_list_.emplace_back(fid);
+    DeallocatePage(instance, page_id);
+    return true;
+  }
 }
 
-auto BufferPoolManager::AllocatePage() -> page_id_t { return next_page_id_; }
+auto BufferPoolManager::TruncateFile() -> size_t {
+  // All instances are latched until the file is truncated, so that no page past the new end is allocated and written
+  // meanwhile. Frames only hold allocated pages, so none of them is cut off.
+  std::vector<std::unique_lock<std::mutex>> locks;
+  for (auto &instance : instances_) {
+    locks.emplace_back(instance->latch_);
+  }
+  page_id_t end = free_space_map_.GetEnd();
+  auto num_instances = static_cast<page_id_t>(instances_.size());
+  for (auto &instance : instances_) {
+    instance->free_pages_.erase(instance->free_pages_.lower_bound(end), instance->free_pages_.end());
+    // The first page id of the instance from end on.
+    auto instance_index = static_cast<page_id_t>(instance->instance_index_);
+    page_id_t first = end + (instance_index - end % num_instances + num_instances) % num_instances;
+    instance->next_page_id_ = std::min(instance->next_page_id_, first);
+  }
+  free_space_map_.Truncate(end);
+  disk_manager_->TruncatePages(end);
+  locks.clear();
 
-auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard { return {this, this->FetchPage(page_id)}; }
+  free_space_map_.Flush(disk_manager_);
+  return end;
+}
 
-auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
-  auto page = this->FetchPage(page_id);
-  page->RLatch();
-  return {this, page};
+auto BufferPoolManager::ScheduleIo(bool is_write, page_id_t page_id, char *data) -> std::future<bool> {
+  auto promise = disk_scheduler_->CreatePromise();
+  auto future = promise.get_future();
+  disk_scheduler_->Schedule({is_write, data, page_id, std::move(promise)});
+  return future;
 }
 
-auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
-  auto page = this->FetchPage(page_id);
-  page->WLatch();
-  return {this, page};
+auto BufferPoolManager::AllocatePage(BufferPoolInstance &instance, page_id_t hint, bool *reused) -> page_id_t {
+  page_id_t page_id;
+  auto &free_pages = instance.free_pages_;
+  *reused = !free_pages.empty();
+  if (*reused) {
+    // The free page id closest to the hint, or the lowest one.
+    auto it = free_pages.begin();
+    if (hint != INVALID_PAGE_ID) {
+      it = free_pages.lower_bound(hint);
+      if (it == free_pages.end() || (it != free_pages.begin() && hint - *std::prev(it) < *it - hint)) {
+        it = std::prev(it);
+      }
+    }
+    page_id = *it;
+    free_pages.erase(it);
+  } else {
+    // Every instance hands out the page ids that map back to itself, skipping the ones fetched before.
+    while (IsPageUsed(instance.next_page_id_)) {
+      instance.next_page_id_ += static_cast<page_id_t>(instances_.size());
+    }
+    page_id = instance.next_page_id_;
+    instance.next_page_id_ += static_cast<page_id_t>(instances_.size());
+  }
+  free_space_map_.SetAllocated(page_id, true);
+  return page_id;
 }
 
-auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard { return {this, this->NewPage(page_id)}; }
+void BufferPoolManager::DeallocatePage(BufferPoolInstance &instance, page_id_t page_id) {
+  // A page id past next_page_id_ was fetched but never allocated, and is handed out in order once it is reached.
+  if (free_space_map_.SetAllocated(page_id, false) && page_id < instance.next_page_id_) {
+    instance.free_pages_.insert(page_id);
+  }
+}
+
+void BufferPoolManager::MarkPageUsed(BufferPoolInstance &instance, page_id_t page_id) {
+  if (free_space_map_.SetAllocated(page_id, true)) {
+    instance.free_pages_.erase(page_id);
+  }
+}
 
-auto BufferPoolManager::FlushPageUnlocked(page_id_t page_id) -> bool {
-  if (page_table_.find(page_id) == page_table_.end()) {
+void BufferPoolManager::InitFreePages() {
+  page_id_t end = free_space_map_.GetEnd();
+  auto num_instances = static_cast<page_id_t>(instances_.size());
+  for (auto &instance : instances_) {
+    instance->free_pages_.clear();
+    auto page_id = static_cast<page_id_t>(instance->instance_index_);
+    for (; page_id < end; page_id += num_instances) {
+      if (!free_space_map_.IsAllocated(page_id)) {
+        instance->free_pages_.insert(page_id);
+      }
+    }
+    instance->next_page_id_ = page_id;
+  }
+}
+
+auto BufferPoolManager::TryPinResident(BufferPoolInstance &instance, frame_id_t frame_id, page_id_t page_id) -> bool {
+  Page *page = instance.frames_ + frame_id;
+  if (!page->TryPin()) {
     return false;
   }
-  frame_id_t fid = page_table_[page_id];
-  if (pages_[fid].is_dirty_) {
-    disk_manager_->WritePage(page_id, pages_[fid].data_);
-    pages_[fid].is_dirty_ = false;
+  // The frame may have been switched to another page since the lookup, or its page may not be readable yet.
+  if (page->GetPageId() == page_id && instance.frame_states_[frame_id] == FrameState::Resident) {
     return true;
   }
+  if (page->pin_count_.fetch_sub(1, std::memory_order_release) == 1) {
+    // An eviction may have skipped the frame because of our pin, let the replacer consider it again.
+    DeferAccess(instance, {page->GetPageId(), frame_id, AccessType::Unknown, false});
+  }
+  return false;
+}
+
+static auto AccessBufferIndex(size_t num_buffers) -> size_t {
+  static std::atomic<size_t> next_buffer{0};
+  thread_local size_t buffer = next_buffer.fetch_add(1, std::memory_order_relaxed);
+  return buffer % num_buffers;
+}
+
+void BufferPoolManager::DeferAccess(BufferPoolInstance &instance, const AccessEvent &event) {
+  auto &buffer = instance.access_buffers_[AccessBufferIndex(ACCESS_BUFFER_STRIPES)];
+  std::array<AccessEvent, ACCESS_BUFFER_SIZE> events;
+  {
+    std::scoped_lock buffer_lock(buffer.latch_);
+    buffer.events_[buffer.size_++] = event;
+    if (buffer.size_ < ACCESS_BUFFER_SIZE) {
+      return;
+    }
+    events = buffer.events_;
+    buffer.size_ = 0;
+  }
+  std::scoped_lock lock(instance.latch_);
+  ApplyAccesses(instance, events.data(), events.size());
+}
+
+void BufferPoolManager::ApplyAccesses(BufferPoolInstance &instance, const AccessEvent *events, size_t num_events) {
+  for (size_t i = 0; i < num_events; ++i) {
+    const auto &event = events[i];
+    Page *page = instance.frames_ + event.frame_id_;
+    if (instance.frame_states_[event.frame_id_] == FrameState::Failed && !event.is_access_) {
+      // The last pin of a frame whose read failed was released without the latch.
+      FreeFailedFrame(instance, event.frame_id_);
+      continue;
+    }
+    // Frames that are not resident are not tracked by the replacer, or are tracked by whoever is loading them.
+    if (instance.frame_states_[event.frame_id_] != FrameState::Resident || page->GetPageId() != event.page_id_) {
+      continue;
+    }
+    if (event.is_access_) {
+      instance.replacer_->RecordAccess(event.frame_id_, event.access_type_);
+    }
+    instance.replacer_->SetEvictable(event.frame_id_, page->pin_count_ == 0);
+  }
+}
+
+void BufferPoolManager::DrainAccesses(BufferPoolInstance &instance) {
+  std::array<AccessEvent, ACCESS_BUFFER_SIZE> events;
+  for (auto &buffer : instance.access_buffers_) {
+    size_t num_events;
+    {
+      std::scoped_lock buffer_lock(buffer.latch_);
+      num_events = buffer.size_;
+      std::copy(buffer.events_.begin(), buffer.events_.begin() + num_events, events.begin());
+      buffer.size_ = 0;
+    }
+    ApplyAccesses(instance, events.data(), num_events);
+  }
+}
+
+auto BufferPoolManager::AcquireFrame(BufferPoolInstance &instance, std::unique_lock<std::mutex> &lock,
+                                     frame_id_t *frame_id, bool *write_failed) -> bool {
+  size_t second_chances = 0;
+  while (instance.free_list_.empty()) {
+    // Frames pinned and unpinned without the latch may not be known to the replacer yet.
+    DrainAccesses(instance);
+    frame_id_t fid;
+    auto evict_start = std::chrono::steady_clock::now();
+    bool evicted = instance.replacer_->Evict(&fid);
+    counters_.AddTimed(BufferPoolCounter::ReplacerEvict, BufferPoolCounter::ReplacerEvictNs, evict_start);
+    if (!evicted) {
+      return false;
+    }
+    Page *victim = instance.frames_ + fid;
+    if (second_chances < instance.num_frames_ && victim->referenced_.exchange(false, std::memory_order_relaxed)) {
+      // The page was read through a swizzled reference, which the replacer did not see. Count that as an access and
+      // look for another victim.
+      ++second_chances;
+      instance.replacer_->RecordAccess(fid);
+      instance.replacer_->SetEvictable(fid, true);
+      continue;
+    }
+    page_id_t victim_id = victim->page_id_;
+    frame_id_t victim_fid;
+    BUSTUB_ENSURE(instance.page_table_.Find(victim_id, &victim_fid) && victim_fid == fid,
+                  "evict page not in page table")
+
+    // The frame is claimed before its dirty flag is read. Fetches that do not take the latch cannot pin a claimed
+    // frame, so no modification slips in between the check and the eviction.
+    if (!victim->TryClaim()) {
+      // The victim was fetched again by a fetch that did not take the latch. It stays resident, and we look for
+      // another frame.
+      instance.replacer_->RecordAccess(fid);
+      instance.replacer_->SetEvictable(fid, false);
+      continue;
+    }
+
+    if (victim->is_dirty_) {
+      // Write the victim back with the latch released and the claim held. The victim stays in the page table
+      // meanwhile, so a concurrent FetchPage of it takes over the claim as a pin and waits instead of reading a stale
+      // copy from disk.
+      instance.frame_states_[fid] = FrameState::WritingBack;
+      victim->is_dirty_ = false;
+      lock.unlock();
+      auto write_start = std::chrono::steady_clock::now();
+      auto future = ScheduleIo(true, victim_id, victim->data_);
+      bool written = WaitIo(&future);
+      counters_.AddTimed(BufferPoolCounter::DiskWrite, BufferPoolCounter::DiskWriteNs, write_start);
+      if (written) {
+        counters_.Add(BufferPoolCounter::DirtyWriteBack);
+      }
+      {
+        // The background writer is falling behind, make it run now.
+        std::scoped_lock writer_lock(writer_latch_);
+        writer_wakeup_ = true;
+      }
+      writer_cv_.notify_all();
+      lock.lock();
+
+      if (!written) {
+        // The victim stays resident and dirty, and whoever needed the frame gets none rather than losing the changes.
+        victim->is_dirty_ = true;
+        instance.frame_states_[fid] = FrameState::Resident;
+        instance.frame_cvs_[fid].notify_all();
+        int claimed = Page::CLAIMED;
+        victim->pin_count_.compare_exchange_strong(claimed, 0);
+        instance.replacer_->RecordAccess(fid);
+        instance.replacer_->SetEvictable(fid, victim->pin_count_ == 0);
+        if (write_failed != nullptr) {
+          *write_failed = true;
+        }
+        return false;
+      }
+      if (victim->pin_count_ != Page::CLAIMED) {
+        // The victim was fetched again during the write, which cancelled the eviction. It stays resident, and we look
+        // for another frame.
+        instance.frame_states_[fid] = FrameState::Resident;
+        instance.frame_cvs_[fid].notify_all();
+        instance.replacer_->RecordAccess(fid);
+        instance.replacer_->SetEvictable(fid, false);
+        continue;
+      }
+    }
+
+    counters_.Add(BufferPoolCounter::Eviction);
+    victim->BeginFrameChange();
+    victim->ResetMemory();
+    victim->page_id_ = INVALID_PAGE_ID;
+    instance.page_table_.Erase(victim_id);
+    instance.frame_states_[fid] = FrameState::Free;
+    instance.frame_cvs_[fid].notify_all();
+    instance.free_list_.emplace_back(fid);
+  }
+  *frame_id = instance.free_list_.front();
+  instance.free_list_.pop_front();
   return true;
 }
 
-auto BufferPoolManager::DeletePageUnlocked(page_id_t page_id) -> bool {
-  if (page_table_.find(page_id) == page_table_.end()) {
-    return true;
+auto BufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  return {this, this->FetchPage(page_id, access_type)};
+}
+
+auto BufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  auto page = this->FetchPage(page_id, access_type);
+  if (page == nullptr) {
+    throw Exception("cannot fetch page " + std::to_string(page_id));
   }
-  frame_id_t fid = page_table_[page_id];
-  if (pages_[fid].pin_count_ > 0) {
+  page->RLatch();
+  return {this, page};
+}
+
+auto BufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  auto page = this->FetchPage(page_id, access_type);
+  if (page == nullptr) {
+    throw Exception("cannot fetch page " + std::to_string(page_id));
+  }
+  page->WLatch();
+  return {this, page};
+}
+
+auto BufferPoolManager::WaitForFrame(int attempt, int retries) -> bool {
+  if (attempt >= retries) {
     return false;
   }
+  // A pin is usually released within a few yields. Past that, the threads holding them are waiting for the disk.
+  if (attempt < 64) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return true;
+}
 
-  FlushPageUnlocked(page_id);
+auto BufferPoolManager::FetchPageOptimistic(page_id_t page_id, AccessType access_type) -> OptimisticPageGuard {
+  return {this, this->FetchPage(page_id, access_type)};
+}
 
-  pages_[fid].ResetMemory();
-  pages_[fid].page_id_ = INVALID_PAGE_ID;
-  pages_[fid].pin_count_ = 0;
-  pages_[fid].is_dirty_ = false;
+auto BufferPoolManager::FetchPageSwizzled(page_id_t page_id, frame_id_t frame_id)
+    -> std::optional<OptimisticPageGuard> {
+  // The frame id comes from a reference that may be stale, or may have been taken from a larger pool.
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= pool_size_) {
+    return std::nullopt;
+  }
+  Page *page = pages_ + frame_id;
+  // The version is read first: if the frame is switched to another page after that, the guard will not validate.
+  uint64_t version = page->GetVersion();
+  if ((version & 1) != 0 || page->GetPageId() != page_id) {
+    return std::nullopt;
+  }
+  if (!page->referenced_.load(std::memory_order_relaxed)) {
+    page->referenced_.store(true, std::memory_order_relaxed);
+  }
+  counters_.Add(BufferPoolCounter::SwizzledHit);
+  return OptimisticPageGuard(this, page, page_id, version);
+}
 
-  replacer_->Remove(fid);
-  page_table_.erase(page_id);
-  f2p_.erase(fid);
-  free_list_.emplace_back(fid);
-  return true;
+auto BufferPoolManager::NewPageGuarded(page_id_t *page_id, page_id_t hint) -> BasicPageGuard {
+  return {this, this->NewPage(page_id, hint)};
 }
+
 }  // namespace bustub
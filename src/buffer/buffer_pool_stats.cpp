@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+auto BufferPoolStats::HitRatio() const -> double {
+  auto fetches = hits_ + misses_ + shared_reads_;
+  return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+}
+
+auto BufferPoolStats::ToItems() const -> std::vector<std::pair<std::string, std::string>> {
+  auto average_us = [](uint64_t total_ns, uint64_t count) {
+    return fmt::format("{:.3f}", count == 0 ? 0 : static_cast<double>(total_ns) / static_cast<double>(count) / 1000);
+  };
+  return {
+      {"hits", std::to_string(hits_)},
+      {"misses", std::to_string(misses_)},
+      {"shared_reads", std::to_string(shared_reads_)},
+      {"hit_ratio", fmt::format("{:.4f}", HitRatio())},
+      {"swizzled_hits", std::to_string(swizzled_hits_)},
+      {"evictions", std::to_string(evictions_)},
+      {"dirty_write_backs", std::to_string(dirty_write_backs_)},
+      {"background_writes", std::to_string(background_writes_)},
+      {"pin_waits", std::to_string(pin_waits_)},
+      {"prefetches", std::to_string(prefetches_)},
+      {"disk_reads", std::to_string(disk_reads_)},
+      {"disk_read_avg_us", average_us(disk_read_ns_, disk_reads_)},
+      {"disk_writes", std::to_string(disk_writes_)},
+      {"disk_write_avg_us", average_us(disk_write_ns_, disk_writes_)},
+      {"replacer_evicts", std::to_string(replacer_evicts_)},
+      {"replacer_evict_avg_us", average_us(replacer_evict_ns_, replacer_evicts_)},
+  };
+}
+
+auto BufferPoolCounters::StripeIndex() -> size_t {
+  static std::atomic<size_t> next_stripe{0};
+  thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+  return stripe;
+}
+
+auto BufferPoolCounters::Snapshot() const -> BufferPoolStats {
+  std::array<uint64_t, NUM_COUNTERS> sums{};
+  for (const auto &stripe : stripes_) {
+    for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+      sums[i] += stripe.values_[i].load(std::memory_order_relaxed);
+    }
+  }
+  auto sum = [&](BufferPoolCounter counter) { return sums[static_cast<size_t>(counter)]; };
+
+  BufferPoolStats stats;
+  stats.hits_ = sum(BufferPoolCounter::Hit);
+  stats.misses_ = sum(BufferPoolCounter::Miss);
+  stats.shared_reads_ = sum(BufferPoolCounter::SharedRead);
+  stats.swizzled_hits_ = sum(BufferPoolCounter::SwizzledHit);
+  stats.evictions_ = sum(BufferPoolCounter::Eviction);
+  stats.dirty_write_backs_ = sum(BufferPoolCounter::DirtyWriteBack);
+  stats.background_writes_ = sum(BufferPoolCounter::BackgroundWrite);
+  stats.pin_waits_ = sum(BufferPoolCounter::PinWait);
+  stats.prefetches_ = sum(BufferPoolCounter::Prefetch);
+  stats.disk_reads_ = sum(BufferPoolCounter::DiskRead);
+  stats.disk_read_ns_ = sum(BufferPoolCounter::DiskReadNs);
+  stats.disk_writes_ = sum(BufferPoolCounter::DiskWrite);
+  stats.disk_write_ns_ = sum(BufferPoolCounter::DiskWriteNs);
+  stats.replacer_evicts_ = sum(BufferPoolCounter::ReplacerEvict);
+  stats.replacer_evict_ns_ = sum(BufferPoolCounter::ReplacerEvictNs);
+  return stats;
+}
+
+void BufferPoolCounters::Reset() {
+  for (auto &stripe : stripes_) {
+    for (auto &value : stripe.values_) {
+      value.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.cpp
+//
+// Identification: src/buffer/clock_pro_replacer.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_pro_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ClockProReplacer::ClockProReplacer(size_t num_pages)
+    : is_tracked_(num_pages),
+      ref_bits_(num_pages),
+      is_evictable_(num_pages),
+      num_pages_(num_pages),
+      is_hot_(num_pages, false),
+      in_test_(num_pages, true),
+      // Keep at least a quarter of the frames cold.
+      max_hot_size_(num_pages - (num_pages + 3) / 4) {}
+
+auto ClockProReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lock(latch_);
+  // Each round, the cold hand either finds a victim, or clears reference bits and ends test periods. If every
+  // evictable frame is hot, the hot hand then demotes the ones that were not referenced, so three rounds always
+  // find a victim unless concurrent SetEvictable calls took all of them away.
+  for (size_t round = 0; round < 3 && evictable_size_.load() > 0; round++) {
+    for (size_t step = 0; step < num_pages_; step++) {
+      size_t fid = cold_hand_;
+      cold_hand_ = (cold_hand_ + 1) % num_pages_;
+      if (is_hot_[fid] || !is_evictable_[fid].load()) {
+        continue;
+      }
+      if (ref_bits_[fid].exchange(false)) {
+        if (in_test_[fid]) {
+          // Re-referenced during its test period, the frame has a small reuse distance.
+          is_hot_[fid] = true;
+          in_test_[fid] = false;
+          hot_size_++;
+          while (hot_size_ > max_hot_size_) {
+            RunHotHand();
+          }
+        } else {
+          in_test_[fid] = true;
+        }
+        continue;
+      }
+      bool expected = true;
+      if (is_evictable_[fid].compare_exchange_strong(expected, false)) {
+        evictable_size_--;
+        ResetFrame(fid);
+        *frame_id = static_cast<frame_id_t>(fid);
+        return true;
+      }
+    }
+    for (size_t step = 0; step < num_pages_ && hot_size_ > 0; step++) {
+      RunHotHand();
+    }
+  }
+  return false;
+}
+
+void ClockProReplacer::RunHotHand() {
+  size_t fid = hot_hand_;
+  hot_hand_ = (hot_hand_ + 1) % num_pages_;
+  if (!is_hot_[fid]) {
+    return;
+  }
+  if (!ref_bits_[fid].exchange(false)) {
+    is_hot_[fid] = false;
+    in_test_[fid] = false;
+    hot_size_--;
+  }
+}
+
+void ClockProReplacer::ResetFrame(size_t fid) {
+  if (is_hot_[fid]) {
+    hot_size_--;
+  }
+  is_hot_[fid] = false;
+  in_test_[fid] = true;
+  ref_bits_[fid].store(false);
+  is_tracked_[fid].store(false);
+}
+
+void ClockProReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  is_tracked_[frame_id].store(true);
+  if (access_type != AccessType::Scan) {
+    ref_bits_[frame_id].store(true);
+  }
+}
+
+void ClockProReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  if (!is_tracked_[frame_id].load()) {
+    return;
+  }
+  if (is_evictable_[frame_id].exchange(set_evictable) != set_evictable) {
+    if (set_evictable) {
+      evictable_size_++;
+    } else {
+      evictable_size_--;
+    }
+  }
+}
+
+void ClockProReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_pages_ || !is_tracked_[frame_id].load()) {
+    return;
+  }
+  BUSTUB_ENSURE(is_evictable_[frame_id].exchange(false), "frame_id is not evictable.")
+  evictable_size_--;
+  std::scoped_lock lock(latch_);
+  ResetFrame(frame_id);
+}
+
+auto ClockProReplacer::Size() -> size_t { return evictable_size_.load(); }
+
+auto ClockProReplacer::EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> {
+  std::scoped_lock lock(latch_);
+  // Unreferenced cold frames go first, then referenced cold frames that are not promoted, and hot frames last.
+  std::vector<frame_id_t> candidates;
+  for (int pass = 0; pass < 3; pass++) {
+    for (size_t step = 0; step < num_pages_ && candidates.size() < max_candidates; step++) {
+      size_t fid = (cold_hand_ + step) % num_pages_;
+      if (!is_evictable_[fid].load()) {
+        continue;
+      }
+      bool referenced = ref_bits_[fid].load();
+      bool take = false;
+      switch (pass) {
+        case 0:
+          take = !is_hot_[fid] && !referenced;
+          break;
+        case 1:
+          take = !is_hot_[fid] && referenced && !in_test_[fid];
+          break;
+        default:
+          take = is_hot_[fid] || (referenced && in_test_[fid]);
+      }
+      if (take) {
+        candidates.push_back(static_cast<frame_id_t>(fid));
+      }
+    }
+  }
+  return candidates;
+}
+
+}  // namespace bustub
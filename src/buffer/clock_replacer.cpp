@@ -12,18 +12,95 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <algorithm>
+
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : states_(num_pages), num_pages_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lock(latch_);
+  // Two full rotations clear every reference bit, so an evictable frame is found by then unless concurrent
+  // SetEvictable calls took all of them away.
+  for (size_t step = 0; step < 2 * num_pages_ + 1 && evictable_size_.load() > 0; step++) {
+    size_t fid = hand_;
+    hand_ = (hand_ + 1) % num_pages_;
+    uint8_t state = states_[fid].load();
+    if ((state & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((state & REFERENCED) != 0) {
+      states_[fid].fetch_and(static_cast<uint8_t>(~REFERENCED));
+      continue;
+    }
+    // Untracking the frame in the same CAS keeps a concurrent SetEvictable from making it evictable again.
+    if (states_[fid].compare_exchange_strong(state, 0)) {
+      evictable_size_--;
+      *frame_id = static_cast<frame_id_t>(fid);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  states_[frame_id].fetch_or(access_type == AccessType::Scan ? TRACKED : TRACKED | REFERENCED);
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  uint8_t state = states_[frame_id].load();
+  while ((state & TRACKED) != 0) {
+    auto desired = static_cast<uint8_t>(set_evictable ? state | EVICTABLE : state & ~EVICTABLE);
+    if (desired == state) {
+      return;
+    }
+    if (states_[frame_id].compare_exchange_weak(state, desired)) {
+      if (set_evictable) {
+        evictable_size_++;
+      } else {
+        evictable_size_--;
+      }
+      return;
+    }
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_pages_) {
+    return;
+  }
+  uint8_t state = states_[frame_id].load();
+  while ((state & TRACKED) != 0) {
+    BUSTUB_ENSURE((state & EVICTABLE) != 0, "frame_id is not evictable.")
+    if (states_[frame_id].compare_exchange_weak(state, 0)) {
+      evictable_size_--;
+      return;
+    }
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+auto ClockReplacer::Size() -> size_t { return std::max<int64_t>(evictable_size_.load(), 0); }
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> {
+  std::scoped_lock lock(latch_);
+  // The hand first takes the frames without reference bit in its way, then the ones whose bit it cleared on the way.
+  std::vector<frame_id_t> candidates;
+  for (bool referenced : {false, true}) {
+    for (size_t step = 0; step < num_pages_ && candidates.size() < max_candidates; step++) {
+      size_t fid = (hand_ + step) % num_pages_;
+      uint8_t state = states_[fid].load();
+      if ((state & EVICTABLE) != 0 && ((state & REFERENCED) != 0) == referenced) {
+        candidates.push_back(static_cast<frame_id_t>(fid));
+      }
+    }
+  }
+  return candidates;
+}
 
 }  // namespace bustub
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#define BUSTUB_HAS_MEMPOLICY
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#endif
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+/** @return the ids of the online NUMA nodes, parsed from a list like "0-1,3" */
+static auto OnlineNumaNodes() -> std::vector<int> {
+  std::vector<int> nodes;
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string range;
+  while (std::getline(online, range, ',')) {
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int node = first; node <= last; node++) {
+      nodes.push_back(node);
+    }
+  }
+  if (nodes.empty()) {
+    nodes.push_back(0);
+  }
+  return nodes;
+}
+
+FrameArena::FrameArena(size_t num_frames, size_t page_size, const FrameArenaOptions &options)
+    : num_frames_(num_frames), page_size_(page_size), frame_stride_(page_size + GUARD_SIZE) {
+  size_ = num_frames_ * frame_stride_;
+  if (options.huge_pages_) {
+    size_ = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  size_ = std::max(size_, static_cast<size_t>(BUSTUB_PAGE_ALIGNMENT));
+
+  void *base = MAP_FAILED;
+  if (options.huge_pages_) {
+    base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_tlb_ = base != MAP_FAILED;
+  }
+  if (base == MAP_FAILED) {
+    base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (base == MAP_FAILED) {
+    throw Exception(std::string("cannot map the frame arena: ") + strerror(errno));
+  }
+  base_ = static_cast<char *>(base);
+  if (options.huge_pages_ && !huge_tlb_ && madvise(base_, size_, MADV_HUGEPAGE) != 0) {
+    LOG_WARN("no huge pages available for the frame arena: %s", strerror(errno));
+  }
+
+  // The policy only affects pages that have not been touched yet, so it is applied before anything is written.
+  if (options.numa_policy_ != NumaPolicy::Default) {
+    if (ApplyNumaPolicy(options)) {
+      numa_policy_ = options.numa_policy_;
+    } else {
+      LOG_WARN("cannot apply the NUMA policy to the frame arena: %s", strerror(errno));
+    }
+  }
+
+#if defined(__SANITIZE_ADDRESS__)
+  for (size_t i = 0; i < num_frames_; i++) {
+    ASAN_POISON_MEMORY_REGION(FrameData(i) + page_size_, GUARD_SIZE);
+  }
+#endif
+}
+
+FrameArena::~FrameArena() {
+#if defined(__SANITIZE_ADDRESS__)
+  ASAN_UNPOISON_MEMORY_REGION(base_, size_);
+#endif
+  munmap(base_, size_);
+}
+
+auto FrameArena::ApplyNumaPolicy(const FrameArenaOptions &options) -> bool {
+#ifdef BUSTUB_HAS_MEMPOLICY
+  std::vector<int> nodes = OnlineNumaNodes();
+  if (options.numa_policy_ == NumaPolicy::Bind) {
+    if (std::find(nodes.begin(), nodes.end(), options.numa_node_) == nodes.end()) {
+      errno = EINVAL;
+      return false;
+    }
+    nodes = {options.numa_node_};
+  }
+  constexpr size_t BITS_PER_WORD = 8 * sizeof(unsigned long);  // NOLINT
+  std::vector<unsigned long> mask(nodes.back() / BITS_PER_WORD + 1, 0);  // NOLINT
+  for (int node : nodes) {
+    mask[node / BITS_PER_WORD] |= 1UL << (node % BITS_PER_WORD);
+  }
+  int mode = options.numa_policy_ == NumaPolicy::Bind ? MPOL_BIND : MPOL_INTERLEAVE;
+  return syscall(SYS_mbind, base_, size_, mode, mask.data(), mask.size() * BITS_PER_WORD + 1, 0) == 0;
+#else
+  errno = ENOSYS;
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/buffer/free_space_map.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_space_map.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(size_t page_size)
+    : page_size_(page_size),
+      pages_per_group_((page_size - sizeof(FsmPageHeader)) / 8 * 64),
+      groups_(static_cast<size_t>(std::numeric_limits<page_id_t>::max()) / pages_per_group_ + 1) {}
+
+FreeSpaceMap::~FreeSpaceMap() {
+  for (auto &group : groups_) {
+    delete group.load();
+  }
+}
+
+void FreeSpaceMap::Load(DiskManager *disk_manager) {
+  std::vector<char> page(page_size_);
+  std::scoped_lock lock(latch_);
+  size_t num_groups = 0;
+  while (num_groups < groups_.size()) {
+    disk_manager->ReadFreeSpaceMapPage(num_groups, page.data());
+    FsmPageHeader header;
+    memcpy(&header, page.data(), sizeof(header));
+    if (header.magic_ != FSM_MAGIC || header.group_ != num_groups || header.pages_per_group_ != pages_per_group_) {
+      break;
+    }
+    Grow(num_groups + 1);
+    Group *group = groups_[num_groups].load();
+    const char *bitmap = page.data() + sizeof(header);
+    for (size_t w = 0; w < pages_per_group_ / 64; w++) {
+      uint64_t word;
+      memcpy(&word, bitmap + w * sizeof(word), sizeof(word));
+      group->words_[w].store(word, std::memory_order_relaxed);
+    }
+    group->dirty_ = false;
+    num_groups++;
+  }
+  // The groups past the loaded ones are emptied, they may be added again later.
+  for (size_t i = num_groups; i < num_groups_; i++) {
+    Group *group = groups_[i].load();
+    for (size_t w = 0; w < pages_per_group_ / 64; w++) {
+      group->words_[w].store(0, std::memory_order_relaxed);
+    }
+  }
+  num_groups_ = num_groups;
+  dropped_begin_ = 0;
+  dropped_end_ = 0;
+}
+
+void FreeSpaceMap::Flush(DiskManager *disk_manager) {
+  // Flushes are serialized, so that a flush never overwrites a group with an older copy of another flush.
+  std::scoped_lock flush_lock(flush_latch_);
+  std::vector<std::pair<size_t, std::vector<char>>> pages;
+  {
+    std::scoped_lock lock(latch_);
+    // Dropped groups are zeroed first, a group that was added again after them is written afterwards.
+    for (size_t i = dropped_begin_; i < dropped_end_; i++) {
+      pages.emplace_back(i, std::vector<char>(page_size_, 0));
+    }
+    dropped_begin_ = 0;
+    dropped_end_ = 0;
+    for (size_t i = 0; i < num_groups_; i++) {
+      Group *group = groups_[i].load();
+      // The flag is cleared before the words are copied, so that a bit set meanwhile marks the group dirty again.
+      if (!group->dirty_.exchange(false)) {
+        continue;
+      }
+      std::vector<char> page(page_size_, 0);
+      FsmPageHeader header{FSM_MAGIC, static_cast<uint32_t>(i), static_cast<uint32_t>(pages_per_group_), 0};
+      memcpy(page.data(), &header, sizeof(header));
+      char *bitmap = page.data() + sizeof(header);
+      for (size_t w = 0; w < pages_per_group_ / 64; w++) {
+        uint64_t word = group->words_[w].load(std::memory_order_relaxed);
+        memcpy(bitmap + w * sizeof(word), &word, sizeof(word));
+      }
+      pages.emplace_back(i, std::move(page));
+    }
+  }
+  for (const auto &[index, page] : pages) {
+    disk_manager->WriteFreeSpaceMapPage(index, page.data());
+  }
+}
+
+void FreeSpaceMap::Grow(size_t num_groups) {
+  for (size_t i = num_groups_; i < num_groups; i++) {
+    // A new group is written by the next flush even if nothing in it is allocated, so that the groups on disk have no
+    // gaps. A group that was dropped before is empty already.
+    Group *group = groups_[i].load();
+    if (group == nullptr) {
+      groups_[i] = new Group(pages_per_group_ / 64);
+    } else {
+      group->dirty_ = true;
+    }
+  }
+  if (num_groups > num_groups_) {
+    num_groups_ = num_groups;
+  }
+}
+
+auto FreeSpaceMap::GroupOf(page_id_t page_id) -> Group & {
+  auto index = static_cast<size_t>(page_id) / pages_per_group_;
+  if (index >= num_groups_) {
+    std::scoped_lock lock(latch_);
+    Grow(index + 1);
+  }
+  return *groups_[index].load();
+}
+
+auto FreeSpaceMap::IsAllocated(page_id_t page_id) -> bool {
+  auto index = static_cast<size_t>(page_id) / pages_per_group_;
+  if (index >= num_groups_) {
+    return false;
+  }
+  auto bit = static_cast<size_t>(page_id) % pages_per_group_;
+  uint64_t word = groups_[index].load()->words_[bit / 64].load(std::memory_order_relaxed);
+  return ((word >> (bit % 64)) & 1) != 0;
+}
+
+auto FreeSpaceMap::SetAllocated(page_id_t page_id, bool allocated) -> bool {
+  auto &group = GroupOf(page_id);
+  auto bit = static_cast<size_t>(page_id) % pages_per_group_;
+  auto &word = group.words_[bit / 64];
+  uint64_t mask = uint64_t{1} << (bit % 64);
+  uint64_t old = allocated ? word.fetch_or(mask) : word.fetch_and(~mask);
+  if (((old & mask) != 0) == allocated) {
+    return false;
+  }
+  group.dirty_ = true;
+  return true;
+}
+
+auto FreeSpaceMap::GetEnd() -> page_id_t {
+  for (size_t i = num_groups_; i-- > 0;) {
+    const auto &words = groups_[i].load()->words_;
+    for (size_t w = pages_per_group_ / 64; w-- > 0;) {
+      uint64_t word = words[w].load(std::memory_order_relaxed);
+      if (word != 0) {
+        return static_cast<page_id_t>(i * pages_per_group_ + w * 64 + 64 - __builtin_clzll(word));
+      }
+    }
+  }
+  return 0;
+}
+
+void FreeSpaceMap::Truncate(page_id_t end) {
+  std::scoped_lock lock(latch_);
+  size_t num_groups = (static_cast<size_t>(end) + pages_per_group_ - 1) / pages_per_group_;
+  size_t old_num_groups = num_groups_;
+  if (num_groups >= old_num_groups) {
+    return;
+  }
+  for (size_t i = num_groups; i < old_num_groups; i++) {
+    const auto &words = groups_[i].load()->words_;
+    BUSTUB_ASSERT(std::all_of(words.get(), words.get() + pages_per_group_ / 64,
+                              [](const std::atomic<uint64_t> &w) { return w.load() == 0; }),
+                  "a truncated group must not hold allocated pages");
+  }
+  dropped_begin_ = dropped_end_ > dropped_begin_ ? std::min(dropped_begin_, num_groups) : num_groups;
+  dropped_end_ = std::max(dropped_end_, old_num_groups);
+  num_groups_ = num_groups;
+}
+
+}  // namespace bustub
@@ -13,6 +13,7 @@
 #include "buffer/lru_k_replacer.h"
 
 #include <memory>
+#include <utility>
 
 namespace bustub {
 
@@ -21,98 +22,155 @@ LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_fra
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::unique_lock<std::mutex> lock(this->latch_);
 
-  size_t early_time_stamp = INF;
-  size_t mx_k_distence = 0;
-  frame_id_t evict_id = -1;
-  for (const auto &i : node_store_) {
-    auto node = i.second;
-    if (!node->GetEvictable()) {
-      continue;
-    }
-    size_t now_k_distence = node->GetKDistence(this->current_timestamp_);
-    if (now_k_distence > mx_k_distence) {
-      mx_k_distence = now_k_distence;
-      early_time_stamp = node->GetEarlyTimestamp();
-      evict_id = i.first;
-    } else if (now_k_distence == mx_k_distence) {
-      size_t now_early_time_stamp = node->GetEarlyTimestamp();
-      if (early_time_stamp > now_early_time_stamp) {
-        early_time_stamp = now_early_time_stamp;
-        evict_id = i.first;
-      }
+  // Frames only used by scans go first, then frames read ahead of a scan. Then frames with +inf backward k-distance,
+  // in LRU order. Otherwise the frame whose k-th most recent access is the earliest has the largest backward
+  // k-distance.
+  EvictQueue *queue = nullptr;
+  for (EvictQueue *candidate : {&scan_queue_, &prefetch_queue_, &less_k_queue_, &k_queue_}) {
+    if (!candidate->empty()) {
+      queue = candidate;
+      break;
     }
   }
-  if (evict_id == -1) {
+  if (queue == nullptr) {
     return false;
   }
+  frame_id_t evict_id = queue->begin()->second;
+  queue->erase(queue->begin());
   *frame_id = evict_id;
   node_store_.erase(evict_id);
   this->evictable_size_--;
   return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id, [[maybe_unused]] AccessType access_type) {
+auto LRUKReplacer::EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> {
+  std::unique_lock<std::mutex> lock(this->latch_);
+  std::vector<frame_id_t> candidates;
+  for (EvictQueue *queue : {&scan_queue_, &prefetch_queue_, &less_k_queue_, &k_queue_}) {
+    for (auto it = queue->begin(); it != queue->end() && candidates.size() < max_candidates; ++it) {
+      candidates.push_back(it->second);
+    }
+  }
+  return candidates;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
   std::unique_lock<std::mutex> lock(this->latch_);
 
   this->current_timestamp_++;
   BUSTUB_ASSERT(frame_id >= 0 && (size_t)frame_id < replacer_size_, "frame_id is out of range.");
-  if (node_store_.find(frame_id) == node_store_.end()) {
-    node_store_[frame_id] = std::make_shared<LRUKNode>(frame_id, this->current_timestamp_, this->k_);
-  } else {
-    node_store_[frame_id]->RecordAccess(current_timestamp_);
+  auto it = node_store_.find(frame_id);
+  if (it == node_store_.end()) {
+    bool is_prefetch = access_type == AccessType::Prefetch;
+    auto &node = node_store_
+                     .emplace(frame_id, LRUKNode(frame_id, this->current_timestamp_, this->k_,
+                                                 access_type == AccessType::Scan || is_prefetch))
+                     .first->second;
+    node.SetPrefetch(is_prefetch);
+    return;
+  }
+  auto &node = it->second;
+  bool is_evictable = node.GetEvictable();
+  // The access changes the ordering key of the frame, and possibly the queue it belongs to.
+  if (is_evictable) {
+    Dequeue(node, frame_id);
+  }
+  if (access_type == AccessType::Prefetch) {
+    // A page that is already cached is not read ahead, treat it like a scan.
+    access_type = AccessType::Scan;
+  }
+  if (access_type != AccessType::Scan && node.IsScan()) {
+    node = LRUKNode(frame_id, current_timestamp_, this->k_);
+    node.SetEvictable(is_evictable);
+  } else if (access_type != AccessType::Scan || node.IsScan()) {
+    node.RecordAccess(current_timestamp_);
+    node.SetPrefetch(false);
+  }
+  if (is_evictable) {
+    Enqueue(node, frame_id);
   }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::unique_lock<std::mutex> lock(this->latch_);
 
-  auto now_frame = node_store_[frame_id];
-  if (now_frame->GetEvictable() != set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && (size_t)frame_id < replacer_size_, "frame_id is out of range.");
+  auto it = node_store_.find(frame_id);
+  if (it == node_store_.end()) {
+    return;
+  }
+  auto &node = it->second;
+  if (node.GetEvictable() != set_evictable) {
     if (set_evictable) {
       this->evictable_size_++;
+      Enqueue(node, frame_id);
     } else {
       this->evictable_size_--;
+      Dequeue(node, frame_id);
     }
-    now_frame->SetEvictable(set_evictable);
+    node.SetEvictable(set_evictable);
   }
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::unique_lock<std::mutex> lock(this->latch_);
-  if (node_store_.find(frame_id) == node_store_.end()) {
+  auto it = node_store_.find(frame_id);
+  if (it == node_store_.end()) {
     return;
   }
-  if (node_store_[frame_id]->GetEvictable()) {
+  auto &node = it->second;
+  if (node.GetEvictable()) {
     this->evictable_size_--;
-    node_store_.erase(frame_id);
+    QueueOf(node).erase(KeyOf(node, frame_id));
+    node_store_.erase(it);
   } else {
     BUSTUB_ENSURE(false, "frame_id is not evictable.")
   }
 }
 
+void LRUKReplacer::Enqueue(LRUKNode &node, frame_id_t frame_id) {
+  auto &entry = node.QueueEntry();
+  if (entry.empty()) {
+    QueueOf(node).emplace(KeyOf(node, frame_id));
+    return;
+  }
+  entry.value() = KeyOf(node, frame_id);
+  QueueOf(node).insert(std::move(entry));
+}
+
+void LRUKReplacer::Dequeue(LRUKNode &node, frame_id_t frame_id) {
+  node.QueueEntry() = QueueOf(node).extract(KeyOf(node, frame_id));
+}
+
 auto LRUKReplacer::Size() -> size_t {
   std::unique_lock<std::mutex> lock(this->latch_);
 
   return this->evictable_size_;
 }
 
-LRUKNode::LRUKNode(frame_id_t fid, size_t current_time_stamp, size_t k) : k_(k), fid_(fid) {
-  this->history_.push_front(current_time_stamp);
+LRUKNode::LRUKNode(frame_id_t fid, size_t current_time_stamp, size_t k, bool is_scan)
+    : history_(k), k_(k), fid_(fid), is_scan_(is_scan) {
+  this->RecordAccess(current_time_stamp);
 }
 void LRUKNode::SetEvictable(bool set_evictable) { this->is_evictable_ = set_evictable; }
 auto LRUKNode::GetEvictable() -> bool { return this->is_evictable_; }
 auto LRUKNode::GetKDistence(size_t current_time_stamp) -> size_t {
-  if (this->history_.size() < this->k_) {
+  if (!this->HasKAccesses()) {
     return INF;
   }
-  size_t k_tmp = 1;
-  auto it = this->history_.begin();
-  while (k_tmp < this->k_) {
-    k_tmp++;
-    it++;
+  return current_time_stamp - this->GetEarlyTimestamp();
+}
+auto LRUKNode::GetEarlyTimestamp() -> size_t { return this->history_[this->HasKAccesses() ? this->head_ : 0]; }
+auto LRUKNode::GetLateTimestamp() -> size_t { return this->history_[(this->head_ + this->k_ - 1) % this->k_]; }
+auto LRUKNode::IsScan() -> bool { return this->is_scan_; }
+auto LRUKNode::IsPrefetch() -> bool { return this->is_prefetch_; }
+void LRUKNode::SetPrefetch(bool is_prefetch) { this->is_prefetch_ = is_prefetch; }
+auto LRUKNode::HasKAccesses() -> bool { return this->size_ == this->k_; }
+void LRUKNode::RecordAccess(size_t current_time_stamp) {
+  this->history_[this->head_] = current_time_stamp;
+  this->head_ = (this->head_ + 1) % this->k_;
+  if (this->size_ < this->k_) {
+    this->size_++;
   }
-  return current_time_stamp - *it;
 }
-auto LRUKNode::GetEarlyTimestamp() -> size_t { return this->history_.back(); }
-void LRUKNode::RecordAccess(size_t current_time_stamp) { this->history_.push_front(current_time_stamp); }
 }  // namespace bustub
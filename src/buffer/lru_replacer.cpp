@@ -12,18 +12,88 @@
 
 #include "buffer/lru_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : is_evictable_(num_pages, false), num_pages_(num_pages) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
-auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto LRUReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lock(latch_);
+  if (evictable_size_ == 0) {
+    return false;
+  }
+  // Pinned frames are usually few, so walking past them from the least recently used end is cheap.
+  auto it = std::prev(lru_list_.end());
+  while (!is_evictable_[*it]) {
+    --it;
+  }
+  *frame_id = *it;
+  lru_map_.erase(*it);
+  lru_list_.erase(it);
+  is_evictable_[*frame_id] = false;
+  evictable_size_--;
+  return true;
+}
+
+void LRUReplacer::RecordAccess(frame_id_t frame_id, [[maybe_unused]] AccessType access_type) {
+  std::scoped_lock lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  auto it = lru_map_.find(frame_id);
+  if (it != lru_map_.end()) {
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  } else {
+    lru_list_.push_front(frame_id);
+    lru_map_[frame_id] = lru_list_.begin();
+  }
+}
+
+void LRUReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < num_pages_, "frame_id is out of range.");
+  if (lru_map_.find(frame_id) == lru_map_.end() || is_evictable_[frame_id] == set_evictable) {
+    return;
+  }
+  is_evictable_[frame_id] = set_evictable;
+  if (set_evictable) {
+    evictable_size_++;
+  } else {
+    evictable_size_--;
+  }
+}
 
-void LRUReplacer::Pin(frame_id_t frame_id) {}
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_pages_) {
+    return;
+  }
+  auto it = lru_map_.find(frame_id);
+  if (it == lru_map_.end()) {
+    return;
+  }
+  BUSTUB_ENSURE(is_evictable_[frame_id], "frame_id is not evictable.")
+  lru_list_.erase(it->second);
+  lru_map_.erase(it);
+  is_evictable_[frame_id] = false;
+  evictable_size_--;
+}
 
-void LRUReplacer::Unpin(frame_id_t frame_id) {}
+auto LRUReplacer::Size() -> size_t {
+  std::scoped_lock lock(latch_);
+  return evictable_size_;
+}
 
-auto LRUReplacer::Size() -> size_t { return 0; }
+auto LRUReplacer::EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> {
+  std::scoped_lock lock(latch_);
+  std::vector<frame_id_t> candidates;
+  for (auto it = lru_list_.rbegin(); it != lru_list_.rend() && candidates.size() < max_candidates; ++it) {
+    if (is_evictable_[*it]) {
+      candidates.push_back(*it);
+    }
+  }
+  return candidates;
+}
 
 }  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t max_entries) {
+  // Keep the table at most half full, so that probe sequences stay within one or two buckets.
+  size_t num_buckets = 2;
+  size_t bucket_bits = 1;
+  while (num_buckets * SLOTS_PER_BUCKET < 2 * max_entries) {
+    num_buckets *= 2;
+    bucket_bits++;
+  }
+  buckets_ = std::make_unique<Bucket[]>(num_buckets);
+  for (size_t i = 0; i < num_buckets; ++i) {
+    for (auto &slot : buckets_[i].slots_) {
+      slot.store(EMPTY, std::memory_order_relaxed);
+    }
+  }
+  slot_mask_ = num_buckets * SLOTS_PER_BUCKET - 1;
+  bucket_shift_ = 64 - bucket_bits;
+}
+
+auto PageTable::Probe(page_id_t page_id) const -> size_t {
+  size_t slot = HomeSlot(page_id);
+  while (true) {
+    uint64_t entry = SlotAt(slot).load(std::memory_order_relaxed);
+    if (entry == EMPTY || KeyOf(entry) == page_id) {
+      return slot;
+    }
+    slot = (slot + 1) & slot_mask_;
+  }
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  size_t slot = Probe(page_id);
+  if (SlotAt(slot).load(std::memory_order_relaxed) == EMPTY) {
+    BUSTUB_ENSURE(2 * (size_ + 1) <= Capacity(), "page table is full");
+    size_++;
+  }
+  SlotAt(slot).store(MakeEntry(page_id, frame_id), std::memory_order_release);
+}
+
+auto PageTable::Erase(page_id_t page_id) -> bool {
+  size_t hole = Probe(page_id);
+  if (SlotAt(hole).load(std::memory_order_relaxed) == EMPTY) {
+    return false;
+  }
+  size_--;
+  // Fill the hole with the next entry of the cluster that may live there, i.e. whose home slot is not between the
+  // hole and the entry, then continue with the hole that entry leaves behind. The hole is only emptied at the very
+  // end, so a concurrent lookup never stops early at it, though it may miss an entry while it is moved back.
+  for (size_t slot = (hole + 1) & slot_mask_;; slot = (slot + 1) & slot_mask_) {
+    uint64_t entry = SlotAt(slot).load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      SlotAt(hole).store(EMPTY, std::memory_order_release);
+      return true;
+    }
+    size_t home = HomeSlot(KeyOf(entry));
+    bool stays = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+    if (!stays) {
+      SlotAt(hole).store(entry, std::memory_order_release);
+      hole = slot;
+    }
+  }
+}
+
+}  // namespace bustub
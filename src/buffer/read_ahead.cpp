@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.cpp
+//
+// Identification: src/buffer/read_ahead.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+SequentialReadAhead::SequentialReadAhead(BufferPoolManager *bpm, size_t window)
+    : bpm_(bpm), window_(std::min(window, bpm->GetPoolSize() / 4)) {}
+
+void SequentialReadAhead::Access(page_id_t page_id) {
+  if (window_ == 0 || page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  if (last_page_id_ != INVALID_PAGE_ID && stride_ > 0 && page_id - last_page_id_ == stride_) {
+    steps_++;
+  } else {
+    // The scan jumped, start over with the new stride. Nothing prefetched so far is reused.
+    stride_ = last_page_id_ == INVALID_PAGE_ID ? 0 : page_id - last_page_id_;
+    steps_ = 1;
+    prefetched_until_ = page_id;
+  }
+  last_page_id_ = page_id;
+  if (stride_ <= 0 || steps_ < SEQUENTIAL_STEPS) {
+    return;
+  }
+
+  prefetched_until_ = std::max(prefetched_until_, page_id);
+  auto in_flight = static_cast<size_t>((prefetched_until_ - page_id) / stride_);
+  if (in_flight > window_ / 2) {
+    return;
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t i = in_flight + 1; i <= window_; i++) {
+    page_ids.push_back(page_id + static_cast<page_id_t>(i) * stride_);
+  }
+  bpm_->PrefetchPages(page_ids);
+  prefetched_until_ = page_ids.back();
+}
+
+}  // namespace bustub
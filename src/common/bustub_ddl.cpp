@@ -127,6 +127,24 @@ void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainState
 
 void BustubInstance::HandleVariableShowStatement(Transaction *txn, const VariableShowStatement &stmt,
                                                  ResultWriter &writer) {
+  if (StringUtil::Lower(stmt.variable_) == "buffer_pool_stats") {
+    if (buffer_pool_manager_ == nullptr) {
+      throw bustub::Exception("No buffer pool to show the stats of");
+    }
+    writer.BeginTable(false);
+    writer.BeginHeader();
+    writer.WriteHeaderCell("name");
+    writer.WriteHeaderCell("value");
+    writer.EndHeader();
+    for (const auto &[name, value] : buffer_pool_manager_->GetStats().ToItems()) {
+      writer.BeginRow();
+      writer.WriteCell(name);
+      writer.WriteCell(value);
+      writer.EndRow();
+    }
+    writer.EndTable();
+    return;
+  }
   auto content = GetSessionVariable(stmt.variable_);
   WriteOneCell(fmt::format("{}={}", stmt.variable_, content), writer);
 }
@@ -12,15 +12,27 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <optional>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
 
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/frame_arena.h"
+#include "buffer/free_space_map.h"
 #include "buffer/lru_k_replacer.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/page/page.h"
 #include "storage/page/page_guard.h"
 
@@ -28,6 +40,26 @@ namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The frames can be split into several independent buffer pool instances. Each instance owns a slice of the frames
+ * together with its own page table, free list, replacer and latch, and a page is always cached by the instance
+ * `page_id % num_instances`. Operations on pages that map to different instances never contend on the same latch.
+ *
+ * Disk I/O goes through a DiskScheduler and is never performed while holding the latch of an instance. Instead, every
+ * frame goes through a small state machine (see FrameState), and threads that need a frame which is being loaded or
+ * written back wait on a condition variable of that frame only.
+ *
+ * Fetching and unpinning a resident page takes no latch at all: the page is found by a lock-free lookup in the
+ * PageTable, the frame is pinned by incrementing its atomic pin count, and the access is buffered and handed to the
+ * replacer in batches (see DeferAccess()). A frame is claimed before it is switched to another page, which makes such
+ * a pin fail, and a pin that made it first keeps the frame from being claimed.
+ *
+ * An optional background writer keeps a fraction of the frames of every instance clean, so that evictions rarely have
+ * to write a dirty victim back on the critical path of a fetch.
+ *
+ * Which page ids are allocated is recorded in a FreeSpaceMap that is loaded from the disk manager on construction and
+ * written back by FlushAllPages(). Deleted pages are handed out again by NewPage, and TruncateFile() shrinks the
+ * database file after the last allocated page.
  */
 class BufferPoolManager {
  public:
@@ -37,9 +69,15 @@ class BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the LookBack constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param num_instances the number of independent buffer pool instances the frames are partitioned into
+   * @param replacer_type the replacement policy of every instance, replacer_k is only used by ReplacerType::LRUK
+   * @param arena_options huge page and NUMA options of the memory holding the page data of the frames
+   * @param num_disk_workers the number of threads of the disk scheduler issuing the reads and writes of the pool
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                    LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr, size_t num_instances = BUFFER_POOL_INSTANCES,
+                    ReplacerType replacer_type = ReplacerType::LRUK, const FrameArenaOptions &arena_options = {},
+                    size_t num_disk_workers = DISK_SCHEDULER_WORKERS);
 
   /**
    * @brief Destroy an existing BufferPoolManager.
@@ -49,9 +87,24 @@ class BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t { return pool_size_; }
 
+  /** @brief Return the size of a page, as chosen by the database file of the disk manager. */
+  auto GetPageSize() const -> size_t { return arena_->GetPageSize(); }
+
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @brief Return the memory holding the page data of all frames. */
+  auto GetFrameArena() const -> const FrameArena & { return *arena_; }
+
+  /** @brief Return the number of buffer pool instances the frames are partitioned into. */
+  auto GetNumInstances() -> size_t { return instances_.size(); }
+
+  /** @brief Return a snapshot of the hit/miss/eviction and I/O counters of the buffer pool. */
+  auto GetStats() const -> BufferPoolStats { return counters_.Snapshot(); }
+
+  /** @brief Reset all counters returned by GetStats() to zero. */
+  void ResetStats() { counters_.Reset(); }
+
   /**
    * TODO(P1): Add implementation
    *
@@ -66,10 +119,16 @@ class BufferPoolManager {
    * so that the replacer wouldn't evict the frame before the buffer pool manager "Unpin"s it.
    * Also, remember to record the access history of the frame in the replacer for the lru-k algorithm to work.
    *
+   * A page id freed by DeletePage() is reused before the file is grown: the free page id of the instance of hint that
+   * is closest to hint. Without a hint, the lowest free page id of an instance is reused, which keeps the file compact.
+   *
    * @param[out] page_id id of created page
+   * @param hint a page the new page will be accessed together with, e.g. the page that is split, or INVALID_PAGE_ID
+   * @param[out] io_failed if not null, set to whether nullptr is returned because the disk failed to write back the
+   * page of a frame, rather than because all frames are pinned
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPage(page_id_t *page_id) -> Page *;
+  auto NewPage(page_id_t *page_id, page_id_t hint = INVALID_PAGE_ID, bool *io_failed = nullptr) -> Page *;
 
   /**
    * TODO(P1): Add implementation
@@ -81,9 +140,10 @@ class BufferPoolManager {
    * BasicPageGuard structure.
    *
    * @param[out] page_id, the id of the new page
+   * @param hint a page the new page will be accessed together with, see NewPage()
    * @return BasicPageGuard holding a new page
    */
-  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+  auto NewPageGuarded(page_id_t *page_id, page_id_t hint = INVALID_PAGE_ID) -> BasicPageGuard;
 
   /**
    * TODO(P1): Add implementation
@@ -99,10 +159,23 @@ class BufferPoolManager {
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPage().
    *
    * @param page_id id of page to be fetched
-   * @param access_type type of access to the page, only needed for leaderboard tests.
-   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   * @param access_type type of access to the page. Pages fetched by AccessType::Scan are evicted first, so that
+   * sequential scans do not flush the working set out of the buffer pool.
+   * @param[out] io_failed if not null, set to whether nullptr is returned because the disk failed to read the page or
+   * to write back the page it would replace, rather than because all frames are pinned
+   * @return nullptr if page_id cannot be fetched, e.g. because the disk failed to read it or to write back the page
+   * it would replace, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown, bool *io_failed = nullptr)
+      -> Page *;
+
+  /**
+   * @brief Wait before retrying a FetchPage() or NewPage() that failed because all frames were pinned, so that the
+   * threads holding the pins get to release them: yield at first, then sleep.
+   * @param attempt the number of retries so far
+   * @return false once attempt reached retries, then the caller should give up
    */
-  auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
+  static auto WaitForFrame(int attempt, int retries = FRAME_WAIT_RETRIES) -> bool;
 
   /**
    * TODO(P1): Add implementation
@@ -115,11 +188,60 @@ class BufferPoolManager {
    * the returned page already has a read or write latch held, respectively.
    *
    * @param page_id, the id of the page to fetch
-   * @return PageGuard holding the fetched page
+   * @param access_type type of access to the page, see FetchPage()
+   * @return PageGuard holding the fetched page. The guard of FetchPageBasic holds no page where FetchPage returns
+   * nullptr.
+   * @throws Exception from FetchPageRead and FetchPageWrite where FetchPage returns nullptr, as there is no page to
+   * latch
+   */
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Fetch a page and pin it without latching it, for readers that validate what they read against the version
+   * of the page. The guard does not wait for a writer that holds the latch, see OptimisticPageGuard::IsLatched().
+   *
+   * @param page_id, the id of the page to fetch
+   * @param access_type type of access to the page, see FetchPage()
+   * @return OptimisticPageGuard holding the fetched page
+   */
+  auto FetchPageOptimistic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> OptimisticPageGuard;
+
+  /**
+   * @brief Read a page through a swizzled reference: frame_id is the frame the page was found in before, and the page
+   * is read from there without looking it up in the page table and without pinning it. This takes no latch at all.
+   *
+   * The frame may be switched to another page at any time, but that changes the version of the frame, so the returned
+   * guard then fails to validate, just like after a concurrent modification. An eviction thus unswizzles every
+   * reference to the page without having to find them. Pages read this way are marked referenced, and the eviction
+   * gives them a second chance, since the replacer does not see these accesses.
+   *
+   * @param page_id the id of the page to read
+   * @param frame_id the frame that held the page, see GetFrameId()
+   * @return an unpinned OptimisticPageGuard, or std::nullopt if the frame does not hold the page (anymore) or is not a
+   * frame of this buffer pool
+   */
+  auto FetchPageSwizzled(page_id_t page_id, frame_id_t frame_id) -> std::optional<OptimisticPageGuard>;
+
+  /** @brief Return the frame that holds a pinned page, to swizzle references to it. See FetchPageSwizzled(). */
+  auto GetFrameId(const Page *page) const -> frame_id_t { return static_cast<frame_id_t>(page - pages_); }
+
+  /**
+   * @brief Start reading pages into the buffer pool without pinning them, so that a later FetchPage finds them
+   * resident or already being loaded. The reads are scheduled as one disk scheduler batch and not waited for.
+   *
+   * Pages that are already cached, or that were never allocated or fetched through this buffer pool, are skipped. A
+   * prefetch never writes back a dirty page to make room, a page is skipped if its instance has no free or clean frame
+   * to spare.
+   *
+   * The frames are recorded in the replacer with AccessType::Prefetch, so that the replacer can keep them until they
+   * are fetched.
+   *
+   * @param page_ids the pages to read
+   * @return the number of pages whose read was scheduled
    */
-  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
-  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
-  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+  auto PrefetchPages(const std::vector<page_id_t> &page_ids) -> size_t;
 
   /**
    * TODO(P1): Add implementation
@@ -146,7 +268,7 @@ class BufferPoolManager {
    * Unset the dirty flag of the page after flushing.
    *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
-   * @return false if the page could not be found in the page table, true otherwise
+   * @return false if the page could not be found in the page table or could not be written, true otherwise
    */
   auto FlushPage(page_id_t page_id) -> bool;
 
@@ -154,9 +276,24 @@ class BufferPoolManager {
    * TODO(P1): Add implementation
    *
    * @brief Flush all the pages in the buffer pool to disk.
+   *
+   * The pages are written as one batch in page id order, so that the writes are sequential on disk. The changes of the
+   * free space map are written afterwards.
    */
   void FlushAllPages();
 
+  /**
+   * @brief Start the background writer thread. Every background_writer_interval, and whenever an eviction had to write
+   * a dirty victim, it asks the replacer of every instance for its next victims and writes back the dirty ones, so
+   * that the next clean_ratio of the frames of the instance to be handed out are free or clean. Does nothing if the
+   * writer is already running.
+   * @param clean_ratio the fraction of frames to keep clean
+   */
+  void StartBackgroundWriter(double clean_ratio = BACKGROUND_WRITER_CLEAN_RATIO);
+
+  /** @brief Stop the background writer thread and wait for it to exit. */
+  void StopBackgroundWriter();
+
   /**
    * TODO(P1): Add implementation
    *
@@ -167,51 +304,260 @@ class BufferPoolManager {
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
    * imitate freeing the page on the disk.
    *
+   * The page id is freed for reuse by NewPage() in either case.
+   *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Shrink the database file after its last allocated page, and write the free space map. Pages are not moved,
+   * so the file only shrinks once the pages at its end are freed; NewPage() reuses the lowest free page ids first to
+   * help with that. All instances are latched while the file is truncated.
+   *
+   * @return the number of pages the file is truncated to
+   */
+  auto TruncateFile() -> size_t;
+
  private:
+  /** The state of a frame, changed with the latch of the instance owning the frame held. */
+  enum class FrameState {
+    /** The frame holds no page and is on the free list. */
+    Free = 0,
+    /** The frame is pinned by a thread reading its page from disk, the page data is not valid yet. */
+    Loading,
+    /** The frame holds a valid page. */
+    Resident,
+    /** The frame has been chosen as an eviction victim and its dirty page is being written to disk. */
+    WritingBack,
+    /**
+     * The read of the page failed while other threads had pinned the frame to share it. The frame is not in the page
+     * table anymore and its data is never handed out, it is freed once the last of these pins is released.
+     */
+    Failed
+  };
+
+  /** An access or unpin of a frame that the replacer has not seen yet. */
+  struct AccessEvent {
+    /** The page the frame held, the event is dropped if the frame holds another page once it is applied. */
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    AccessType access_type_;
+    /** True for an access, false if the frame was unpinned to a pin count of 0. */
+    bool is_access_;
+  };
+
+  /** Number of access buffers of an instance, threads are assigned one round-robin. */
+  static constexpr size_t ACCESS_BUFFER_STRIPES = 16;
+  /** Number of events an access buffer collects before they are applied to the replacer. */
+  static constexpr size_t ACCESS_BUFFER_SIZE = 64;
+
+  /**
+   * AccessBuffer collects the events of the threads assigned to it, so that the replacer, which is guarded by the latch
+   * of the instance, is updated once per ACCESS_BUFFER_SIZE events instead of once per fetch.
+   */
+  struct alignas(64) AccessBuffer {
+    std::mutex latch_;
+    size_t size_{0};
+    std::array<AccessEvent, ACCESS_BUFFER_SIZE> events_;
+  };
+
+  /**
+   * A BufferPoolInstance manages a contiguous slice of the frames. Frame ids inside an instance are local, i.e.
+   * frame `fid` of the instance is `frames_[fid]`.
+   */
+  struct BufferPoolInstance {
+    BufferPoolInstance(size_t instance_index, Page *frames, size_t num_frames, size_t replacer_k,
+                       ReplacerType replacer_type);
+
+    /** Index of this instance, every page cached here satisfies `page_id % num_instances == instance_index_`. */
+    const size_t instance_index_;
+    /** First frame of the slice owned by this instance. */
+    Page *frames_;
+    /** Number of frames owned by this instance. */
+    const size_t num_frames_;
+    /** The page id this instance hands out once it has no free page id left, larger than all of them. */
+    page_id_t next_page_id_;
+    /** Page table for keeping track of the pages cached by this instance, read without the latch. */
+    PageTable page_table_;
+    /** Replacer to find unpinned frames of this instance for replacement. */
+    std::unique_ptr<Replacer> replacer_;
+    /** List of free frames that don't have any pages on them. */
+    std::list<frame_id_t> free_list_;
+    /** Page ids of this instance below next_page_id_ that are not allocated, see FreeSpaceMap. */
+    std::set<page_id_t> free_pages_;
+    /** State of each frame of this instance, read without the latch by fetches of resident pages. */
+    std::vector<std::atomic<FrameState>> frame_states_;
+    /** Signalled whenever the corresponding frame leaves the Loading or WritingBack state. */
+    std::vector<std::condition_variable> frame_cvs_;
+    /** Accesses and unpins of frames that did not take the latch, not seen by the replacer yet. */
+    std::array<AccessBuffer, ACCESS_BUFFER_STRIPES> access_buffers_;
+    /**
+     * Protects free_list_, free_pages_, next_page_id_, the replacer, and all changes of the page table, the frame
+     * states and the frame metadata.
+     */
+    std::mutex latch_;
+  };
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
+  /** The instance NewPage tries first, advanced round-robin to spread new pages over the instances. */
+  std::atomic<size_t> next_instance_ = 0;
 
-  /** Array of buffer pool pages. */
+  /** The page data of all frames, frame i holds arena_->FrameData(i). */
+  std::unique_ptr<FrameArena> arena_;
+  /** Array of buffer pool pages, i.e. the metadata of the frames. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
+  /** Pointer to the disk scheduler, all reads and writes of pages go through it. */
+  std::unique_ptr<DiskScheduler> disk_scheduler_;
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUKReplacer> replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  /** Protects page_table_, free_list_, and f2p_ */
-  std::mutex latch_;
-
-  /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+  /** The independent buffer pool instances, each owning a slice of pages_. */
+  std::vector<std::unique_ptr<BufferPoolInstance>> instances_;
+  /** Event counters shared by all instances, striped per thread so that bumping them never contends. */
+  BufferPoolCounters counters_;
+  /**
+   * The allocated page ids of all instances. Changed with the latch of the instance of the page held, and read and
+   * written by the disk manager directly rather than through the disk scheduler, as it is not made of database pages.
+   */
+  FreeSpaceMap free_space_map_;
+
+  /** Protects the state of the background writer below. */
+  std::mutex writer_latch_;
+  /** Signalled to stop the background writer, or to make it run before its interval elapses. */
+  std::condition_variable writer_cv_;
+  std::thread writer_thread_;
+  bool writer_running_{false};
+  bool writer_stop_{false};
+  bool writer_wakeup_{false};
+
+  /** A page pinned to be written back, see PinForWriteBack(). */
+  struct WriteBackEntry {
+    page_id_t page_id_;
+    BufferPoolInstance *instance_;
+    frame_id_t frame_id_;
+  };
+
+  /** @return the instance responsible for caching page_id */
+  auto InstanceOf(page_id_t page_id) -> BufferPoolInstance & {
+    return *instances_[static_cast<size_t>(page_id) % instances_.size()];
+  }
+
+  /**
+   * @brief Allocate a page on disk, reusing a free page id near hint if there is one, see NewPage(). Caller should
+   * acquire the latch of the instance before calling this function.
+   * @param[out] reused true if the page id was freed before, so the page on disk holds stale data
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(BufferPoolInstance &instance, page_id_t hint, bool *reused) -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Deallocate a page on disk, so that AllocatePage() can hand it out again. Caller should acquire the latch of
+   * the instance before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(BufferPoolInstance &instance, page_id_t page_id);
+
+  /** @return true if page_id has been handed out or fetched, and not deleted since */
+  auto IsPageUsed(page_id_t page_id) -> bool { return free_space_map_.IsAllocated(page_id); }
+
+  /** @brief Record that page_id has been handed out or fetched. Caller should hold the latch of the instance. */
+  void MarkPageUsed(BufferPoolInstance &instance, page_id_t page_id);
+
+  /** @brief Rebuild next_page_id_ and free_pages_ of every instance from the free space map. */
+  void InitFreePages();
+
+  /**
+   * @brief Pin a frame found by a lock-free page table lookup, without the latch of the instance.
+   * @return true if the frame was pinned and holds page_id, which is resident. Otherwise the frame is left unpinned.
+   */
+  auto TryPinResident(BufferPoolInstance &instance, frame_id_t frame_id, page_id_t page_id) -> bool;
+
+  /**
+   * @brief Hand an access or unpin of a frame to the replacer without holding the latch of the instance. The event
+   * is buffered, and the buffer is applied with the latch held once it is full. Caller must not hold the latch.
+   */
+  void DeferAccess(BufferPoolInstance &instance, const AccessEvent &event);
+
+  /**
+   * @brief Apply buffered events to the replacer: record the accesses, and make each frame evictable if it is unpinned
+   * now. The pin count is read at this point, so the events of different threads may be applied in any order. Caller
+   * should hold the latch of the instance.
+   */
+  void ApplyAccesses(BufferPoolInstance &instance, const AccessEvent *events, size_t num_events);
+
+  /**
+   * @brief Apply the buffered events of all threads, so that the replacer knows about every access and unpin that
+   * happened so far. Caller should hold the latch of the instance.
+   */
+  void DrainAccesses(BufferPoolInstance &instance);
+
+  /**
+   * @brief Take a frame from the free list of the instance, evicting a page if the free list is empty. A dirty victim
+   * is written back with the latch released, so the caller must re-validate anything it looked up before. The frame
+   * is returned claimed, the caller sets its pin count once it has assigned it a page.
+   * @param lock the held latch of the instance
+   * @param[out] frame_id the local id of the frame
+   * @param[out] write_failed set to true if the dirty victim could not be written back
+   * @return false if all frames of the instance are pinned, or if the dirty victim could not be written back
+   */
+  auto AcquireFrame(BufferPoolInstance &instance, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id,
+                    bool *write_failed = nullptr) -> bool;
+  auto NewPage(BufferPoolInstance &instance, std::unique_lock<std::mutex> &lock, page_id_t *page_id, page_id_t hint,
+               bool *io_failed) -> Page *;
+
+  /**
+   * @brief Schedule a read or write of a page on the disk scheduler.
+   * @return the future that becomes ready once the request is completed
+   */
+  auto ScheduleIo(bool is_write, page_id_t page_id, char *data) -> std::future<bool>;
+
+  /**
+   * @brief Complete a read started by PrefetchPages(): release the pin of the prefetch and make the frame resident, or
+   * give up the frame if the read failed, see FailLoad(). Called by a disk scheduler worker.
+   */
+  void FinishPrefetch(BufferPoolInstance &instance, frame_id_t frame_id, bool success);
+
+  /**
+   * @brief Give up a frame whose page could not be read: remove it from the page table and the replacer, wake up the
+   * threads waiting for the read, and release the pin of the caller. The frame is freed right away if nobody else
+   * pinned it, and becomes Failed otherwise. Caller should hold the latch of the instance and the pin of the read.
+   */
+  void FailLoad(BufferPoolInstance &instance, frame_id_t frame_id);
+
+  /**
+   * @brief Release a pin on a Failed frame, and free the frame if that was the last pin. Caller should hold the latch
+   * of the instance.
+   */
+  void ReleaseFailedPin(BufferPoolInstance &instance, frame_id_t frame_id);
+
+  /**
+   * @brief Put a Failed frame that nobody pins anymore back on the free list. Does nothing if the frame is not Failed
+   * or still pinned. Caller should hold the latch of the instance.
+   */
+  void FreeFailedFrame(BufferPoolInstance &instance, frame_id_t frame_id);
+
+  /**
+   * @brief Pin a resident frame and clear its dirty flag, so that its page can be written by WriteBackBatch() with
+   * the latch released. A modification reported while the write is in flight keeps the page dirty. Caller should
+   * acquire the latch of the instance before calling this function.
+   * @param[out] batch the batch the pinned page is appended to
+   * @return false if the frame is not resident and was not pinned
+   */
+  auto PinForWriteBack(BufferPoolInstance &instance, frame_id_t frame_id, std::vector<WriteBackEntry> *batch) -> bool;
+
+  /**
+   * @brief Write the pages pinned by PinForWriteBack() as one disk scheduler batch, then unpin them. Pages that could
+   * not be written are marked dirty again. Caller must not hold the latch of any instance.
+   * @param background true if the batch was written by the background writer
+   * @return false if any page could not be written
+   */
+  auto WriteBackBatch(std::vector<WriteBackEntry> *batch, bool background) -> bool;
 
-  // TODO(student): You may add additional private members and helper functions
-  std::unordered_map<frame_id_t, page_id_t> f2p_;
-  std::unordered_map<page_id_t, bool> page_used_;
-  auto FlushPageUnlocked(page_id_t page_id) -> bool;
-  auto DeletePageUnlocked(page_id_t page_id) -> bool;
+  /** @brief The loop of the background writer thread. */
+  void RunBackgroundWriter(double clean_ratio);
 };
 }  // namespace bustub
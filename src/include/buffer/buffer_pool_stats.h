@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * The events counted by the buffer pool. Every *Ns counter accumulates the nanoseconds spent in the event before it.
+ */
+enum class BufferPoolCounter {
+  Hit = 0,
+  Miss,
+  SharedRead,
+  SwizzledHit,
+  Eviction,
+  DirtyWriteBack,
+  BackgroundWrite,
+  PinWait,
+  Prefetch,
+  DiskRead,
+  DiskReadNs,
+  DiskWrite,
+  DiskWriteNs,
+  ReplacerEvict,
+  ReplacerEvictNs,
+  NumCounters
+};
+
+/** A point-in-time snapshot of the buffer pool counters. */
+struct BufferPoolStats {
+  /** FetchPage calls that found the page in the buffer pool. */
+  uint64_t hits_{0};
+  /** FetchPage calls that had to read the page from disk. */
+  uint64_t misses_{0};
+  /** FetchPage calls that found the page being read from disk by another thread or a prefetch, and waited for it. */
+  uint64_t shared_reads_{0};
+  /** Pages read through a swizzled reference, without FetchPage. See BufferPoolManager::FetchPageSwizzled(). */
+  uint64_t swizzled_hits_{0};
+  /** Pages removed from the buffer pool to make room for another page. */
+  uint64_t evictions_{0};
+  /** Evicted pages that were dirty and had to be written back first, on the critical path of the evicting thread. */
+  uint64_t dirty_write_backs_{0};
+  /** Dirty pages written by the background writer, so that a later eviction finds them clean. */
+  uint64_t background_writes_{0};
+  /** Times a thread had to wait for a frame that was being loaded or written back. */
+  uint64_t pin_waits_{0};
+  /** Pages read into the buffer pool by PrefetchPages before anyone fetched them. */
+  uint64_t prefetches_{0};
+  uint64_t disk_reads_{0};
+  uint64_t disk_read_ns_{0};
+  uint64_t disk_writes_{0};
+  uint64_t disk_write_ns_{0};
+  /** Calls to Replacer::Evict, and the time spent in them. */
+  uint64_t replacer_evicts_{0};
+  uint64_t replacer_evict_ns_{0};
+
+  /** @return the fraction of FetchPage calls that were hits, shared reads count as neither hits nor misses */
+  auto HitRatio() const -> double;
+
+  /** @return every statistic as a (name, value) pair, in a stable order */
+  auto ToItems() const -> std::vector<std::pair<std::string, std::string>>;
+};
+
+/**
+ * BufferPoolCounters is a set of event counters that can be bumped from any thread without contention. Each thread is
+ * assigned one of a fixed number of cache-line sized stripes, so threads running on different cores almost never
+ * write to the same cache line. Reading the counters sums up all stripes.
+ */
+class BufferPoolCounters {
+ public:
+  /** Add delta to a counter of the stripe of the calling thread. */
+  void Add(BufferPoolCounter counter, uint64_t delta = 1) {
+    stripes_[StripeIndex()].values_[static_cast<size_t>(counter)].fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  /** Add one to counter and the nanoseconds elapsed since start to counter_ns. */
+  void AddTimed(BufferPoolCounter counter, BufferPoolCounter counter_ns, std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Add(counter);
+    Add(counter_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  /** @return the sum of all stripes. Counters bumped concurrently may or may not be included. */
+  auto Snapshot() const -> BufferPoolStats;
+
+  /** Set all counters to zero. */
+  void Reset();
+
+ private:
+  static constexpr size_t NUM_STRIPES = 32;
+  static constexpr size_t NUM_COUNTERS = static_cast<size_t>(BufferPoolCounter::NumCounters);
+
+  struct alignas(64) Stripe {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> values_{};
+  };
+
+  /** @return the stripe of the calling thread, threads are assigned stripes round-robin on their first access */
+  static auto StripeIndex() -> size_t;
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.h
+//
+// Identification: src/include/buffer/clock_pro_replacer.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ClockProReplacer implements a variant of the CLOCK-Pro replacement policy.
+ *
+ * Frames are either hot or cold. New pages start cold and in their test period. The cold hand only visits cold
+ * frames: a cold frame without its reference bit is evicted, and a cold frame that was referenced during its test
+ * period is promoted to hot. When there are more hot frames than allowed, the hot hand demotes hot frames that have
+ * not been referenced since its last pass.
+ *
+ * The replacer only sees frame ids, so unlike the original algorithm it cannot keep test periods of non-resident pages
+ * and it uses a fixed share of cold frames instead of adapting it. Like ClockReplacer, the reference bits and
+ * evictable flags are atomics and RecordAccess / SetEvictable never take a latch.
+ */
+class ClockProReplacer : public Replacer {
+ public:
+  /**
+   * Create a new ClockProReplacer.
+   * @param num_pages the maximum number of pages the ClockProReplacer will be required to store
+   */
+  explicit ClockProReplacer(size_t num_pages);
+
+  ~ClockProReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> override;
+
+ private:
+  /** Move the hot hand by one frame, demoting the frame if it is hot and was not referenced. */
+  void RunHotHand();
+
+  /** Forget the hot / cold status of a frame whose page leaves the buffer pool. */
+  void ResetFrame(size_t fid);
+
+  /** Whether each frame is tracked, i.e. accessed since it was last evicted or removed. */
+  std::vector<std::atomic<bool>> is_tracked_;
+  /** Reference bit of each frame. */
+  std::vector<std::atomic<bool>> ref_bits_;
+  /** Whether each frame can be evicted. */
+  std::vector<std::atomic<bool>> is_evictable_;
+  std::atomic<size_t> evictable_size_{0};
+  size_t num_pages_;
+
+  /** Whether each frame is hot, guarded by latch_. */
+  std::vector<bool> is_hot_;
+  /** Whether each cold frame is in its test period, guarded by latch_. */
+  std::vector<bool> in_test_;
+  /** Number of hot frames, guarded by latch_. */
+  size_t hot_size_{0};
+  /** Maximum number of hot frames. */
+  size_t max_hot_size_;
+  size_t hot_hand_{0};
+  size_t cold_hand_{0};
+  /** Protects the hands and the hot / cold status of the frames. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
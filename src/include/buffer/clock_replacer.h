@@ -12,7 +12,8 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstdint>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -23,6 +24,12 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The tracked flag, the evictable flag and the reference bit of every frame are packed into one atomic word that is only
+ * changed as a whole, so RecordAccess, SetEvictable, Remove and Size never take a latch and never see a frame half
+ * evicted. Only Evict serializes on the latch protecting the clock hand, and it claims a victim with a CAS that clears
+ * the whole word. Scan accesses do not set the reference bit, so pages only read by scans are evicted on the first
+ * pass of the hand. A prefetch does set it, so that a page read ahead of a scan survives until the scan reaches it.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -37,16 +44,35 @@ class ClockReplacer : public Replacer {
    */
   ~ClockReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
-  void Pin(frame_id_t frame_id) override;
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  auto EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> override;
+
  private:
-  // TODO(student): implement me!
+  /** The frame was accessed since it was last evicted or removed. */
+  static constexpr uint8_t TRACKED = 1;
+  /** The frame can be evicted, only set together with TRACKED. */
+  static constexpr uint8_t EVICTABLE = 2;
+  /** The reference bit of the frame, only set together with TRACKED. */
+  static constexpr uint8_t REFERENCED = 4;
+
+  /** The TRACKED, EVICTABLE and REFERENCED flags of each frame. */
+  std::vector<std::atomic<uint8_t>> states_;
+  /** Number of evictable frames. It is updated after the flags, so it can be briefly off, or even negative. */
+  std::atomic<int64_t> evictable_size_{0};
+  size_t num_pages_;
+  /** Position of the clock hand. */
+  size_t hand_{0};
+  /** Protects hand_. */
+  std::mutex latch_;
 };
 
 }  // namespace bustub
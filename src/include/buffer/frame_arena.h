@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** How the memory of a FrameArena is placed on the NUMA nodes of the machine. */
+enum class NumaPolicy {
+  /** Leave the placement to the kernel, i.e. usually on the node of the thread that first touches a page. */
+  Default = 0,
+  /** Spread the memory page by page over all online nodes. */
+  Interleave,
+  /** Place all memory on FrameArenaOptions::numa_node_. */
+  Bind
+};
+
+/** Options of a FrameArena. */
+struct FrameArenaOptions {
+  /**
+   * Back the arena with 2MB huge pages. Explicit huge pages (MAP_HUGETLB) are used if the system has enough of them
+   * reserved, otherwise the arena asks for transparent huge pages.
+   */
+  bool huge_pages_{false};
+  NumaPolicy numa_policy_{NumaPolicy::Default};
+  /** The node used by NumaPolicy::Bind. */
+  int numa_node_{0};
+};
+
+/**
+ * FrameArena is the memory holding the page data of all frames of a buffer pool: a single anonymous mapping that is
+ * aligned to BUSTUB_PAGE_ALIGNMENT, instead of one heap allocation per frame. The mapping is zeroed by the kernel.
+ *
+ * Under AddressSanitizer, every frame is followed by a poisoned guard region, so that an overflow of a page into the
+ * next frame is still detected.
+ *
+ * Huge pages and NUMA placement are best effort: if the system refuses them, the arena falls back to regular pages
+ * and the default placement, logs a warning, and reports what it actually got.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Map the memory of num_frames frames of page_size bytes each.
+   * @throws Exception if the memory cannot be mapped at all
+   */
+  explicit FrameArena(size_t num_frames, size_t page_size = BUSTUB_PAGE_SIZE, const FrameArenaOptions &options = {});
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the page data of the frame at index */
+  auto FrameData(size_t index) const -> char * { return base_ + index * frame_stride_; }
+
+  /** @return the number of frames in the arena */
+  auto GetNumFrames() const -> size_t { return num_frames_; }
+
+  /** @return true if the arena is backed by explicit huge pages */
+  auto UsesHugeTlb() const -> bool { return huge_tlb_; }
+
+  /** @return the size of the page data of a frame */
+  auto GetPageSize() const -> size_t { return page_size_; }
+
+  /** @return the NUMA policy in effect, NumaPolicy::Default if the requested one could not be applied */
+  auto GetNumaPolicy() const -> NumaPolicy { return numa_policy_; }
+
+ private:
+#if defined(__SANITIZE_ADDRESS__)
+  static constexpr size_t GUARD_SIZE = BUSTUB_PAGE_ALIGNMENT;
+#else
+  static constexpr size_t GUARD_SIZE = 0;
+#endif
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /** @brief Apply the NUMA policy to the mapping. @return false if the kernel refused it */
+  auto ApplyNumaPolicy(const FrameArenaOptions &options) -> bool;
+
+  char *base_;
+  size_t size_;
+  size_t num_frames_;
+  size_t page_size_;
+  /** The distance between the data of two consecutive frames. */
+  size_t frame_stride_;
+  bool huge_tlb_{false};
+  NumaPolicy numa_policy_{NumaPolicy::Default};
+};
+
+}  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/buffer/free_space_map.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records which page ids of a database are allocated, so that the pages deleted from B+ trees and hash
+ * tables are handed out again instead of growing the file forever, and so that the file can be truncated after its
+ * last allocated page.
+ *
+ * The map is a bitmap with one bit per page id. It is split into groups of PagesPerGroup() page ids, and every group
+ * is persisted in a free space map page of its own (see DiskManager::ReadFreeSpaceMapPage()), which starts with a
+ * small header. The whole bitmap is kept in memory, it is 8 * page size times smaller than the pages it describes.
+ * Changed groups are written by Flush().
+ *
+ * All methods are thread safe. The bitmap words are atomic and the groups never move once they exist, so that
+ * IsAllocated() and SetAllocated() of a page in an existing group take no latch; the latch is only taken to add groups,
+ * to drop them and to flush them.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * @brief Create an empty map, in which no page is allocated.
+   * @param page_size the size of a free space map page, i.e. the page size of the database
+   */
+  explicit FreeSpaceMap(size_t page_size);
+
+  ~FreeSpaceMap();
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  /** @return the number of page ids a free space map page describes */
+  auto PagesPerGroup() const -> size_t { return pages_per_group_; }
+
+  /**
+   * @brief Replace the map by the one stored by a disk manager. The groups are read in order up to the first page that
+   * is not a valid free space map page, e.g. past the end of the map.
+   */
+  void Load(DiskManager *disk_manager);
+
+  /** @brief Write the groups that changed since they were last loaded or flushed. */
+  void Flush(DiskManager *disk_manager);
+
+  /** @return true if page_id is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /**
+   * @brief Mark a page as allocated or free.
+   * @return true if this changed the state of the page
+   */
+  auto SetAllocated(page_id_t page_id, bool allocated) -> bool;
+
+  /** @return one past the largest allocated page id, or 0 if no page is allocated */
+  auto GetEnd() -> page_id_t;
+
+  /**
+   * @brief Drop the groups after the one holding the page before end, once the file has been truncated to end pages.
+   * They must hold no allocated page, and no page past end may be allocated meanwhile. Their pages are zeroed by the
+   * next Flush(), so that Load() stops before them.
+   */
+  void Truncate(page_id_t end);
+
+ private:
+  /** Identifies a free space map page. */
+  static constexpr uint32_t FSM_MAGIC = 0x4D534642;
+
+  /** The header at the start of every free space map page, followed by the bitmap. */
+  struct FsmPageHeader {
+    uint32_t magic_;
+    uint32_t group_;
+    uint32_t pages_per_group_;
+    uint32_t reserved_;
+  };
+
+  struct Group {
+    explicit Group(size_t num_words) : words_(std::make_unique<std::atomic<uint64_t>[]>(num_words)) {}
+
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    /** Whether the group changed since it was last written. */
+    std::atomic<bool> dirty_{true};
+  };
+
+  /** @return the group of page_id, adding empty groups up to it as needed */
+  auto GroupOf(page_id_t page_id) -> Group &;
+
+  /** @brief Make groups up to num_groups exist, empty if they are new. Caller should hold latch_. */
+  void Grow(size_t num_groups);
+
+  const size_t page_size_;
+  const size_t pages_per_group_;
+  /** Serializes Flush(), it is held while the pages are written. */
+  std::mutex flush_latch_;
+  /** Protects growing the map, and everything below. */
+  std::mutex latch_;
+  /**
+   * The groups, enough of them for every page id. A group is created the first time the map grows to it and is kept
+   * until the map is destroyed, even when it is dropped, so that latch-free readers never see it go away.
+   */
+  std::vector<std::atomic<Group *>> groups_;
+  /** The groups that are part of the map, the first ones of groups_. */
+  std::atomic<size_t> num_groups_{0};
+  /** Groups dropped by Truncate() whose pages have not been zeroed yet, from this index up to dropped_end_. */
+  size_t dropped_begin_{0};
+  size_t dropped_end_{0};
+};
+
+}  // namespace bustub
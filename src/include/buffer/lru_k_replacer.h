@@ -13,37 +13,65 @@
 #pragma once
 
 #include <limits>
-#include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
 namespace bustub {
 
-enum class AccessType { Unknown = 0, Get, Scan };
 const size_t INF = 2147483647;
+
+/** Evictable frames of an LRUKReplacer, ordered by a timestamp of each frame, then by frame id. */
+using EvictQueue = std::set<std::pair<size_t, frame_id_t>>;
+
 class LRUKNode {
  public:
-  explicit LRUKNode(frame_id_t fid, size_t current_time_stamp, size_t k);
+  explicit LRUKNode(frame_id_t fid, size_t current_time_stamp, size_t k, bool is_scan = false);
+  LRUKNode(LRUKNode &&) = default;
+  auto operator=(LRUKNode &&) -> LRUKNode & = default;
   ~LRUKNode() = default;
   void SetEvictable(bool set_evictable);
   auto GetEvictable() -> bool;
   auto GetKDistence(size_t current_time_stamp) -> size_t;
   auto GetEarlyTimestamp() -> size_t;
+  auto GetLateTimestamp() -> size_t;
+  /** @return true if the frame has only been accessed by scans so far */
+  auto IsScan() -> bool;
+  /** @return true if the frame has been prefetched and not accessed since */
+  auto IsPrefetch() -> bool;
+  void SetPrefetch(bool is_prefetch);
+  /** @return true if the frame has been accessed at least k times */
+  auto HasKAccesses() -> bool;
   void RecordAccess(size_t current_time_stamp);
+  /**
+   * @return the entry of the frame taken out of its EvictQueue while the frame is not evictable, or an empty one. It is
+   * put back when the frame is evictable again, so that pinning and unpinning a frame does not allocate.
+   */
+  auto QueueEntry() -> EvictQueue::node_type & { return queue_entry_; }
 
  private:
-  /** History of last seen K timestamps of this page. Least recent timestamp stored in front. */
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
-
-  [[maybe_unused]] std::list<size_t> history_;
-  [[maybe_unused]] size_t k_;
+  /**
+   * Ring buffer of the last seen K timestamps of this page. The least recent timestamp is stored at head_ once the
+   * buffer is full, and at index 0 before that.
+   */
+  std::vector<size_t> history_;
+  /** Position in history_ that the next access overwrites. */
+  size_t head_{0};
+  /** Number of valid timestamps in history_, at most k. */
+  size_t size_{0};
+  size_t k_;
   [[maybe_unused]] frame_id_t fid_;
-  [[maybe_unused]] bool is_evictable_{false};
+  bool is_evictable_{false};
+  bool is_scan_;
+  bool is_prefetch_{false};
+  EvictQueue::node_type queue_entry_;
 };
 
 /**
@@ -56,8 +84,21 @@ class LRUKNode {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Each frame only keeps its last k timestamps. Evictable frames are kept in two ordered sets, one for frames with
+ * less than k accesses keyed by their most recent access, and one for frames with k or more accesses keyed by their
+ * k-th most recent access, so that Evict, RecordAccess and SetEvictable all run in O(log n).
+ *
+ * Frames that have only been touched by AccessType::Scan are kept on a separate probationary queue in LRU order and
+ * are always evicted before any other frame, so a large sequential scan recycles its own frames instead of flushing
+ * out the working set. Scan accesses to a frame outside the probationary queue are ignored, and the first non-scan
+ * access to a probationary frame promotes it with a fresh history.
+ *
+ * Frames loaded by AccessType::Prefetch are probationary as well, but wait on a queue of their own until their first
+ * access, which is evicted after the scan queue. Otherwise a scan would recycle the pages it read ahead before the
+ * pages it is done with.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -75,7 +116,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -93,7 +134,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -108,7 +149,7 @@ class LRUKReplacer {
    * @param access_type type of access that was received. This parameter is only needed for
    * leaderboard tests.
    */
-  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
   /**
    * TODO(P1): Add implementation
@@ -127,7 +168,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -146,7 +187,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -155,18 +196,47 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  [[maybe_unused]] std::unordered_map<frame_id_t, std::shared_ptr<LRUKNode> > node_store_;
-  [[maybe_unused]] size_t current_timestamp_{0};
-  [[maybe_unused]] size_t curr_size_{0};
-  [[maybe_unused]] size_t replacer_size_;
+  /** @return the set of evictable frames the node belongs to */
+  auto QueueOf(LRUKNode &node) -> EvictQueue & {
+    if (node.IsPrefetch()) {
+      return prefetch_queue_;
+    }
+    if (node.IsScan()) {
+      return scan_queue_;
+    }
+    return node.HasKAccesses() ? k_queue_ : less_k_queue_;
+  }
+
+  /** @return the ordering key of the node inside its queue */
+  static auto KeyOf(LRUKNode &node, frame_id_t frame_id) -> std::pair<size_t, frame_id_t> {
+    return {node.IsScan() || !node.HasKAccesses() ? node.GetLateTimestamp() : node.GetEarlyTimestamp(), frame_id};
+  }
+
+  /** @brief Put an evictable frame into its queue, reusing its queue entry if it has one. */
+  void Enqueue(LRUKNode &node, frame_id_t frame_id);
+
+  /** @brief Take a frame out of its queue, keeping the queue entry in the node. */
+  void Dequeue(LRUKNode &node, frame_id_t frame_id);
+
+  std::unordered_map<frame_id_t, LRUKNode> node_store_;
+  /** Evictable frames only accessed by scans, ordered by most recent access. */
+  EvictQueue scan_queue_;
+  /** Evictable frames that have been prefetched and not accessed since, ordered by prefetch. */
+  EvictQueue prefetch_queue_;
+  /** Evictable frames with less than k accesses, ordered by most recent access. */
+  EvictQueue less_k_queue_;
+  /** Evictable frames with k or more accesses, ordered by k-th most recent access. */
+  EvictQueue k_queue_;
+  size_t current_timestamp_{0};
+  size_t replacer_size_;
   size_t evictable_size_{0};
-  [[maybe_unused]] size_t k_;
-  [[maybe_unused]] std::mutex latch_;
+  size_t k_;
+  std::mutex latch_;
 };
 
 }  // namespace bustub
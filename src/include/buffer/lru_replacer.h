@@ -14,6 +14,7 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -22,7 +23,8 @@
 namespace bustub {
 
 /**
- * LRUReplacer implements the Least Recently Used replacement policy.
+ * LRUReplacer implements the Least Recently Used replacement policy. A frame is ordered by its last access, pinning
+ * and unpinning it does not change its position.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -37,16 +39,28 @@ class LRUReplacer : public Replacer {
    */
   ~LRUReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
-  void Pin(frame_id_t frame_id) override;
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  auto EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> override;
+
  private:
-  // TODO(student): implement me!
+  /** Tracked frames, the most recently used one at the front. */
+  std::list<frame_id_t> lru_list_;
+  /** Position of every tracked frame in lru_list_. */
+  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> lru_map_;
+  /** Whether each frame can be evicted, only meaningful for tracked frames. */
+  std::vector<bool> is_evictable_;
+  size_t evictable_size_{0};
+  size_t num_pages_;
+  std::mutex latch_;
 };
 
 }  // namespace bustub
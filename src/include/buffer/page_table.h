@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the pages cached by a buffer pool instance to the frames holding them.
+ *
+ * It is an open-addressing hash table with linear probing, whose slots are grouped into cache-line sized buckets: a
+ * page is looked for in its home bucket first, so a lookup usually touches a single cache line. Every slot packs a page
+ * id and a frame id into one 64-bit word, so that a lookup reads both with a single atomic load and needs no latch.
+ *
+ * Insert() and Erase() must be serialized by the caller, i.e. the buffer pool calls them with the latch of the
+ * instance held. Find() may run concurrently with them. An entry that is being moved by a concurrent Erase() may then
+ * be missed, and a frame id that was just unmapped may be returned, so a lock-free lookup is only a hint: the caller
+ * validates the frame it found, and looks the page up again under the latch if it found nothing.
+ *
+ * The table never grows: the capacity is chosen for the number of frames, which bounds the number of entries.
+ */
+class PageTable {
+ public:
+  /**
+   * @brief Create an empty page table.
+   * @param max_entries the maximum number of pages mapped at the same time, i.e. the number of frames
+   */
+  explicit PageTable(size_t max_entries);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * @brief Look up the frame of a page without any latch. See the class comment for the guarantees.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page was found
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+    for (size_t slot = HomeSlot(page_id);; slot = (slot + 1) & slot_mask_) {
+      uint64_t entry = SlotAt(slot).load(std::memory_order_acquire);
+      if (entry == EMPTY) {
+        return false;
+      }
+      if (KeyOf(entry) == page_id) {
+        *frame_id = ValueOf(entry);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Map a page to a frame, replacing the frame the page was mapped to before.
+   * @param page_id the page, must not be INVALID_PAGE_ID
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping of a page. Entries probed after it are shifted back, so the table has no tombstones.
+   * @param page_id the page to unmap
+   * @return false if the page was not mapped
+   */
+  auto Erase(page_id_t page_id) -> bool;
+
+  /** @return the number of mapped pages */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return the number of slots of the table */
+  auto Capacity() const -> size_t { return slot_mask_ + 1; }
+
+ private:
+  /** Number of slots per bucket, a bucket fills one cache line. */
+  static constexpr size_t SLOTS_PER_BUCKET = 8;
+  /** An empty slot, i.e. INVALID_PAGE_ID in the key half. */
+  static constexpr uint64_t EMPTY = ~static_cast<uint64_t>(0);
+
+  struct alignas(64) Bucket {
+    std::atomic<uint64_t> slots_[SLOTS_PER_BUCKET];
+  };
+  static_assert(sizeof(Bucket) == 64);
+
+  static auto MakeEntry(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto KeyOf(uint64_t entry) -> page_id_t { return static_cast<page_id_t>(entry >> 32); }
+  static auto ValueOf(uint64_t entry) -> frame_id_t { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** @return the first slot of the home bucket of a page */
+  auto HomeSlot(page_id_t page_id) const -> size_t {
+    // Fibonacci hashing spreads the consecutive page ids of an instance over all buckets.
+    uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash >> bucket_shift_) * SLOTS_PER_BUCKET;
+  }
+
+  auto SlotAt(size_t slot) const -> std::atomic<uint64_t> & {
+    return buckets_[slot / SLOTS_PER_BUCKET].slots_[slot % SLOTS_PER_BUCKET];
+  }
+
+  /** @return the slot holding page_id, or the empty slot that ends its probe sequence */
+  auto Probe(page_id_t page_id) const -> size_t;
+
+  std::unique_ptr<Bucket[]> buckets_;
+  /** The number of slots minus one, the number of slots is a power of two. */
+  size_t slot_mask_;
+  /** 64 minus the number of bits of a bucket index. */
+  size_t bucket_shift_;
+  size_t size_{0};
+};
+
+}  // namespace bustub
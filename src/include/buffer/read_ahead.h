@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead.h
+//
+// Identification: src/include/buffer/read_ahead.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * SequentialReadAhead follows the pages visited by a scan over a chain of pages, e.g. a table heap or the leaves of a
+ * B+ tree. Once the page ids advance by the same positive stride a few times in a row, it keeps a window of the pages
+ * predicted to come next in flight with BufferPoolManager::PrefetchPages(), so that the scan rarely waits for a read
+ * when it crosses a page boundary. The window is topped up in batches once half of it has been consumed.
+ *
+ * A SequentialReadAhead is owned by a single iterator and is not thread-safe.
+ */
+class SequentialReadAhead {
+ public:
+  /**
+   * @param bpm the buffer pool the pages are prefetched into
+   * @param window the number of pages to keep in flight, capped at a quarter of the buffer pool. 0 disables read-ahead.
+   */
+  explicit SequentialReadAhead(BufferPoolManager *bpm, size_t window = READ_AHEAD_WINDOW);
+
+  /** @brief Report that the scan moved on to page_id, and prefetch the pages after it if the scan is sequential. */
+  void Access(page_id_t page_id);
+
+ private:
+  /** The number of steps with the same stride after which an access pattern is considered sequential. */
+  static constexpr size_t SEQUENTIAL_STEPS = 2;
+
+  BufferPoolManager *bpm_;
+  size_t window_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+  page_id_t stride_{0};
+  /** The number of consecutive steps whose stride was stride_. */
+  size_t steps_{0};
+  /** The last page whose prefetch was requested. */
+  page_id_t prefetched_until_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
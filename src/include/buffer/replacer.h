@@ -12,12 +12,26 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
 /**
- * Replacer is an abstract class that tracks page usage.
+ * The kind of access a page is fetched for. Prefetch marks a page that is read ahead of a scan and has not been
+ * accessed yet.
+ */
+enum class AccessType { Unknown = 0, Get, Scan, Prefetch };
+
+/** The replacement policies a buffer pool can be configured with. */
+enum class ReplacerType { LRUK = 0, LRU, Clock, ClockPro };
+
+/**
+ * Replacer is an abstract class that tracks frame usage and picks the frames to evict.
+ *
+ * A frame is tracked from its first RecordAccess() until it is evicted or removed. Only tracked frames that are
+ * marked as evictable are candidates for eviction.
  */
 class Replacer {
  public:
@@ -25,26 +39,42 @@ class Replacer {
   virtual ~Replacer() = default;
 
   /**
-   * Remove the victim frame as defined by the replacement policy.
-   * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
+   * Evict the victim frame as defined by the replacement policy, and stop tracking it.
+   * @param[out] frame_id id of frame that was evicted
    * @return true if a victim frame was found, false otherwise
    */
-  virtual auto Victim(frame_id_t *frame_id) -> bool = 0;
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
 
   /**
-   * Pins a frame, indicating that it should not be victimized until it is unpinned.
-   * @param frame_id the id of the frame to pin
+   * Record that the given frame has been accessed, and start tracking it if it is not tracked yet.
+   * @param frame_id the id of the accessed frame
+   * @param access_type type of the access
    */
-  virtual void Pin(frame_id_t frame_id) = 0;
+  virtual void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) = 0;
 
   /**
-   * Unpins a frame, indicating that it can now be victimized.
-   * @param frame_id the id of the frame to unpin
+   * Toggle whether a tracked frame can be evicted. Does nothing if the frame is not tracked.
+   * @param frame_id the id of the frame
+   * @param set_evictable whether the frame can be evicted
    */
-  virtual void Unpin(frame_id_t frame_id) = 0;
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
 
-  /** @return the number of elements in the replacer that can be victimized */
+  /**
+   * Stop tracking an evictable frame, regardless of the replacement policy.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Look ahead of the replacement policy without evicting anything. Accesses that happen afterwards may change the
+   * order, so the result is only a hint, e.g. for writing back dirty pages before they are evicted.
+   * @param max_candidates the maximum number of frames to return
+   * @return the evictable frames that Evict() would pick next, in the order it would pick them
+   */
+  virtual auto EvictionCandidates(size_t max_candidates) -> std::vector<frame_id_t> = 0;
 };
 
 }  // namespace bustub
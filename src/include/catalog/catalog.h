@@ -228,12 +228,17 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap. The keys are collected and bulk loaded, which builds the tree
+    // bottom up instead of descending it once per tuple.
     auto *table_meta = GetTable(table_name);
+    std::vector<std::pair<KeyType, ValueType>> entries;
     for (auto iter = table_meta->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
       auto [meta, tuple] = iter.GetTuple();
-      index->InsertEntry(tuple.KeyFromTuple(schema, key_schema, key_attrs), tuple.GetRid(), txn);
+      KeyType key;
+      key.SetFromKey(tuple.KeyFromTuple(schema, key_schema, key_attrs), key_schema);
+      entries.emplace_back(key, tuple.GetRid());
     }
+    index->BulkLoad(std::move(entries), txn);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
@@ -218,9 +218,18 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn, bool is_modify) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance backed by a database file.
+   * @param db_file_name the database file
+   * @param bpm_instances the number of independent instances the buffer pool is partitioned into
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = BUFFER_POOL_INSTANCES);
 
-  BustubInstance();
+  /**
+   * Create a BusTub instance backed by memory.
+   * @param bpm_instances the number of independent instances the buffer pool is partitioned into
+   */
+  explicit BustubInstance(size_t bpm_instances = BUFFER_POOL_INSTANCES);
 
   ~BustubInstance();
 
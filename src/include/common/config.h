@@ -27,16 +27,30 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background writer of the buffer pool checks for dirty frames every BACKGROUND_WRITER_INTERVAL. */
+extern std::chrono::milliseconds background_writer_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // default data page size in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
 
+static constexpr int BUSTUB_MAX_PAGE_SIZE = 32768;             // largest page size a database can be created with
+static constexpr int BUSTUB_PAGE_ALIGNMENT = 4096;             // alignment of page buffers, as required by O_DIRECT
+static constexpr int BUFFER_POOL_INSTANCES = 1;                // independent instances the buffer pool is split into
+static constexpr int DISK_SCHEDULER_WORKERS = 4;               // threads issuing the requests of a disk scheduler
+static constexpr int DISK_SYNC_INTERVAL = 64;                  // writes between two fdatasync calls of DiskManagerPosix
+static constexpr int READ_AHEAD_WINDOW = 32;                   // pages a sequential scan keeps reading ahead of itself
+static constexpr int BTREE_SWIZZLE_SLOTS = 1024;               // swizzled references to inner pages kept by a B+ tree
+static constexpr double BTREE_FILL_FACTOR = 0.9;               // share of each page filled by a B+ tree bulk load
+static constexpr double BACKGROUND_WRITER_CLEAN_RATIO = 0.25;  // fraction of frames the writer keeps clean
+static constexpr int FRAME_WAIT_RETRIES = 10000;               // retries of a fetch while all frames are pinned
+
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
@@ -17,22 +17,40 @@
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/**
+ * A single page read or write of a batch, see DiskManager::ExecuteBatch().
+ */
+struct DiskIo {
+  bool is_write_;
+  page_id_t page_id_;
+  char *data_;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The page size is a property of the database. A database file starts with a header block of FILE_HEADER_SIZE bytes
+ * that records the page size the file was created with and the layout of the pages (see FileFormat), followed by the
+ * pages.
  */
 class DiskManager {
  public:
   /**
-   * Creates a new disk manager that writes to the specified database file.
+   * Creates a new disk manager that writes to the specified database file. An existing database file is opened with
+   * the page size recorded in its header, page_size only applies to a new file.
    * @param db_file the file name of the database file to write to
+   * @param page_size the page size of a new database file, a power of two from BUSTUB_PAGE_ALIGNMENT up to
+   * BUSTUB_MAX_PAGE_SIZE
+   * @throws Exception if the page size is invalid, or if the file stores its pages compressed
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, size_t page_size = BUSTUB_PAGE_SIZE);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
@@ -42,7 +60,10 @@ class DiskManager {
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
+
+  /** @return the size of every page of the database in bytes */
+  auto GetPageSize() const -> size_t { return page_size_; }
 
   /**
    * Write a page to the database file.
@@ -58,6 +79,50 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Execute a batch of page reads and writes. Requests for the same page are executed in the order they appear in the
+   * batch, the others in any order. The default implementation executes them one after another.
+   * @param batch the requests to execute
+   */
+  virtual void ExecuteBatch(const std::vector<DiskIo> &batch);
+
+  /**
+   * Tell the disk manager about the page buffers that most requests will read into or write from, e.g. the frames of
+   * a buffer pool, so that it can prepare them for faster I/O. This is only a hint, the default does nothing.
+   * @param buffers the page buffers, each GetPageSize() bytes long
+   */
+  virtual void RegisterBuffers(const std::vector<char *> &buffers) {}
+
+  /**
+   * Forget the buffers passed to RegisterBuffers(), which must be called before they are freed.
+   */
+  virtual void UnregisterBuffers() {}
+
+  /**
+   * Read a page of the free space map of the database, see FreeSpaceMap. The free space map is stored apart from the
+   * pages of the database, in the file <db>.fsm next to the database file, so that it takes no page ids. It is reset
+   * when a new database file is created. A page that was never written reads as zeros, and so does every page of a
+   * disk manager without a database file.
+   * @param index the index of the free space map page
+   * @param[out] page_data output buffer of GetPageSize() bytes
+   */
+  void ReadFreeSpaceMapPage(size_t index, char *page_data);
+
+  /**
+   * Write a page of the free space map of the database, see ReadFreeSpaceMapPage(). Does nothing for a disk manager
+   * without a database file.
+   * @param index the index of the free space map page
+   * @param page_data raw page data
+   */
+  void WriteFreeSpaceMapPage(size_t index, const char *page_data);
+
+  /**
+   * Shrink the database file to its first num_pages pages, once the pages after them have been freed. Does nothing if
+   * the file is not larger, or if the disk manager has no database file.
+   * @param num_pages the number of pages to keep
+   */
+  virtual void TruncatePages(size_t num_pages);
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -93,7 +158,44 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
+  /** The layout of the pages in a database file, recorded in its header. */
+  enum class FileFormat : uint32_t {
+    /** Every page is stored as is at PageOffset(). */
+    Pages = 0,
+    /** Pages are stored compressed in variable-size extents, see DiskManagerCompressed. */
+    CompressedExtents
+  };
+
+  /** The size of the header block at the start of a database file. Pages start right after it, aligned for O_DIRECT. */
+  static constexpr size_t FILE_HEADER_SIZE = BUSTUB_PAGE_ALIGNMENT;
+
+  /** @throws Exception if page_size is not a power of two from BUSTUB_PAGE_ALIGNMENT up to BUSTUB_MAX_PAGE_SIZE */
+  static void CheckPageSize(size_t page_size);
+
+  /** @return the offset of a page in the database file */
+  auto PageOffset(page_id_t page_id) const -> size_t {
+    return FILE_HEADER_SIZE + static_cast<size_t>(page_id) * page_size_;
+  }
+
+  /** @brief Fill a header block of FILE_HEADER_SIZE bytes describing this database. */
+  void EncodeFileHeader(char *header) const;
+
+  /**
+   * @brief Adopt the page size recorded in a header block read from an existing database file.
+   * @throws Exception if the block is not a valid header, or if the file is not in file_format_
+   */
+  void DecodeFileHeader(const char *header);
+
   auto GetFileSize(const std::string &file_name) -> int;
+  /** Open or create the log file next to the database file file_name_. */
+  void OpenLogFile();
+  /**
+   * Open the free space map file next to the database file file_name_.
+   * @param create true if the database file was just created, the map of an earlier database of that name is dropped
+   */
+  void OpenFreeSpaceMapFile(bool create);
+  /** Close the free space map file. */
+  void CloseFreeSpaceMapFile();
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
@@ -101,11 +203,18 @@ class DiskManager {
   std::fstream db_io_;
   std::string file_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
+  size_t page_size_{BUSTUB_PAGE_SIZE};
+  /** The layout of the database file, a subclass that uses another layout sets it before reading the header. */
+  FileFormat file_format_{FileFormat::Pages};
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
+  /** The free space map file, see ReadFreeSpaceMapPage(), protected by fsm_latch_. */
+  std::fstream fsm_io_;
+  std::string fsm_name_;
+  std::mutex fsm_latch_;
 };
 
 }  // namespace bustub
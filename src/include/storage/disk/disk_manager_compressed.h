@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.h
+//
+// Identification: src/include/storage/disk/disk_manager_compressed.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "storage/disk/disk_manager_posix.h"
+#include "storage/disk/page_codec.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerCompressed stores every page compressed with PageCodec, which cuts the I/O volume and the size of the
+ * file for pages that compress well, e.g. table pages full of repeated VARCHARs. Pages are compressed when they are
+ * written, i.e. when the buffer pool flushes or evicts them, and decompressed when they are read into a frame, so
+ * compression is invisible above the disk manager.
+ *
+ * A compressed page is stored in an extent: a run of SECTOR_SIZE byte sectors that starts with an ExtentHeader naming
+ * the page. The extents follow the file header back to back, and the map from page ids to extents is kept in memory
+ * and rebuilt by walking the extents when the file is opened. A page is never overwritten in place: every write goes
+ * to a free extent or to the end of the file, and the extent of the previous copy is only freed once the file has been
+ * synced after the write. Every extent is stamped with a sequence number and a checksum of the page, so that the
+ * newest intact copy of a page wins if the file has several, and a write torn by a crash loses at most that write.
+ *
+ * Pages that do not shrink by at least one sector are stored uncompressed. The file is always accessed through the
+ * page cache, since extents are not aligned for O_DIRECT.
+ */
+class DiskManagerCompressed : public DiskManagerPosix {
+ public:
+  /**
+   * Creates a new disk manager that stores the pages of the specified database file compressed.
+   * @param db_file the file name of the database file to write to
+   * @param sync_interval the number of page writes between two fdatasync calls, see DiskManagerPosix
+   * @param page_size the page size of a new database file, see DiskManager::DiskManager()
+   * @throws Exception if the file exists and does not store compressed pages
+   */
+  explicit DiskManagerCompressed(const std::string &db_file, size_t sync_interval = DISK_SYNC_INTERVAL,
+                                 size_t page_size = BUSTUB_PAGE_SIZE);
+
+  /**
+   * Compress a page and write it to a new extent.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @throws Exception if the page could not be written completely
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Read and decompress a page. A page that was never written yields a zeroed page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @throws Exception if the extent of the page could not be read or is corrupt
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Make all completed page writes durable, then free the extents of the copies they replaced.
+   */
+  void Sync() override;
+
+  /**
+   * Drop the pages from num_pages on. Their extents are marked free in the file, so that they stay dropped when the
+   * file is opened again, and the file is cut after the last extent that holds a page.
+   * @param num_pages the number of pages to keep
+   */
+  void TruncatePages(size_t num_pages) override;
+
+  /** @return the number of pages stored in the file */
+  auto GetNumPages() -> size_t;
+
+  /** @return the bytes taken by the extents of the stored pages, i.e. the file size without free extents */
+  auto GetStoredBytes() -> size_t;
+
+ private:
+  /** The unit extents are allocated in. */
+  static constexpr size_t SECTOR_SIZE = 512;
+  /** Identifies the header of an extent. */
+  static constexpr uint32_t EXTENT_MAGIC = 0x58455442;
+
+  /** How the page in an extent is encoded. */
+  enum class ExtentCodec : uint32_t { Raw = 0, Lz };
+
+  /** The header at the start of every extent. */
+  struct ExtentHeader {
+    uint32_t magic_;
+    /** The page stored in the extent, INVALID_PAGE_ID for an extent freed by TruncatePages(). */
+    page_id_t page_id_;
+    /** The write that stored the page, larger for later writes. */
+    uint64_t sequence_;
+    /** The size of the extent, which may be larger than the page needs. */
+    uint32_t num_sectors_;
+    /** The number of bytes the page takes after the header. */
+    uint32_t stored_size_;
+    ExtentCodec codec_;
+    /** Checksum of the stored bytes of the page, to detect an extent torn by a crash. */
+    uint32_t checksum_;
+  };
+  static_assert(sizeof(ExtentHeader) == 32);
+
+  /** The largest extent any page can need: its header, and the page in the worst case of the codec. */
+  static constexpr size_t MAX_EXTENT_SIZE = sizeof(ExtentHeader) + PageCodec::MaxCompressedSize(BUSTUB_MAX_PAGE_SIZE);
+
+  /** The place of an extent in the file. */
+  struct Extent {
+    size_t offset_;
+    uint32_t num_sectors_;
+    /** The sequence number of the write stored in the extent. */
+    uint64_t sequence_;
+  };
+
+  /** @return a per-thread buffer of MAX_EXTENT_SIZE bytes */
+  static auto ExtentBuffer() -> char *;
+
+  /** @return the checksum of the stored bytes of a page, see ExtentHeader */
+  static auto Checksum(const char *data, size_t size) -> uint32_t;
+
+  /** @return true if the first size bytes of buffer hold an intact extent of page_id */
+  static auto IsIntact(const char *buffer, size_t size, page_id_t page_id) -> bool;
+
+  /**
+   * @brief Read an extent into buffer, which must hold MAX_EXTENT_SIZE bytes.
+   * @return the number of bytes read, less than the extent if the file ends within its last sector
+   * @throws Exception if the read failed
+   */
+  auto ReadExtent(const Extent &extent, char *buffer) -> size_t;
+
+  /**
+   * @brief Walk the extents of the file to rebuild the page map, the free extents and the end of the file. Extents that
+   * fail their checksum are free.
+   */
+  void LoadExtents();
+
+  /**
+   * @brief Find room for an extent of num_sectors sectors, in a free extent that is not too large or at the end of
+   * the file. Caller should hold extent_latch_.
+   */
+  auto AllocateExtent(uint32_t num_sectors) -> Extent;
+
+  /**
+   * @brief Stamp the header of extent free in the file, so that LoadExtents() neither brings back the page it held nor
+   * stops walking at it. Caller should hold extent_latch_.
+   */
+  void WriteFreeHeader(const Extent &extent);
+
+  /** Protects everything below. The extents themselves are read and written without it. */
+  std::mutex extent_latch_;
+  /** The extent holding each stored page. */
+  std::unordered_map<page_id_t, Extent> extents_;
+  /** Extents that hold no page, by their number of sectors. */
+  std::multimap<uint32_t, size_t> free_extents_;
+  /** The offset right after the last extent, where the next new extent is appended. */
+  size_t file_end_{FILE_HEADER_SIZE};
+  /** The sequence number of the next write. */
+  uint64_t next_sequence_{1};
+  /** Writes of pages to new extents that are not in extents_ yet. */
+  size_t writes_in_flight_{0};
+  /** Extents of pages that have been written again since the last sync, freed by the next Sync(). */
+  std::vector<std::pair<page_id_t, Extent>> replaced_extents_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.h
+//
+// Identification: src/include/storage/disk/disk_manager_mmap.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager_posix.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerMmap maps the database file into memory and serves page reads from the mapping, so a read of a page in
+ * the page cache is a memcpy without a system call, which cuts the cost of cold starts and scans of read-mostly
+ * databases. Writes still go through pwrite(2) of DiskManagerPosix; the mapping is shared, so it sees them at once.
+ *
+ * The mapping reserves map_size bytes of address space when the file is opened and never moves, so the file can grow
+ * without remapping. Only the part of the mapping that the file covers may be touched: the size of the file is cached
+ * and refreshed with fstat(2) when a read goes past it. Reads past map_size fall back to pread(2).
+ */
+class DiskManagerMmap : public DiskManagerPosix {
+ public:
+  /** The address space reserved for the mapping by default. */
+  static constexpr size_t DEFAULT_MAP_SIZE = size_t{1} << 36;
+
+  /**
+   * Creates a new disk manager that reads the specified database file through a memory mapping.
+   * @param db_file the file name of the database file to write to
+   * @param sync_interval the number of page writes between two fdatasync calls, see DiskManagerPosix
+   * @param page_size the page size of a new database file, see DiskManager::DiskManager()
+   * @param map_size the bytes of the file that are mapped, the rest is read with pread(2)
+   * @throws Exception if the file cannot be mapped
+   */
+  explicit DiskManagerMmap(const std::string &db_file, size_t sync_interval = DISK_SYNC_INTERVAL,
+                           size_t page_size = BUSTUB_PAGE_SIZE, size_t map_size = DEFAULT_MAP_SIZE);
+
+  ~DiskManagerMmap() override;
+
+  /**
+   * Unmap the database file, then sync and close it.
+   */
+  void ShutDown() override;
+
+  /**
+   * Copy a page out of the mapping. Reading past the end of the file yields a zeroed page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Shrink the database file to its first num_pages pages. The truncated pages must not be read meanwhile, and views of
+   * them must not be used anymore.
+   * @param num_pages the number of pages to keep
+   */
+  void TruncatePages(size_t num_pages) override;
+
+  /**
+   * @brief Access a page in place, without copying it. The view reflects later writes of the page and stays valid
+   * until the disk manager is shut down; it must not be written through.
+   * @param page_id id of the page
+   * @return the page in the mapping, or nullptr if it is past the end of the file or of the mapping
+   */
+  auto GetPageView(page_id_t page_id) -> const char *;
+
+ private:
+  /** @return true if the file covers size bytes, refreshing the cached file size if needed */
+  auto IsMapped(size_t size) -> bool;
+
+  /** @brief Unmap the file, if it is mapped. */
+  void Unmap();
+
+  char *map_{nullptr};
+  size_t map_size_;
+  /**
+   * The size of the file when it was last looked at. The file only grows except in TruncatePages(), which lowers it,
+   * so this never overstates it.
+   */
+  std::atomic<size_t> file_size_{0};
+};
+
+}  // namespace bustub
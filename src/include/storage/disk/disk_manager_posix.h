@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_posix.h
+//
+// Identification: src/include/storage/disk/disk_manager_posix.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerPosix reads and writes pages with pread(2) and pwrite(2) on a file descriptor. Unlike the fstream based
+ * DiskManager, it has no shared file position, so requests for different pages never serialize on a latch.
+ *
+ * The file can optionally be opened with O_DIRECT to bypass the page cache. Buffers passed to ReadPage and WritePage
+ * should then be aligned to BUSTUB_PAGE_ALIGNMENT, as the frames of the buffer pool are. Unaligned buffers still work,
+ * but go through a bounce buffer.
+ *
+ * Instead of flushing after every write, the file is synced with fdatasync(2) every sync_interval writes, on Sync()
+ * and on ShutDown(). The log file is handled by the DiskManager.
+ */
+class DiskManagerPosix : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io whether to open the file with O_DIRECT, falls back to buffered I/O if the file system does not
+   * support it
+   * @param sync_interval the number of page writes between two fdatasync calls, 0 to only sync on Sync() and ShutDown()
+   * @param page_size the page size of a new database file, see DiskManager::DiskManager()
+   */
+  explicit DiskManagerPosix(const std::string &db_file, bool direct_io = false,
+                            size_t sync_interval = DISK_SYNC_INTERVAL, size_t page_size = BUSTUB_PAGE_SIZE);
+
+  ~DiskManagerPosix() override;
+
+  /**
+   * Sync and close the database file, and close the log file.
+   */
+  void ShutDown() override;
+
+  /**
+   * Write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @throws Exception if the page could not be written completely
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Read a page from the database file. Reading past the end of the file yields a zeroed page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @throws Exception if the read failed
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Shrink the database file to its first num_pages pages with ftruncate(2).
+   * @param num_pages the number of pages to keep
+   */
+  void TruncatePages(size_t num_pages) override;
+
+  /**
+   * Make all completed page writes durable.
+   */
+  virtual void Sync();
+
+  /** @return true if the database file is accessed with O_DIRECT */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
+ protected:
+  /**
+   * Open a database file in the given format, for subclasses that lay out the pages differently.
+   */
+  DiskManagerPosix(const std::string &db_file, bool direct_io, size_t sync_interval, size_t page_size,
+                   FileFormat file_format);
+
+  /** Count a completed page write, and sync the file if sync_interval writes have not been synced. */
+  void CountWrite();
+
+  /** File descriptor of the database file, -1 once it is closed. */
+  int fd_{-1};
+  bool direct_io_;
+
+ private:
+  size_t sync_interval_;
+  /** Page writes since the last fdatasync. */
+  std::atomic<size_t> unsynced_writes_{0};
+};
+
+}  // namespace bustub
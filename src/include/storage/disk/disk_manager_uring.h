@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.h
+//
+// Identification: src/include/storage/disk/disk_manager_uring.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager_posix.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerUring executes batches of page reads and writes through Linux io_uring, submitting and reaping a whole
+ * batch with a single io_uring_enter(2) call. Page buffers announced with RegisterBuffers() are registered with the
+ * kernel and accessed with fixed-buffer reads and writes, which saves mapping them on every request.
+ *
+ * Several rings are used so that concurrent batches do not serialize on one submission queue. If io_uring is not
+ * available, because the kernel headers were missing at build time or the kernel refuses to set up a ring, it falls
+ * back to the pread/pwrite path of DiskManagerPosix, see IsUringEnabled().
+ */
+class DiskManagerUring : public DiskManagerPosix {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io whether to open the file with O_DIRECT
+   * @param sync_interval the number of page writes between two fdatasync calls, 0 to only sync on Sync() and ShutDown()
+   * @param num_rings the number of rings that batches can be submitted on concurrently
+   * @param page_size the page size of a new database file, see DiskManager::DiskManager()
+   */
+  explicit DiskManagerUring(const std::string &db_file, bool direct_io = false,
+                            size_t sync_interval = DISK_SYNC_INTERVAL, size_t num_rings = DISK_SCHEDULER_WORKERS,
+                            size_t page_size = BUSTUB_PAGE_SIZE);
+
+  ~DiskManagerUring() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void ExecuteBatch(const std::vector<DiskIo> &batch) override;
+
+  /**
+   * Register the page buffers with every ring. Only the first call has an effect, and it is ignored if the kernel
+   * refuses the registration, e.g. because it exceeds RLIMIT_MEMLOCK.
+   */
+  void RegisterBuffers(const std::vector<char *> &buffers) override;
+
+  void UnregisterBuffers() override;
+
+  /** @return true if batches are executed through io_uring, false if they fall back to pread/pwrite */
+  auto IsUringEnabled() const -> bool { return !rings_.empty(); }
+
+  /** @return the number of io_uring_enter calls made so far */
+  auto GetNumSubmissions() const -> size_t { return num_submissions_.load(); }
+
+ private:
+  /** Number of entries of the submission queue of every ring, larger batches are submitted in chunks. */
+  static constexpr unsigned RING_ENTRIES = 64;
+
+  struct Ring;
+
+  /**
+   * Submit a chunk of requests for distinct pages on the ring and wait for all of them. Requests that fail or complete
+   * short are redone with pread/pwrite. Caller must hold buffers_latch_ shared and the latch of the ring.
+   */
+  void SubmitAndWait(Ring *ring, const DiskIo *ios, size_t count);
+
+  std::vector<std::unique_ptr<Ring>> rings_;
+  /** Protects buffer_index_. Taken before the latch of any ring. */
+  std::shared_mutex buffers_latch_;
+  /** Index of every registered buffer, empty if no buffers are registered. */
+  std::unordered_map<const char *, int> buffer_index_;
+  std::atomic<size_t> num_submissions_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * @brief Represents a Write or Read request for the DiskManager to execute.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+
+  /**
+   *  Pointer to the start of the memory location where a page is either:
+   *   1. being read into from disk (on a read).
+   *   2. being written out to disk (on a write).
+   */
+  char *data_;
+
+  /** ID of the page being read from / written to disk. */
+  page_id_t page_id_;
+
+  /** Callback used to signal to the request issuer when the request has been completed. */
+  std::promise<bool> callback_;
+
+  /**
+   * Optional function the worker invokes with the outcome of the request before setting callback_, for requests that
+   * nobody waits for (e.g. prefetches). It must not throw.
+   */
+  std::function<void(bool)> on_complete_{};
+};
+
+/**
+ * @brief The DiskScheduler schedules disk read and write operations.
+ *
+ * A request is scheduled by calling DiskScheduler::Schedule() with an appropriate DiskRequest object. The scheduler
+ * maintains a queue of requests that is drained by a pool of worker threads. A worker that picks up a request also
+ * takes every queued request for an adjacent page id, and hands the run of consecutive pages to the DiskManager as
+ * one batch in ascending order. Requests scheduled together with ScheduleBatch() always form one batch. Several
+ * batches are in flight at once.
+ *
+ * Requests for the same page that are queued at the same time are executed in the order they were scheduled.
+ * Otherwise, a request is only ordered after the requests whose completion the issuer waited for.
+ */
+class DiskScheduler {
+ public:
+  /**
+   * @brief Creates a new DiskScheduler and starts its workers.
+   * @param disk_manager the disk manager that executes the requests
+   * @param num_workers the number of worker threads
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t num_workers = DISK_SCHEDULER_WORKERS);
+
+  /** @brief Executes every request that is still queued, then stops the workers. */
+  ~DiskScheduler();
+
+  /**
+   * @brief Schedules a request for the DiskManager to execute. The callback of the request is set to true once the
+   * request is completed, or to the exception thrown by the DiskManager. on_complete_ is invoked with true or false
+   * respectively.
+   * @param r the request to be scheduled
+   */
+  void Schedule(DiskRequest r);
+
+  /**
+   * @brief Schedules requests that are executed together as one DiskManager batch, e.g. the pages of a flush.
+   * @param requests the requests to be scheduled
+   */
+  void ScheduleBatch(std::vector<DiskRequest> requests);
+
+  /**
+   * @brief Create a Promise object. If you want to implement your own version of promise, you can change this function
+   * so that our test cases can use your promise implementation.
+   * @return std::promise<bool>
+   */
+  auto CreatePromise() -> std::promise<bool> { return {}; };
+
+ private:
+  /** The longest run of adjacent pages a worker takes at once, so that one worker cannot starve the others. */
+  static constexpr size_t MAX_RUN_LENGTH = 64;
+
+  /** @brief The loop of a worker thread, runs until the scheduler is destroyed and the queue is drained. */
+  void StartWorkerThread();
+
+  /**
+   * @brief Take the batch at the front of the queue. If it is a single request, also take every queued single
+   * request for an adjacent page id. Caller must hold latch_.
+   * @return the requests, sorted by page id and otherwise in scheduling order
+   */
+  auto TakeRun() -> std::vector<DiskRequest>;
+
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_;
+  /** Protects queue_ and stop_. */
+  std::mutex latch_;
+  /** Signalled when a request is queued or the scheduler stops. */
+  std::condition_variable cv_;
+  /** The batches that have not been picked up by a worker yet, in scheduling order. */
+  std::deque<std::vector<DiskRequest>> queue_;
+  bool stop_{false};
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
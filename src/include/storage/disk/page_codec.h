@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.h
+//
+// Identification: src/include/storage/disk/page_codec.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * PageCodec compresses pages with an LZ77 byte codec in the LZ4 block format: a page is encoded as a sequence of
+ * literal runs, each followed by a back reference of at least 4 bytes into the previous 64KB. Pages full of repeated
+ * values, e.g. VARCHARs that share prefixes or whole values, and the zeroed free space of a page shrink a lot, and
+ * decompression is a simple copy loop.
+ */
+class PageCodec {
+ public:
+  /** @return the largest size Compress() may need for an input of size bytes */
+  static constexpr auto MaxCompressedSize(size_t size) -> size_t { return size + size / 255 + 16; }
+
+  /**
+   * @brief Compress a page.
+   * @param src the data to compress
+   * @param size the size of src
+   * @param[out] dst the buffer for the compressed data
+   * @param capacity the size of dst
+   * @return the compressed size, or 0 if the compressed data does not fit into capacity bytes
+   */
+  static auto Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * @brief Decompress a page compressed by Compress(). Corrupt input is detected, it never makes the codec read or
+   * write out of bounds.
+   * @param src the compressed data
+   * @param size the size of src
+   * @param[out] dst the buffer for the page
+   * @param page_size the size of the page, i.e. of dst
+   * @return false if src is corrupt or does not decompress to exactly page_size bytes
+   */
+  static auto Decompress(const char *src, size_t size, char *dst, size_t page_size) -> bool;
+};
+
+}  // namespace bustub
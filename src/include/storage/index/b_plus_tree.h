@@ -11,12 +11,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/config.h"
@@ -53,12 +56,16 @@ class Context {
   // You may want to use this when getting value, but not necessary.
   std::deque<ReadPageGuard> read_set_;
 
+  // The new pages for the splits of an insert, allocated before any page is modified, in the order they are taken.
+  std::deque<std::pair<page_id_t, BasicPageGuard>> new_pages_;
+
   auto IsRootPage(page_id_t page_id) -> bool { return page_id == root_page_id_; }
 };
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
-// Main class providing the API for the Interactive B+ Tree.
+// Main class providing the API for the Interactive B+ Tree. An operation that cannot fetch or allocate a page throws an
+// Exception, see PinPage(). The tree is left as it was then, except that a BulkLoad() leaves it empty.
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
@@ -75,12 +82,42 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *txn = nullptr) -> bool;
 
+  /**
+   * @brief Insert many pairs at once. The pairs are sorted by key, and every descent inserts all the following pairs
+   * that belong to the same leaf, also when the leaf is split on the latch crabbing path, so clustered keys take one
+   * descent per leaf instead of one per key. Of pairs with equal keys, only the first is inserted.
+   * @return the number of pairs inserted, the others have a key that is already in the tree
+   */
+  auto InsertBatch(std::vector<std::pair<KeyType, ValueType>> pairs, Transaction *txn = nullptr) -> size_t;
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *txn);
 
+  /**
+   * @brief Build the empty tree bottom up from pairs sorted by key, which is much faster than inserting them one by
+   * one: every page is written once, in key order, and no page is split. The leaves and then every level of inner
+   * pages are filled to fill_factor of their max size, leaving room for later inserts. Of pairs with equal keys, only
+   * the first is kept, like Insert() does.
+   *
+   * @param next yields the next pair into *key and *value, or returns false at the end of the input
+   * @param fill_factor the share of each page that is filled, in (0, 1]
+   * @return false if the tree is not empty, or if the keys are not sorted, in which case it is left empty
+   */
+  auto BulkLoad(const std::function<bool(KeyType *key, ValueType *value)> &next,
+                double fill_factor = BTREE_FILL_FACTOR) -> bool;
+
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
+  /**
+   * @brief Look up many keys at once. The keys are looked up in key order, and every descent serves all the following
+   * keys up to the last key of the leaf it reached.
+   * @param[out] result the value of keys[i] in (*result)[i], or std::nullopt if it is not in the tree
+   * @return the number of keys found
+   */
+  auto GetValueBatch(const std::vector<KeyType> &keys, std::vector<std::optional<ValueType>> *result,
+                     Transaction *txn = nullptr) -> size_t;
+
   // Return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
@@ -128,6 +165,149 @@ class BPlusTree {
   void BatchOpsFromFile(const std::string &file_name, Transaction *txn = nullptr);
 
  private:
+  /** The outcome of DescendOptimistic(). */
+  enum class Descent {
+    /** The leaf was reached. */
+    Leaf,
+    /** The tree has no root. */
+    Empty,
+    /** A page on the path changed while it was read, the descent has to start over. */
+    Restart,
+    /** All frames of the buffer pool were pinned, the descent has to start over once one is free. */
+    NoFrame
+  };
+
+  /** The structure modification an operation may cause, see IsSafe(). */
+  enum class Operation { Insert, Remove };
+
+  /**
+   * @brief Descend from the header page to the leaf that key belongs to without latching any inner page. Every inner
+   * page is read through an OptimisticPageGuard, and validated before the child read from it is followed and again
+   * after the version of the child was taken, so that the child is still the one its parent points to.
+   *
+   * When all frames of the buffer pool are pinned, the pins of the path are released and the descent starts over,
+   * waiting for a frame up to FRAME_WAIT_RETRIES times, so Descent::NoFrame is never returned.
+   *
+   * @param[out] leaf the guard of the leaf: an OptimisticPageGuard, or a ReadPageGuard or WritePageGuard to latch it
+   * @throws Exception if a page cannot be read from disk, or no frame became free
+   */
+  template <class LeafGuard>
+  auto DescendOptimistic(const KeyType &key, LeafGuard *leaf) -> Descent;
+
+  /**
+   * @brief A single try of DescendOptimistic().
+   * @param[out] no_frame_page_id the page that found all frames pinned, if Descent::NoFrame is returned
+   */
+  template <class LeafGuard>
+  auto TryDescendOptimistic(const KeyType &key, LeafGuard *leaf, page_id_t *no_frame_page_id) -> Descent;
+
+  /**
+   * @brief Descend from the root to the leaf that key belongs to with latch crabbing. Every page on the path is write
+   * latched, and the latches of its ancestors and the header page are released as soon as it is safe for op. The
+   * header page must be latched and ctx->root_page_id_ set.
+   */
+  void DescendPessimistic(const KeyType &key, Operation op, Context *ctx);
+
+  /** @return true if op cannot split or merge the page, so that its ancestors are not modified */
+  auto IsSafe(const BPlusTreePage *page, Operation op, bool is_root) const -> bool;
+
+  /** The pairs of an InsertBatch() call and how far it got. */
+  struct InsertBatchCursor {
+    const std::vector<std::pair<KeyType, ValueType>> *pairs_;
+    /** The next pair to insert. */
+    size_t next_;
+    /** The number of pairs inserted so far. */
+    size_t inserted_;
+  };
+
+  /**
+   * @brief Insert by latch crabbing, used when the leaf has to split. With a batch, the following pairs that belong to
+   * the leaf, or to the two leaves it was split into, are inserted as well while they are latched.
+   */
+  auto InsertPessimistic(const KeyType &key, const ValueType &value, InsertBatchCursor *batch = nullptr) -> bool;
+
+  /**
+   * @brief Insert the pairs of a batch from batch->next_ on into leaf, which must be write latched, as long as it has
+   * room and their keys are less than upper, or equal to it if inclusive. A null upper means the leaf has no upper
+   * bound. The cursor is advanced past the pairs handled.
+   * @return false if the leaf filled up before the first pair that does not belong to it
+   */
+  auto InsertRun(LeafPage *leaf, const KeyType *upper, bool inclusive, InsertBatchCursor *batch) -> bool;
+
+  /**
+   * @brief Allocate the new pages that the splits of an insert may take into ctx->new_pages_, once ctx->write_set_ is
+   * latched and before any page is modified, so that an insert that cannot allocate them leaves the tree as it was.
+   * @throws Exception if a page cannot be allocated, after freeing the pages allocated so far
+   */
+  void AllocateSplitPages(Context *ctx);
+
+  /** @brief Take the next page allocated by AllocateSplitPages(). */
+  auto TakeSplitPage(Context *ctx, page_id_t *page_id) -> BasicPageGuard;
+
+  /** @brief Delete the pages allocated by AllocateSplitPages() that no split took. */
+  void FreeSplitPages(Context *ctx);
+
+  /**
+   * @brief Link right_id, split off from left_id, into the parent of left_id, splitting the parent if it is full.
+   * @param level the index of left_id in ctx->write_set_
+   */
+  void InsertIntoParent(Context *ctx, size_t level, page_id_t left_id, const KeyType &key, page_id_t right_id);
+
+  /** @brief Remove by latch crabbing, used when the leaf underflows. */
+  void RemovePessimistic(const KeyType &key);
+
+  /**
+   * @brief Pin the sibling of every page of ctx->write_set_ that Rebalance() may borrow from or merge with, before the
+   * key is removed, so that latching them later cannot fail and leave the tree half rebalanced.
+   * @throws Exception if a sibling cannot be fetched
+   */
+  auto PinSiblings(Context *ctx) -> std::vector<BasicPageGuard>;
+
+  /**
+   * @brief Fix an underflow of the page at level of ctx->write_set_ by borrowing from or merging with a sibling, and
+   * continue with the parent. Pages that are merged away are collected in deleted, to be deleted once unlatched.
+   */
+  void Rebalance(Context *ctx, size_t level, std::vector<page_id_t> *deleted);
+
+  /**
+   * @brief Read page_id optimistically. A page with a swizzled reference is read straight from its frame, without the
+   * page table lookup, latch and pin of the buffer pool, any other page is fetched and pinned.
+   *
+   * @param[out] frame_id the frame of the page if it was fetched from the buffer pool, so that the caller can
+   * Swizzle() it, or -1 if it was read through its swizzled reference
+   * @param[out] no_frame set to whether std::nullopt is returned because the buffer pool has all of its frames pinned
+   * @return std::nullopt if the page had to be fetched but the buffer pool has all of its frames pinned, or if a writer
+   * holds its write latch
+   * @throws Exception if the page cannot be read from disk
+   */
+  auto FetchOptimistic(page_id_t page_id, frame_id_t *frame_id, bool *no_frame) -> std::optional<OptimisticPageGuard>;
+
+  /** @brief Swizzle the references to page_id, which was found in frame_id. Does nothing if frame_id is -1. */
+  void Swizzle(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Pin page_id. The buffer pool runs out of frames when the threads in the tree pin them all, so wait until one
+   * of them unpins a page, up to FRAME_WAIT_RETRIES times.
+   * @throws Exception if the page cannot be read from disk, or no frame became free
+   */
+  auto PinPage(page_id_t page_id) const -> Page *;
+
+  /** @throws Exception for page_id, which the buffer pool failed to fetch */
+  [[noreturn]] void FetchFailed(page_id_t page_id, bool io_failed) const;
+
+  /** @brief Pin and read latch page_id, waiting for a free frame like PinPage(). */
+  auto FetchRead(page_id_t page_id) const -> ReadPageGuard;
+
+  /** @brief Pin and write latch page_id, waiting for a free frame like PinPage(). */
+  auto FetchWrite(page_id_t page_id) const -> WritePageGuard;
+
+  /**
+   * @brief Allocate a new page, waiting for a free frame like PinPage(). A freed page id close to hint is preferred,
+   * see BufferPoolManager::NewPage().
+   * @throws Exception if the page of the frame cannot be written back, or no frame became free
+   */
+  auto NewPage(page_id_t *page_id, page_id_t hint = INVALID_PAGE_ID) const -> BasicPageGuard;
+
   /* Debug Routines for FREE!! */
   void ToGraph(page_id_t page_id, const BPlusTreePage *page, std::ofstream &out);
 
@@ -148,7 +328,15 @@ class BPlusTree {
   std::vector<std::string> log;  // NOLINT
   int leaf_max_size_;
   int internal_max_size_;
+  /** The bytes of a page, which bound the keys an inner page holds besides internal_max_size_. */
+  int page_size_;
   page_id_t header_page_id_;
+  /**
+   * Swizzled references to the header page and the inner pages, i.e. the frames they were last found in. Slot
+   * `page_id % BTREE_SWIZZLE_SLOTS` holds `(frame_id + 1) << 32 | page_id`, or 0 if it is empty. A slot may be stale,
+   * the buffer pool checks that the frame still holds the page, see BufferPoolManager::FetchPageSwizzled().
+   */
+  std::vector<std::atomic<uint64_t>> swizzled_;
 };
 
 /**
@@ -14,6 +14,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "container/hash/hash_function.h"
@@ -35,6 +36,13 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * @brief Fill the empty index with entries in any order. They are sorted and the tree is built bottom up, see
+   * BPlusTree::BulkLoad(). Of entries with equal keys, the first one is kept, as InsertEntry() would.
+   * @return false if the index is not empty
+   */
+  auto BulkLoad(std::vector<std::pair<KeyType, ValueType>> entries, Transaction *transaction) -> bool;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 
 #include "storage/table/tuple.h"
@@ -19,48 +20,64 @@
 
 namespace bustub {
 
+/**
+ * @brief Write the columns of key, a tuple of key_schema, to data as a normalized key of size bytes, whose bytes
+ * compare with memcmp in the order of the columns:
+ *
+ * - integers, booleans and timestamps are stored big-endian, signed ones with their sign bit flipped
+ * - decimals are stored like integers, with all their bits flipped if they are negative
+ * - varchars are stored byte by byte, with zero bytes escaped as 0x00 0xFF and followed by 0x00 0x01, or stored as
+ *   0x00 0x00 if they are null
+ *
+ * The null value of a fixed size type is the least (or, for timestamps, the greatest) value of the type, so it is
+ * stored like that value. The rest of data is zeroed. A key that does not fit is cut off after size bytes, so keys that
+ * only differ past that compare equal.
+ */
+void NormalizeKey(const Tuple &key, const Schema &key_schema, char *data, size_t size);
+
+/** @brief Read column column_idx back from a key normalized with key_schema, see NormalizeKey(). */
+auto DenormalizeKeyColumn(const char *data, size_t size, const Schema &key_schema, uint32_t column_idx) -> Value;
+
 /**
  * Generic key is used for indexing with opaque data.
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
- * with a template argument.
+ * with a template argument. The data is a normalized key, see NormalizeKey().
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
-    // initialize to 0
-    memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
+    NormalizeKey(tuple, key_schema, data_, KeySize);
   }
 
   // NOTE: for test purpose only
+  // store key as a normalized BIGINT column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    uint64_t bits = static_cast<uint64_t>(key) ^ (uint64_t{1} << 63);
+    for (size_t i = 0; i < sizeof(int64_t) && i < KeySize; i++) {
+      data_[i] = static_cast<char>(bits >> (56 - 8 * i));
+    }
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
-    }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return DenormalizeKeyColumn(data_, KeySize, *schema, column_idx);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as a normalized BIGINT column
+  inline auto ToString() const -> int64_t {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < sizeof(int64_t) && i < KeySize; i++) {
+      bits |= static_cast<uint64_t>(static_cast<uint8_t>(data_[i])) << (56 - 8 * i);
+    }
+    return static_cast<int64_t>(bits ^ (uint64_t{1} << 63));
+  }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // interpret the first 8 bytes as a normalized BIGINT column
   friend auto operator<<(std::ostream &os, const GenericKey &key) -> std::ostream & {
     os << key.ToString();
     return os;
@@ -77,30 +94,16 @@ template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    // Normalized keys compare column by column as their bytes do.
+    int order = memcmp(lhs.data_, rhs.data_, KeySize);
+    return static_cast<int>(order > 0) - static_cast<int>(order < 0);
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
-
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
-
- private:
-  Schema *key_schema_;
+  /**
+   * The keys are normalized by SetFromKey(), so comparing them needs no schema. The key schema is still taken, as the
+   * indexes construct every key comparator from one.
+   */
+  explicit GenericComparator(Schema * /* key_schema */) {}
 };
 
 }  // namespace bustub
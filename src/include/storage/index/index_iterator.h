@@ -13,31 +13,65 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <optional>
+
+#include "buffer/read_ahead.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaf pages of a B+ tree from left to right. It holds the read latch of the leaf it is
+ * positioned on, and latches the next leaf before it releases the current one. The leaves it visits are reported to a
+ * SequentialReadAhead, so that a scan over leaves laid out one after another, e.g. by a bulk load, reads them ahead.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** The end iterator. */
   IndexIterator();
+
+  /** An iterator positioned at index of the latched leaf page, or the first pair after it if index is past the end. */
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index);
+
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator & = default;
+
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() -> bool;
 
+  /** @return the pair the iterator is positioned on, rebuilt from its leaf and valid until the iterator moves */
   auto operator*() -> const MappingType &;
 
+  /** @throws Exception if the next leaf cannot be fetched, the iterator is at its end afterwards */
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return page_id_ == itr.page_id_ && (page_id_ == INVALID_PAGE_ID || index_ == itr.index_);
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /**
+   * Move to the next leaf while the iterator is past the end of its leaf, waiting for a free frame up to
+   * FRAME_WAIT_RETRIES times like BPlusTree does.
+   */
+  void SkipExhaustedLeaves();
+
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard guard_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int index_{0};
+  /** The pair operator*() returns, the leaf stores it compressed. */
+  MappingType item_;
+  /** Empty for the end iterator, which has no buffer pool. */
+  std::optional<SequentialReadAhead> read_ahead_;
 };
 
 }  // namespace bustub
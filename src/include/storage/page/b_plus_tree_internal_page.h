@@ -10,16 +10,21 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <cstdint>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-enum { INTERNAL_PAGE_HEADER_SIZE = 12 };
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+enum { INTERNAL_PAGE_HEADER_SIZE = 20, INTERNAL_PAGE_SLOT_SIZE = 8 };
+#define INTERNAL_PAGE_SLOT_CNT(page_size) (((page_size)-INTERNAL_PAGE_HEADER_SIZE) / INTERNAL_PAGE_SLOT_SIZE)
+#define INTERNAL_PAGE_SIZE INTERNAL_PAGE_SLOT_CNT(BUSTUB_PAGE_SIZE)
+// how many children a split of num_children may move off the most even split, to move up a shorter key
+#define INTERNAL_PAGE_SPLIT_INTERVAL(num_children) ((num_children) / 16)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -28,10 +33,28 @@ enum { INTERNAL_PAGE_HEADER_SIZE = 12 };
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * Keys are stored without their trailing zero bytes, which the zero padded keys of GenericKey have plenty of, so a page
+ * holds as many children as their keys leave room for, up to max size. Every child has a slot with its page id and the
+ * offset and length of its key, the keys are packed at the end of the page in the order of the slots.
+ *
+ * The keys are separators rather than copies of the first keys of the children: a split leaf is separated from the
+ * new one by the shortest prefix that tells their keys apart (see Separator()), and a split internal page moves up
+ * the shortest key near its middle. Leaves store the prefix that their keys share once instead, see BPlusTreeLeafPage.
+ *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | SLOT(n) | free space | KEY(n) | ... | KEY(2) | KEY(1) |
+ *  ---------------------------------------------------------------------------------------
+ *
+ * Header format (size in byte, 20 bytes in total):
+ *  ---------------------------------------------------------------------------
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | PageSize (4) | KeyBytes (4) |
+ *  ---------------------------------------------------------------------------
+ *
+ * Slot format (size in byte, 8 bytes in total):
+ *  --------------------------------------------
+ * | PAGE_ID (4) | KeyOffset (2) | KeyLength (2) |
+ *  --------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -43,18 +66,19 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   /**
    * Writes the necessary header information to a newly created page, must be called after
    * the creation of a new page to make a valid BPlusTreeInternalPage
-   * @param max_size Maximal size of the page
+   * @param max_size Maximal size of the page, at most INTERNAL_PAGE_SLOT_CNT(page_size)
+   * @param page_size the bytes of the page
    */
-  void Init(int max_size = INTERNAL_PAGE_SIZE);
+  void Init(int max_size = INTERNAL_PAGE_SIZE, int page_size = BUSTUB_PAGE_SIZE);
 
   /**
-   * @param index The index of the key to get. Index must be non-zero.
+   * @param index The index of the key to get. The key at index zero is invalid.
    * @return Key at index
    */
   auto KeyAt(int index) const -> KeyType;
 
   /**
-   *
+   * The page must have room for the key, see CanSetKeyAt().
    * @param index The index of the key to set. Index must be non-zero.
    * @param key The new value for key
    */
@@ -73,6 +97,111 @@ class BPlusTreeInternalPage : public BPlusTreePage {
    */
   auto ValueAt(int index) const -> ValueType;
 
+  /**
+   * @param index the index
+   * @param value the new value
+   */
+  void SetValueAt(int index, const ValueType &value);
+
+  /** @return the number of bytes of key that are stored, i.e. up to its last non-zero byte */
+  static auto KeyLength(const KeyType &key) -> int;
+
+  /**
+   * @return the key with the fewest stored bytes that is greater than left and not greater than right, to separate a
+   * page whose last key is left from the next page, whose first key is right. Keys compare like their bytes do, see
+   * GenericComparator.
+   */
+  static auto Separator(const KeyType &left, const KeyType &right) -> KeyType;
+
+  /** @return the bytes taken by the header, the slots and the keys of the page */
+  auto GetUsedBytes() const -> int {
+    return INTERNAL_PAGE_HEADER_SIZE + GetSize() * INTERNAL_PAGE_SLOT_SIZE + key_bytes_;
+  }
+
+  /** @return true if one more child, with a key of key_length bytes, fits into the page */
+  auto HasRoomFor(int key_length) const -> bool {
+    return GetSize() < GetMaxSize() && GetUsedBytes() + INTERNAL_PAGE_SLOT_SIZE + key_length <= page_size_;
+  }
+
+  /** @return true if the key at index can be replaced by key without overflowing the page */
+  auto CanSetKeyAt(int index, const KeyType &key) const -> bool;
+
+  /** @return true if the page has at least min size children, or fills at least half of its bytes */
+  auto IsHalfFull() const -> bool { return GetSize() >= GetMinSize() || 2 * GetUsedBytes() >= page_size_; }
+
+  /** @return true if the page is still half full after any one of its children is removed */
+  auto CanSpare() const -> bool {
+    return GetSize() > GetMinSize() ||
+           2 * (GetUsedBytes() - INTERNAL_PAGE_SLOT_SIZE - static_cast<int>(sizeof(KeyType))) >= page_size_;
+  }
+
+  /** @return true if the children of this page fit into recipient, behind its own and separated by middle_key */
+  auto FitsInto(const BPlusTreeInternalPage *recipient, const KeyType &middle_key) const -> bool;
+
+  /** @return the index of the child that key belongs to */
+  auto ChildIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+    return ChildIndex(key, comparator, GetSize(), page_size_);
+  }
+
+  /**
+   * @brief ChildIndex() among the first size children of a page of page_size bytes. Optimistic readers read the size
+   * once, check that it is in bounds and pass it here along with the page size of the buffer pool, since the header may
+   * change under them. Keys that point outside of page_size bytes are read as empty keys.
+   */
+  auto ChildIndex(const KeyType &key, const KeyComparator &comparator, int size, int page_size) const -> int;
+
+  /** @return the child that key belongs to */
+  auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
+    return Lookup(key, comparator, GetSize(), page_size_);
+  }
+
+  /** @brief Lookup() among the first size children of a page of page_size bytes, see ChildIndex(). */
+  auto Lookup(const KeyType &key, const KeyComparator &comparator, int size, int page_size) const -> ValueType {
+    return Slots()[ChildIndex(key, comparator, size, page_size)].value_;
+  }
+
+  /** @brief Turn this empty page into a root with the two children old_value and new_value, separated by key. */
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &key, const ValueType &new_value);
+
+  /** @brief Insert key and the child new_value right after the child old_value. The page must have room for key. */
+  void InsertNodeAfter(const ValueType &old_value, const KeyType &key, const ValueType &new_value);
+
+  /**
+   * @brief Append key and the child value behind the last child. The page must have room for key, which is dropped if
+   * value is the first child.
+   */
+  void Append(const KeyType &key, const ValueType &value);
+
+  /** @brief Remove the key and child at index. */
+  void Remove(int index);
+
+  /**
+   * @brief Insert key and the child new_value right after the child old_value into this page, which has no room for
+   * it, and move the upper part of the children to the empty page recipient so that both fill about the same bytes.
+   * Among the splits within INTERNAL_PAGE_SPLIT_INTERVAL of the most even one, the one with the shortest key is taken.
+   * @return the key that separates this page from recipient
+   */
+  auto InsertAndSplitTo(const ValueType &old_value, const KeyType &key, const ValueType &new_value,
+                        BPlusTreeInternalPage *recipient) -> KeyType;
+
+  /**
+   * @brief Append all children to recipient, the previous page, separated from it by middle_key. They must fit, see
+   * FitsInto().
+   */
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+
+  /**
+   * @brief Move the first child to the end of recipient, the previous page, separated from it by middle_key.
+   * @return the new key that separates recipient from this page
+   */
+  auto MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) -> KeyType;
+
+  /**
+   * @brief Move the last child to the front of recipient, the next page, separated from it by middle_key.
+   * @return the new key that separates this page from recipient
+   */
+  auto MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) -> KeyType;
+
   /**
    * @brief For test only, return a string representing all keys in
    * this internal page, formatted as "(key1,key2,key3,...)"
@@ -100,7 +229,30 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   }
 
  private:
-  // Flexible array member for page data.
-  MappingType array_[0];
+  /** The child and the place of its key in the page. */
+  struct Slot {
+    ValueType value_;
+    uint16_t key_offset_;
+    uint16_t key_length_;
+  };
+  static_assert(sizeof(Slot) == INTERNAL_PAGE_SLOT_SIZE);
+
+  auto Slots() const -> const Slot * { return reinterpret_cast<const Slot *>(data_); }
+  auto Slots() -> Slot * { return reinterpret_cast<Slot *>(data_); }
+
+  /** @brief Read the key of slot, as an empty key if it does not lie within page_size bytes. */
+  auto ReadKey(const Slot &slot, int page_size) const -> KeyType;
+
+  /** @return all children of the page with their keys */
+  auto GetItems() const -> std::vector<MappingType>;
+
+  /** @brief Replace the children of the page by items, rewriting the keys so that they are packed again. */
+  void SetItems(const std::vector<MappingType> &items);
+
+  int page_size_;
+  /** The bytes taken by the keys at the end of the page. */
+  int key_bytes_;
+  // Flexible array member for the slots, followed by free space and the keys.
+  char data_[0];
 };
 }  // namespace bustub
@@ -0,0 +1,158 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search.h
+//
+// Identification: src/include/storage/page/b_plus_tree_key_search.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+/**
+ * Tells whether keys of KeyType order under KeyComparator like unsigned integers, so that B+ tree pages can search
+ * them without calling the comparator, see SearchIntegers(). Other key types keep the binary search over the
+ * comparator.
+ */
+template <typename KeyType, typename KeyComparator>
+struct IntegerKey {
+  static constexpr bool IS_INTEGER = false;
+};
+
+/** A GenericKey<8> is normalized, its bytes are a big-endian integer that orders like the key, see NormalizeKey(). */
+template <>
+struct IntegerKey<GenericKey<8>, GenericComparator<8>> {
+  static constexpr bool IS_INTEGER = true;
+  static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "keys are byte swapped on load");
+
+  /** @return the integer of the key whose first length bytes are at data, and whose other bytes are zero */
+  static auto Read(const char *data, size_t length = sizeof(GenericKey<8>)) -> uint64_t {
+    uint64_t bits = 0;
+    memcpy(&bits, data, length);
+    return __builtin_bswap64(bits);
+  }
+};
+
+/** The number of keys the binary search of SearchIntegers() narrows the keys down to, they span a few cache lines. */
+static constexpr int KEY_SEARCH_BLOCK = 16;
+
+/** @brief Count the n integers get(0) to get(n - 1) that are less than target, or not greater than it if inclusive. */
+template <typename Get>
+inline auto CountIntegers(int n, uint64_t target, bool inclusive, const Get &get) -> int {
+  int count = 0;
+  for (int i = 0; i < n; i++) {
+    uint64_t key = get(i);
+    count += static_cast<int>(key < target || (inclusive && key == target));
+  }
+  return count;
+}
+
+/**
+ * @brief Search n sorted integers, get(i) being the i-th, without branches: a binary search whose steps are
+ * conditional moves narrows them down to KEY_SEARCH_BLOCK, which count(base, num, target, inclusive) counts like
+ * CountIntegers() in a linear scan.
+ * @return the number of integers less than target, or not greater than it if inclusive
+ */
+template <typename Get, typename Count>
+inline auto SearchIntegers(int n, uint64_t target, bool inclusive, const Get &get, const Count &count) -> int {
+  int base = 0;
+  while (n > KEY_SEARCH_BLOCK) {
+    int half = n / 2;
+    uint64_t key = get(base + half);
+    base = key < target || (inclusive && key == target) ? base + half : base;
+    n -= half;
+  }
+  return base + count(base, n, target, inclusive);
+}
+
+/** @brief SearchIntegers() with a scalar scan of the last block. */
+template <typename Get>
+inline auto SearchIntegers(int n, uint64_t target, bool inclusive, const Get &get) -> int {
+  return SearchIntegers(n, target, inclusive, get, [&get](int base, int num, uint64_t bound, bool incl) {
+    return CountIntegers(num, bound, incl, [&get, base](int i) { return get(base + i); });
+  });
+}
+
+/**
+ * @brief CountIntegers() of the keys of n pairs of 16 bytes at pairs, a GenericKey<8> and an 8 byte value each. With
+ * AVX2, four keys are compared at once: they are gathered from two loads, byte swapped, and compared as signed
+ * integers with their sign bits flipped.
+ */
+inline auto CountPairKeys(const char *pairs, int n, uint64_t target, bool inclusive) -> int {
+  int count = 0;
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256i swap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                        15, 14, 13, 12, 11, 10, 9, 8);
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i bound = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(target)), sign);
+  for (; i + 4 <= n; i += 4) {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs + 16 * i));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pairs + 16 * (i + 2)));
+    __m256i keys = _mm256_xor_si256(_mm256_shuffle_epi8(_mm256_unpacklo_epi64(low, high), swap), sign);
+    if (inclusive) {
+      count += 4 - __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(keys, bound))));
+    } else {
+      count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(bound, keys))));
+    }
+  }
+#endif
+  return count + CountIntegers(n - i, target, inclusive, [pairs, i](int j) {
+           return IntegerKey<GenericKey<8>, GenericComparator<8>>::Read(pairs + 16 * (i + j));
+         });
+}
+
+/**
+ * @brief Binary search of the size sorted pairs at array through comparator.
+ * @return the index of the first pair whose key is not less than key, or greater than it if inclusive
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto BinarySearchPairs(const std::pair<KeyType, ValueType> *array, int size, const KeyType &key,
+                       const KeyComparator &comparator, bool inclusive) -> int {
+  int left = 0;
+  int right = size;
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    int order = comparator(array[mid].first, key);
+    if (order < 0 || (inclusive && order == 0)) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+/** @brief BinarySearchPairs(), or SearchIntegers() with CountPairKeys() for pairs of integer keys and RIDs. */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto SearchPairs(const std::pair<KeyType, ValueType> *array, int size, const KeyType &key,
+                 const KeyComparator &comparator, bool inclusive) -> int {
+  if constexpr (IntegerKey<KeyType, KeyComparator>::IS_INTEGER && sizeof(std::pair<KeyType, ValueType>) == 16) {
+    auto pairs = reinterpret_cast<const char *>(array);
+    auto read = [pairs](int i) { return IntegerKey<KeyType, KeyComparator>::Read(pairs + 16 * i); };
+    auto count = [pairs](int base, int num, uint64_t bound, bool incl) {
+      return CountPairKeys(pairs + 16 * base, num, bound, incl);
+    };
+    uint64_t target = IntegerKey<KeyType, KeyComparator>::Read(reinterpret_cast<const char *>(&key));
+    return SearchIntegers(size, target, inclusive, read, count);
+  } else {
+    return BinarySearchPairs(array, size, key, comparator, inclusive);
+  }
+}
+
+}  // namespace bustub
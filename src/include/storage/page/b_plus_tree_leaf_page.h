@@ -14,30 +14,40 @@
 #include <utility>
 #include <vector>
 
+#include "storage/page/b_plus_tree_key_search.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 16
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 24
+// the most pairs a leaf page holds, when their keys differ in their last byte only
+#define LEAF_PAGE_SLOT_CNT(page_size) (((page_size)-LEAF_PAGE_HEADER_SIZE) / (sizeof(ValueType) + 1))
+#define LEAF_PAGE_SIZE LEAF_PAGE_SLOT_CNT(BUSTUB_PAGE_SIZE)
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
+ * Keys are prefix compressed: the bytes that all keys of the page start with are stored once, behind the header, and
+ * every slot stores the rest of its key followed by its value. All slots of a page have the same width, so they are
+ * still found by their index, and a page holds as many pairs as their slots leave room for, up to max size. The prefix
+ * only shrinks, when a key that does not start with it is inserted, which rewrites the slots. The pairs are rebuilt
+ * from the prefix and their slot when they are read, see GetItem(). Keys that are searched as integers, see
+ * IntegerKey, are stored whole, so that the slots are pairs and the search runs over the page in place.
+ *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ------------------------------------------------------------------------------------
+ * | HEADER | PREFIX | SUFFIX(1) + RID(1) | SUFFIX(2) + RID(2) | ... | SUFFIX(n) + RID(n) |
+ *  ------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 16 bytes in total):
+ *  Header format (size in byte, 24 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) |
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) |
  *  ---------------------------------------------------------------------
  *  -----------------------------------------------
- * |  NextPageId (4)
+ * | PageSize (4) | PrefixLength (4) |
  *  -----------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -51,13 +61,110 @@ class BPlusTreeLeafPage : public BPlusTreePage {
    * After creating a new leaf page from buffer pool, must call initialize
    * method to set default values
    * @param max_size Max size of the leaf node
+   * @param page_size the bytes of the page
    */
-  void Init(int max_size = LEAF_PAGE_SIZE);
+  void Init(int max_size = LEAF_PAGE_SIZE, int page_size = BUSTUB_PAGE_SIZE);
 
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+
+  /** @return the key/value pair at index, rebuilt from the prefix and its slot */
+  auto GetItem(int index) const -> MappingType { return GetItem(index, page_size_); }
+
+  /**
+   * @brief GetItem() of a page of page_size bytes. Optimistic readers pass the page size of the buffer pool, since the
+   * header may change under them. A pair that does not lie within page_size bytes is read as an empty pair.
+   */
+  auto GetItem(int index, int page_size) const -> MappingType;
+
+  /** @return the index of the first key that is not less than key, GetSize() if there is none */
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+    return KeyIndex(key, comparator, GetSize(), page_size_);
+  }
+
+  /**
+   * @brief KeyIndex() among the first size pairs of a page of page_size bytes. Optimistic readers read the size once,
+   * check that it is in bounds and pass it here along with the page size of the buffer pool, since the header may
+   * change under them. The pairs that do not lie within page_size bytes are not searched.
+   */
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator, int size, int page_size) const -> int;
+
+  /**
+   * @brief Look up the value of key.
+   * @return true if the page contains key, its value is stored in *value
+   */
+  auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
+
+  /**
+   * @brief Insert key and value in key order. The page must have room for key, see HasRoomFor().
+   * @return false if the page already contains key
+   */
+  auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> bool;
+
+  /**
+   * @brief Append key and value. The page must have room for key, see HasRoomFor(), and key must be greater than all
+   * keys in it.
+   */
+  void Append(const KeyType &key, const ValueType &value);
+
+  /**
+   * @brief Remove key and its value.
+   * @return false if the page does not contain key
+   */
+  auto Remove(const KeyType &key, const KeyComparator &comparator) -> bool;
+
+  /** @return the number of bytes that all keys of the page start with and that are stored once */
+  auto GetPrefixLength() const -> int { return PrefixLength(); }
+
+  /** @return the bytes taken by the header, the prefix and the slots of the page */
+  auto GetUsedBytes() const -> int { return UsedBytes(PrefixLength(), GetSize()); }
+
+  /** @return the bytes the page would take with key inserted, which may shorten the prefix */
+  auto GetUsedBytesWith(const KeyType &key) const -> int;
+
+  /** @return true if key fits into the page */
+  auto HasRoomFor(const KeyType &key) const -> bool {
+    return GetSize() < GetMaxSize() && GetUsedBytesWith(key) <= page_size_;
+  }
+
+  /** @return true if any key fits into the page, even one that shares no prefix with its keys */
+  auto HasRoomForAnyKey() const -> bool {
+    return GetSize() < GetMaxSize() && UsedBytes(0, GetSize() + 1) <= page_size_;
+  }
+
+  /** @return true if the page has at least min size pairs, or fills at least half of its bytes */
+  auto IsHalfFull() const -> bool { return GetSize() >= GetMinSize() || 2 * GetUsedBytes() >= page_size_; }
+
+  /** @return true if the page is still half full after any one of its pairs is removed */
+  auto CanSpare() const -> bool {
+    return GetSize() > GetMinSize() || 2 * (GetUsedBytes() - SlotWidth(PrefixLength())) >= page_size_;
+  }
+
+  /** @return true if the pairs of this page fit into recipient, behind its own */
+  auto FitsInto(const BPlusTreeLeafPage *recipient) const -> bool;
+
+  /**
+   * @brief Insert key and value into this page, which has no room for it, and move the upper pairs to the empty page
+   * recipient, which becomes the next page of this one. The split is the most even one whose halves both fit into
+   * their pages. The page must not contain key.
+   */
+  void InsertAndSplitTo(const KeyType &key, const ValueType &value, const KeyComparator &comparator,
+                        BPlusTreeLeafPage *recipient, page_id_t recipient_page_id);
+
+  /**
+   * @brief Append all pairs to recipient, the previous page, which takes over the next page of this one. They must
+   * fit, see FitsInto().
+   */
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+
+  /** @brief Move the first pair to the end of recipient, the previous page, which must have room for it. */
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+
+  /** @brief Move the last pair to the front of recipient, the next page, which must have room for it. */
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
   /**
    * @brief for test only return a string representing all keys in
@@ -85,8 +192,46 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   }
 
  private:
+  /** Keys searched as integers are stored whole, see SearchPairs(). */
+  static constexpr bool PREFIX_COMPRESSED = !IntegerKey<KeyType, KeyComparator>::IS_INTEGER;
+
+  /** @return the width of a slot next to a prefix of prefix_length bytes */
+  static constexpr auto SlotWidth(int prefix_length) -> int {
+    return static_cast<int>(sizeof(KeyType) + sizeof(ValueType)) - prefix_length;
+  }
+
+  /** @return the bytes taken by a page with a prefix of prefix_length bytes and size pairs */
+  static constexpr auto UsedBytes(int prefix_length, int size) -> int {
+    return LEAF_PAGE_HEADER_SIZE + prefix_length + size * SlotWidth(prefix_length);
+  }
+
+  /** @return the length of the prefix, kept within the size of a key for optimistic readers */
+  auto PrefixLength() const -> int;
+
+  /** @return the number of bytes of the prefix that key starts with */
+  auto SharedPrefixLength(const KeyType &key) const -> int;
+
+  auto Slot(int index) -> char * { return data_ + prefix_length_ + index * SlotWidth(prefix_length_); }
+
+  /** @brief Store item in the slot at index, its key must start with the prefix. */
+  void WriteItem(int index, const MappingType &item);
+
+  /** @brief Insert item at index, rewriting the slots if its key shortens the prefix. */
+  void InsertAt(int index, const MappingType &item);
+
+  /** @brief Remove the pair at index. */
+  void RemoveAt(int index);
+
+  /** @return all pairs of the page */
+  auto GetItems() const -> std::vector<MappingType>;
+
+  /** @brief Replace the pairs of the page by the sorted items, with the longest prefix they share. */
+  void SetItems(const MappingType *items, int size);
+
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[0];
+  int page_size_;
+  int prefix_length_;
+  // Flexible array member for the prefix, followed by the slots.
+  char data_[0];
 };
 }  // namespace bustub
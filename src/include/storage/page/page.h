@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <new>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,38 +27,67 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The book-keeping information of a page fills whole cache lines, so that pinning one frame never invalidates the
+ * cache line of another. The data of a buffer pool frame lives in the FrameArena of the buffer pool.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
 
  public:
   /** Constructor. Zeros out the page data. */
   Page() {
-    data_ = new char[BUSTUB_PAGE_SIZE];
+    // Aligned, so that the page can be read and written with O_DIRECT.
+    data_ = new (std::align_val_t(BUSTUB_PAGE_ALIGNMENT)) char[BUSTUB_PAGE_SIZE];
     ResetMemory();
   }
 
-  /** Default destructor. */
-  ~Page() { delete[] data_; }
+  /** Frees the page data, unless it is borrowed from a frame arena. */
+  ~Page() {
+    if (owns_data_) {
+      ::operator delete[](data_, std::align_val_t(BUSTUB_PAGE_ALIGNMENT));
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
 
+  /** @return the size of the data of this page */
+  inline auto GetPageSize() const -> size_t { return page_size_; }
+
   /** @return the page id of this page */
-  inline auto GetPageId() -> page_id_t { return page_id_; }
+  inline auto GetPageId() -> page_id_t { return page_id_.load(std::memory_order_relaxed); }
 
   /** @return the pin count of this page */
-  inline auto GetPinCount() -> int { return pin_count_; }
+  inline auto GetPinCount() -> int { return std::max(pin_count_.load(std::memory_order_relaxed), 0); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch. Makes the version odd until the latch is released. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Readers that see a modification of the data also see the odd version.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Try to acquire the page write latch without blocking. @return true if the latch was acquired */
+  inline auto TryWLatch() -> bool {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -63,6 +95,13 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * @return the version of the page, which is bumped whenever the write latch is acquired and released: it is odd
+   * while a writer holds the latch, and changes if the page may have been modified. See OptimisticPageGuard. It is
+   * also odd while the buffer pool switches the frame to another page.
+   */
+  inline auto GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -78,21 +117,79 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** A pin count that marks a frame as claimed by the buffer pool: it is free or being switched to another page. */
+  static constexpr int CLAIMED = -1;
+
+  /** Constructor of a buffer pool frame, whose data is owned by the frame arena of the buffer pool. */
+  Page(char *data, size_t page_size) : data_(data), page_size_(page_size), owns_data_(false), pin_count_(CLAIMED) {}
+
+  /**
+   * Pin the frame without the buffer pool latch. The caller must then check that the frame holds the page it wants.
+   * @return false if the frame is claimed
+   */
+  inline auto TryPin() -> bool {
+    int count = pin_count_.load(std::memory_order_relaxed);
+    while (count >= 0) {
+      if (pin_count_.compare_exchange_weak(count, count + 1, std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Claim an unpinned frame, so that TryPin() fails until the buffer pool assigns the frame a page again.
+   * @return false if the frame is pinned
+   */
+  inline auto TryClaim() -> bool {
+    int expected = 0;
+    return pin_count_.compare_exchange_strong(expected, CLAIMED);
+  }
+
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
+  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, page_size_); }
+
+  /**
+   * Make the version odd before the frame is switched to another page, so that readers which reach the frame without
+   * pinning it notice the switch. No one can hold the latch of an unpinned frame, so this does not race with WLatch().
+   */
+  inline void BeginFrameChange() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    if ((version & 1) == 0) {
+      version_.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+    referenced_.store(false, std::memory_order_relaxed);
+  }
+
+  /** Make the version even again once the frame holds the data of its new page. */
+  inline void EndFrameChange() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    if ((version & 1) != 0) {
+      version_.store(version + 1, std::memory_order_release);
+    }
+  }
 
   /** The actual data that is stored within a page. */
   // Usually this should be stored as `char data_[BUSTUB_PAGE_SIZE]{};`. But to enable ASAN to detect page overflow,
   // we store it as a ptr.
   char *data_;
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The size of data_, the page size of the database. */
+  size_t page_size_ = BUSTUB_PAGE_SIZE;
+  /** False if data_ is borrowed from a frame arena. */
+  bool owns_data_ = true;
+  /** The ID of this page, read without the buffer pool latch by readers of swizzled references. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /** The pin count of this page, changed without the buffer pool latch by fetches of resident pages. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** The version of the page for optimistic readers, see GetVersion(). */
+  std::atomic<uint64_t> version_{0};
+  /** Set when the page is read through a swizzled reference, which the replacer does not see. */
+  std::atomic<bool> referenced_{false};
 };
 
 }  // namespace bustub
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <optional>
+
 #include "storage/page/page.h"
 
 namespace bustub {
@@ -81,6 +84,7 @@ class BasicPageGuard {
  private:
   friend class ReadPageGuard;
   friend class WritePageGuard;
+  friend class OptimisticPageGuard;
 
   [[maybe_unused]] BufferPoolManager *bpm_{nullptr};
   Page *page_{nullptr};
@@ -143,6 +147,8 @@ class ReadPageGuard {
   }
 
  private:
+  friend class OptimisticPageGuard;
+
   // You may choose to get rid of this and add your own private variables.
   BasicPageGuard guard_;
 };
@@ -210,8 +216,94 @@ class WritePageGuard {
   }
 
  private:
+  friend class OptimisticPageGuard;
+
   // You may choose to get rid of this and add your own private variables.
   BasicPageGuard guard_;
 };
 
+/**
+ * OptimisticPageGuard pins a page without latching it, in the style of the optimistic latches of LeanStore and Umbra.
+ * Instead of taking the shared latch, the guard remembers the version of the page (see Page::GetVersion()) when it is
+ * created, and the reader checks with Validate() that no writer latched the page in the meantime.
+ *
+ * Anything read through the guard may come from a page that is being modified concurrently, so it must be treated as
+ * a hint until Validate() returns true: a reader has to check bounds before it indexes with values read from the page,
+ * and must not follow a page id read from the page before validating it. If the validation fails, the reader starts
+ * over.
+ *
+ * The pin keeps the page in its frame, so the data always belongs to the same page. A guard of a swizzled reference
+ * (see BufferPoolManager::FetchPageSwizzled()) holds no pin, the frame may be switched to another page meanwhile,
+ * which Validate() detects as well.
+ */
+class OptimisticPageGuard {
+ public:
+  OptimisticPageGuard() = default;
+
+  /**
+   * Guard a pinned page. The guard does not wait for a writer that currently holds the write latch of the page, it
+   * never validates instead (see IsLatched()), so that the reader can release its pins and start over.
+   */
+  OptimisticPageGuard(BufferPoolManager *bpm, Page *page);
+
+  /** Guard a page that is not pinned, whose frame held page_id at the given even version. */
+  OptimisticPageGuard(BufferPoolManager *bpm, Page *page, page_id_t page_id, uint64_t version)
+      : bpm_(bpm), page_(page), page_id_(page_id), version_(version) {}
+
+  OptimisticPageGuard(const OptimisticPageGuard &) = delete;
+  auto operator=(const OptimisticPageGuard &) -> OptimisticPageGuard & = delete;
+  OptimisticPageGuard(OptimisticPageGuard &&that) noexcept;
+  auto operator=(OptimisticPageGuard &&that) noexcept -> OptimisticPageGuard &;
+
+  /** @brief Unpin the page, if the guard pinned it. */
+  void Drop();
+
+  ~OptimisticPageGuard();
+
+  auto PageId() -> page_id_t { return page_id_; }
+
+  auto GetData() -> const char * { return page_->GetData(); }
+
+  template <class T>
+  auto As() -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return true if a writer held the write latch of the page when the guard was created */
+  auto IsLatched() const -> bool { return (version_ & 1) != 0; }
+
+  /** @return true if the page was not latched for writing since the guard was created, i.e. what was read is valid */
+  auto Validate() const -> bool {
+    // Order the reads of the page data before the second read of the version.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return !IsLatched() && page_->GetVersion() == version_;
+  }
+
+  /**
+   * @brief Latch the page in shared mode, if it did not change since the guard was created. The pin is handed over to
+   * the returned guard, this guard is dropped either way.
+   * @return the read guard, or std::nullopt if the page was modified
+   */
+  auto UpgradeRead() -> std::optional<ReadPageGuard>;
+
+  /**
+   * @brief Latch the page exclusively, if it did not change since the guard was created. The pin is handed over to the
+   * returned guard, this guard is dropped either way.
+   * @return the write guard, or std::nullopt if the page was modified
+   */
+  auto UpgradeWrite() -> std::optional<WritePageGuard>;
+
+ private:
+  /** @return true if the guard holds a pin of the page, pinning it first if it was read through a swizzled reference */
+  auto Pin() -> bool;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  /** The pin of the page, empty for a guard of a swizzled reference that was not upgraded. */
+  BasicPageGuard guard_;
+  /** The version of the page when the guard was created, odd if a writer held the latch then. */
+  uint64_t version_{0};
+};
+
 }  // namespace bustub
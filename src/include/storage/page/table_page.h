@@ -27,7 +27,7 @@
 
 namespace bustub {
 
-static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
+static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 12;
 
 /**
  * Slotted page format:
@@ -39,7 +39,7 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *
  *  Header format (size in bytes):
  *  ----------------------------------------------------------------------------
- *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) |
+ *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) | PageSize (4) |
  *  ----------------------------------------------------------------------------
  *  ----------------------------------------------------------------
  *  | Tuple_1 offset+size (4) | Tuple_2 offset+size (4) | ... |
@@ -53,8 +53,9 @@ class TablePage {
  public:
   /**
    * Initialize the TablePage header.
+   * @param page_size the size of the page the table page lives in, tuples are placed from its end backwards
    */
-  void Init();
+  void Init(size_t page_size = BUSTUB_PAGE_SIZE);
 
   /** @return number of tuples in this page */
   auto GetNumTuples() const -> uint32_t { return num_tuples_; }
@@ -103,10 +104,13 @@ class TablePage {
   page_id_t next_page_id_;
   uint16_t num_tuples_;
   uint16_t num_deleted_tuples_;
+  uint32_t page_size_;
   TupleInfo tuple_info_[0];
 
   static constexpr size_t TUPLE_INFO_SIZE = 16;
   static_assert(sizeof(TupleInfo) == TUPLE_INFO_SIZE);
+  // Tuple offsets are 16-bit.
+  static_assert(BUSTUB_MAX_PAGE_SIZE <= UINT16_MAX + 1);
 };
 
 static_assert(sizeof(TablePage) == TABLE_PAGE_HEADER_SIZE);
@@ -16,6 +16,7 @@
 #include <memory>
 #include <utility>
 
+#include "buffer/read_ahead.h"
 #include "common/macros.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
@@ -26,7 +27,8 @@ namespace bustub {
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * TableIterator enables the sequential scan of a TableHeap. Its pages are fetched with AccessType::Scan, and the pages
+ * following the current one are read ahead while the scan is sequential.
  */
 class TableIterator {
   friend class Cursor;
@@ -55,6 +57,8 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+
+  SequentialReadAhead read_ahead_;
 };
 
 }  // namespace bustub
@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <cassert>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
@@ -26,17 +27,85 @@ namespace bustub {
 
 static char *buffer_used;
 
+/** Identifies a BusTub database file, followed by the page size and the file format as 32 bit integers. */
+static constexpr char FILE_MAGIC[8] = {'B', 'u', 's', 'T', 'u', 'b', 'D', 'B'};
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, size_t page_size) : file_name_(db_file), page_size_(page_size) {
+  CheckPageSize(page_size_);
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  OpenLogFile();
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // directory or file does not exist
+  if (!db_io_.is_open()) {
+    db_io_.clear();
+    // create a new file
+    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!db_io_.is_open()) {
+      throw Exception("can't open db file");
+    }
+  }
+
+  char header[FILE_HEADER_SIZE]{};
+  bool create = GetFileSize(db_file) <= 0;
+  if (create) {
+    EncodeFileHeader(header);
+    db_io_.write(header, FILE_HEADER_SIZE);
+    db_io_.flush();
+  } else {
+    db_io_.read(header, FILE_HEADER_SIZE);
+    db_io_.clear();
+    DecodeFileHeader(header);
+  }
+  OpenFreeSpaceMapFile(create);
+  buffer_used = nullptr;
+}
+
+void DiskManager::CheckPageSize(size_t page_size) {
+  if (page_size < BUSTUB_PAGE_ALIGNMENT || page_size > BUSTUB_MAX_PAGE_SIZE || (page_size & (page_size - 1)) != 0) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "invalid page size " + std::to_string(page_size));
+  }
+}
+
+void DiskManager::EncodeFileHeader(char *header) const {
+  memset(header, 0, FILE_HEADER_SIZE);
+  memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+  auto page_size = static_cast<uint32_t>(page_size_);
+  memcpy(header + sizeof(FILE_MAGIC), &page_size, sizeof(page_size));
+  memcpy(header + sizeof(FILE_MAGIC) + sizeof(page_size), &file_format_, sizeof(file_format_));
+}
+
+void DiskManager::DecodeFileHeader(const char *header) {
+  if (memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+    throw Exception("not a database file: " + file_name_);
+  }
+  uint32_t page_size;
+  memcpy(&page_size, header + sizeof(FILE_MAGIC), sizeof(page_size));
+  CheckPageSize(page_size);
+  FileFormat file_format;
+  memcpy(&file_format, header + sizeof(FILE_MAGIC) + sizeof(page_size), sizeof(file_format));
+  if (file_format != file_format_) {
+    throw Exception(file_format == FileFormat::CompressedExtents
+                        ? "database file stores compressed pages, open it with DiskManagerCompressed: " + file_name_
+                        : "database file does not store compressed pages: " + file_name_);
+  }
+  if (page_size != page_size_) {
+    LOG_INFO("%s was created with %u byte pages", file_name_.c_str(), page_size);
+  }
+  page_size_ = page_size;
+}
+
+void DiskManager::OpenLogFile() {
+  log_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".log";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -48,19 +117,27 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw Exception("can't open dblog file");
     }
   }
+}
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+void DiskManager::OpenFreeSpaceMapFile(bool create) {
+  fsm_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".fsm";
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  if (!create) {
+    fsm_io_.open(fsm_name_, std::ios::binary | std::ios::in | std::ios::out);
+  }
+  if (!fsm_io_.is_open()) {
+    fsm_io_.clear();
+    // create a new file, or drop the map a removed database file of the same name left behind
+    fsm_io_.open(fsm_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!fsm_io_.is_open()) {
+      throw Exception("can't open free space map file");
     }
   }
-  buffer_used = nullptr;
+}
+
+void DiskManager::CloseFreeSpaceMapFile() {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  fsm_io_.close();
 }
 
 /**
@@ -72,6 +149,7 @@ void DiskManager::ShutDown() {
     db_io_.close();
   }
   log_io_.close();
+  CloseFreeSpaceMapFile();
 }
 
 /**
@@ -79,11 +157,11 @@ void DiskManager::ShutDown() {
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t offset = PageOffset(page_id);
   // set write cursor to offset
   num_writes_ += 1;
   db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
+  db_io_.write(page_data, page_size_);
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
@@ -98,7 +176,7 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+  auto offset = static_cast<int64_t>(PageOffset(page_id));
   // check if read beyond file length
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
@@ -106,18 +184,79 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
+    db_io_.read(page_data, page_size_);
     if (db_io_.bad()) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
+    // if file ends before reading a whole page
+    auto read_count = static_cast<size_t>(db_io_.gcount());
+    if (read_count < page_size_) {
       LOG_DEBUG("Read less than a page");
       db_io_.clear();
       // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+      memset(page_data + read_count, 0, page_size_ - read_count);
+    }
+  }
+}
+
+void DiskManager::ReadFreeSpaceMapPage(size_t index, char *page_data) {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  memset(page_data, 0, page_size_);
+  if (!fsm_io_.is_open()) {
+    return;
+  }
+  fsm_io_.seekg(static_cast<std::streamoff>(index * page_size_));
+  fsm_io_.read(page_data, page_size_);
+  if (fsm_io_.bad()) {
+    LOG_DEBUG("I/O error while reading free space map");
+  }
+  // past the end of the file, the rest of the page stays zeroed
+  fsm_io_.clear();
+}
+
+void DiskManager::WriteFreeSpaceMapPage(size_t index, const char *page_data) {
+  std::scoped_lock scoped_fsm_latch(fsm_latch_);
+  if (!fsm_io_.is_open()) {
+    return;
+  }
+  fsm_io_.seekp(static_cast<std::streamoff>(index * page_size_));
+  fsm_io_.write(page_data, page_size_);
+  if (fsm_io_.bad()) {
+    LOG_DEBUG("I/O error while writing free space map");
+    return;
+  }
+  fsm_io_.flush();
+}
+
+void DiskManager::TruncatePages(size_t num_pages) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  if (!db_io_.is_open()) {
+    return;
+  }
+  db_io_.flush();
+  // GetFileSize() returns an int, which is -1 on error and overflows past 2 GiB.
+  std::error_code error;
+  auto file_size = std::filesystem::file_size(file_name_, error);
+  if (error) {
+    LOG_DEBUG("I/O error while reading file size");
+    return;
+  }
+  if (file_size <= PageOffset(num_pages)) {
+    return;
+  }
+  std::filesystem::resize_file(file_name_, PageOffset(num_pages), error);
+  if (error) {
+    LOG_DEBUG("I/O error while truncating");
+  }
+}
+
+void DiskManager::ExecuteBatch(const std::vector<DiskIo> &batch) {
+  for (const auto &io : batch) {
+    if (io.is_write_) {
+      WritePage(io.page_id_, io.data_);
+    } else {
+      ReadPage(io.page_id_, io.data_);
     }
   }
 }
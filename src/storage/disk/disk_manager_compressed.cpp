@@ -0,0 +1,300 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.cpp
+//
+// Identification: src/storage/disk/disk_manager_compressed.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_compressed.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerCompressed::DiskManagerCompressed(const std::string &db_file, size_t sync_interval, size_t page_size)
+    : DiskManagerPosix(db_file, false, sync_interval, page_size, FileFormat::CompressedExtents) {
+  if (fd_ >= 0) {
+    LoadExtents();
+  }
+}
+
+auto DiskManagerCompressed::ExtentBuffer() -> char * {
+  alignas(64) static thread_local char buffer[MAX_EXTENT_SIZE];
+  return buffer;
+}
+
+auto DiskManagerCompressed::Checksum(const char *data, size_t size) -> uint32_t {
+  // FNV-1a
+  uint32_t hash = 2166136261U;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619U;
+  }
+  return hash;
+}
+
+auto DiskManagerCompressed::IsIntact(const char *buffer, size_t size, page_id_t page_id) -> bool {
+  ExtentHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, buffer, sizeof(header));
+  return header.magic_ == EXTENT_MAGIC && header.page_id_ == page_id && header.stored_size_ <= size - sizeof(header) &&
+         header.checksum_ == Checksum(buffer + sizeof(header), header.stored_size_);
+}
+
+auto DiskManagerCompressed::ReadExtent(const Extent &extent, char *buffer) -> size_t {
+  size_t size = std::min<size_t>(extent.num_sectors_ * SECTOR_SIZE, MAX_EXTENT_SIZE);
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(fd_, buffer + read_count, size - read_count, static_cast<off_t>(extent.offset_ + read_count));
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      throw Exception(std::string("I/O error while reading: ") + strerror(errno));
+    }
+    if (rc == 0) {
+      // The last extent may end within its last sector.
+      break;
+    }
+    read_count += rc;
+  }
+  return read_count;
+}
+
+void DiskManagerCompressed::LoadExtents() {
+  size_t offset = FILE_HEADER_SIZE;
+  char *buffer = ExtentBuffer();
+  std::vector<Extent> replaced;
+  ExtentHeader header;
+  while (pread(fd_, &header, sizeof(header), static_cast<off_t>(offset)) == static_cast<ssize_t>(sizeof(header)) &&
+         header.magic_ == EXTENT_MAGIC && header.num_sectors_ > 0) {
+    Extent extent{offset, header.num_sectors_, header.sequence_};
+    next_sequence_ = std::max(next_sequence_, header.sequence_ + 1);
+    offset += extent.num_sectors_ * SECTOR_SIZE;
+    if (header.page_id_ == INVALID_PAGE_ID || !IsIntact(buffer, ReadExtent(extent, buffer), header.page_id_)) {
+      // Freed, or torn by a crash while it was written.
+      free_extents_.emplace(extent.num_sectors_, extent.offset_);
+      continue;
+    }
+    auto [it, inserted] = extents_.emplace(header.page_id_, extent);
+    if (!inserted) {
+      // The page was written again, and the file was closed before the older copy was freed.
+      if (extent.sequence_ > it->second.sequence_) {
+        std::swap(it->second, extent);
+      }
+      replaced.push_back(extent);
+    }
+  }
+  // Anything after the last valid extent is the remainder of an append that did not complete, and is overwritten.
+  file_end_ = offset;
+
+  for (const auto &extent : replaced) {
+    WriteFreeHeader(extent);
+    free_extents_.emplace(extent.num_sectors_, extent.offset_);
+  }
+}
+
+auto DiskManagerCompressed::AllocateExtent(uint32_t num_sectors) -> Extent {
+  // A free extent is only used if it wastes at most half of its sectors.
+  auto it = free_extents_.lower_bound(num_sectors);
+  if (it != free_extents_.end() && it->first <= 2 * num_sectors) {
+    Extent extent{it->second, it->first, 0};
+    free_extents_.erase(it);
+    return extent;
+  }
+  Extent extent{file_end_, num_sectors, 0};
+  file_end_ += num_sectors * SECTOR_SIZE;
+  return extent;
+}
+
+void DiskManagerCompressed::WriteFreeHeader(const Extent &extent) {
+  ExtentHeader header{EXTENT_MAGIC, INVALID_PAGE_ID, next_sequence_++, extent.num_sectors_, 0, ExtentCodec::Raw, 0};
+  if (pwrite(fd_, &header, sizeof(header), static_cast<off_t>(extent.offset_)) !=
+      static_cast<ssize_t>(sizeof(header))) {
+    LOG_DEBUG("I/O error while writing");
+  }
+}
+
+void DiskManagerCompressed::WritePage(page_id_t page_id, const char *page_data) {
+  char *buffer = ExtentBuffer();
+  char *payload = buffer + sizeof(ExtentHeader);
+  ExtentHeader header{EXTENT_MAGIC, page_id, 0, 0, 0, ExtentCodec::Lz, 0};
+  // A page that does not shrink by a sector is not worth decompressing.
+  size_t raw_sectors = (sizeof(ExtentHeader) + page_size_ + SECTOR_SIZE - 1) / SECTOR_SIZE;
+  header.stored_size_ = PageCodec::Compress(page_data, page_size_, payload,
+                                            (raw_sectors - 1) * SECTOR_SIZE - sizeof(ExtentHeader));
+  if (header.stored_size_ == 0) {
+    header.codec_ = ExtentCodec::Raw;
+    header.stored_size_ = page_size_;
+    memcpy(payload, page_data, page_size_);
+  }
+  header.checksum_ = Checksum(payload, header.stored_size_);
+  auto num_sectors =
+      static_cast<uint32_t>((sizeof(ExtentHeader) + header.stored_size_ + SECTOR_SIZE - 1) / SECTOR_SIZE);
+
+  // The page always goes to a new extent, so that the copy it replaces survives a write torn by a crash.
+  Extent extent;
+  {
+    std::scoped_lock lock(extent_latch_);
+    header.sequence_ = next_sequence_++;
+    extent = AllocateExtent(num_sectors);
+    extent.sequence_ = header.sequence_;
+    writes_in_flight_++;
+  }
+  header.num_sectors_ = extent.num_sectors_;
+  memcpy(buffer, &header, sizeof(header));
+
+  size_t size = sizeof(ExtentHeader) + header.stored_size_;
+  size_t written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(fd_, buffer + written, size - written, static_cast<off_t>(extent.offset_ + written));
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      std::string error = rc < 0 ? strerror(errno) : "short write";
+      // The extent may hold part of this write, or nothing at all if it was appended. Either way the walk of
+      // LoadExtents() has to find a header there to go on to the extents after it.
+      std::scoped_lock lock(extent_latch_);
+      WriteFreeHeader(extent);
+      if (extent.offset_ + extent.num_sectors_ * SECTOR_SIZE == file_end_) {
+        file_end_ = extent.offset_;
+      } else {
+        free_extents_.emplace(extent.num_sectors_, extent.offset_);
+      }
+      writes_in_flight_--;
+      throw Exception("I/O error while writing page " + std::to_string(page_id) + ": " + error);
+    }
+    written += rc;
+  }
+
+  {
+    // The extent of the older copy still names the page in the file. It is freed by the next Sync(), once this copy is
+    // durable. A concurrent write of the same page may have completed first, the newer of both copies is kept.
+    std::scoped_lock lock(extent_latch_);
+    auto [it, inserted] = extents_.emplace(page_id, extent);
+    if (!inserted) {
+      if (extent.sequence_ > it->second.sequence_) {
+        std::swap(it->second, extent);
+      }
+      replaced_extents_.emplace_back(page_id, extent);
+    }
+    writes_in_flight_--;
+  }
+  CountWrite();
+}
+
+void DiskManagerCompressed::ReadPage(page_id_t page_id, char *page_data) {
+  Extent extent;
+  {
+    std::scoped_lock lock(extent_latch_);
+    auto it = extents_.find(page_id);
+    if (it == extents_.end()) {
+      memset(page_data, 0, page_size_);
+      return;
+    }
+    extent = it->second;
+  }
+
+  char *buffer = ExtentBuffer();
+  size_t read_count = ReadExtent(extent, buffer);
+  ExtentHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  bool valid = IsIntact(buffer, read_count, page_id);
+  if (valid && header.codec_ == ExtentCodec::Raw) {
+    valid = header.stored_size_ == page_size_;
+    if (valid) {
+      memcpy(page_data, buffer + sizeof(header), page_size_);
+    }
+  } else if (valid) {
+    valid = PageCodec::Decompress(buffer + sizeof(header), header.stored_size_, page_data, page_size_);
+  }
+  if (!valid) {
+    throw Exception("corrupt extent of page " + std::to_string(page_id));
+  }
+}
+
+void DiskManagerCompressed::Sync() {
+  // Only the copies replaced before the fdatasync are covered by it.
+  std::vector<std::pair<page_id_t, Extent>> replaced;
+  {
+    std::scoped_lock lock(extent_latch_);
+    replaced.swap(replaced_extents_);
+  }
+  DiskManagerPosix::Sync();
+  std::scoped_lock lock(extent_latch_);
+  for (const auto &[page_id, extent] : replaced) {
+    WriteFreeHeader(extent);
+    free_extents_.emplace(extent.num_sectors_, extent.offset_);
+  }
+}
+
+void DiskManagerCompressed::TruncatePages(size_t num_pages) {
+  std::scoped_lock lock(extent_latch_);
+  for (auto it = extents_.begin(); it != extents_.end();) {
+    if (static_cast<size_t>(it->first) < num_pages) {
+      ++it;
+      continue;
+    }
+    WriteFreeHeader(it->second);
+    free_extents_.emplace(it->second.num_sectors_, it->second.offset_);
+    it = extents_.erase(it);
+  }
+  // The older copies of the dropped pages are not needed to survive a crash anymore.
+  for (auto it = replaced_extents_.begin(); it != replaced_extents_.end();) {
+    if (static_cast<size_t>(it->first) < num_pages) {
+      ++it;
+      continue;
+    }
+    WriteFreeHeader(it->second);
+    free_extents_.emplace(it->second.num_sectors_, it->second.offset_);
+    it = replaced_extents_.erase(it);
+  }
+
+  if (writes_in_flight_ > 0) {
+    // A page is being written to a new extent that may be past the last extent of extents_.
+    return;
+  }
+  size_t end = FILE_HEADER_SIZE;
+  for (const auto &[page_id, extent] : extents_) {
+    end = std::max(end, extent.offset_ + extent.num_sectors_ * SECTOR_SIZE);
+  }
+  for (const auto &[page_id, extent] : replaced_extents_) {
+    end = std::max(end, extent.offset_ + extent.num_sectors_ * SECTOR_SIZE);
+  }
+  for (auto it = free_extents_.begin(); it != free_extents_.end();) {
+    it = it->second >= end ? free_extents_.erase(it) : std::next(it);
+  }
+  file_end_ = end;
+  if (ftruncate(fd_, static_cast<off_t>(end)) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+  }
+}
+
+auto DiskManagerCompressed::GetNumPages() -> size_t {
+  std::scoped_lock lock(extent_latch_);
+  return extents_.size();
+}
+
+auto DiskManagerCompressed::GetStoredBytes() -> size_t {
+  std::scoped_lock lock(extent_latch_);
+  size_t bytes = 0;
+  for (const auto &[page_id, extent] : extents_) {
+    bytes += extent.num_sectors_ * SECTOR_SIZE;
+  }
+  return bytes;
+}
+
+}  // namespace bustub
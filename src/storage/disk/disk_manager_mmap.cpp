@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.cpp
+//
+// Identification: src/storage/disk/disk_manager_mmap.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_mmap.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerMmap::DiskManagerMmap(const std::string &db_file, size_t sync_interval, size_t page_size, size_t map_size)
+    : DiskManagerPosix(db_file, false, sync_interval, page_size), map_size_(map_size) {
+  if (fd_ < 0) {
+    return;
+  }
+  // Mapping past the end of the file is fine as long as that part is not touched.
+  void *map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED | MAP_NORESERVE, fd_, 0);
+  if (map == MAP_FAILED) {
+    throw Exception("can't map db file");
+  }
+  map_ = static_cast<char *>(map);
+  IsMapped(0);
+}
+
+DiskManagerMmap::~DiskManagerMmap() { Unmap(); }
+
+void DiskManagerMmap::ShutDown() {
+  Unmap();
+  DiskManagerPosix::ShutDown();
+}
+
+void DiskManagerMmap::Unmap() {
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+  }
+}
+
+auto DiskManagerMmap::IsMapped(size_t size) -> bool {
+  if (size <= file_size_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0) {
+    LOG_DEBUG("I/O error while reading the size of the db file");
+    return false;
+  }
+  auto file_size = static_cast<size_t>(file_stat.st_size);
+  size_t cached = file_size_.load(std::memory_order_relaxed);
+  while (cached < file_size && !file_size_.compare_exchange_weak(cached, file_size, std::memory_order_relaxed)) {
+  }
+  return size <= file_size;
+}
+
+void DiskManagerMmap::TruncatePages(size_t num_pages) {
+  // Lowered first, so that no read touches the part of the mapping that is about to be cut off.
+  size_t size = PageOffset(num_pages);
+  size_t cached = file_size_.load(std::memory_order_relaxed);
+  while (cached > size && !file_size_.compare_exchange_weak(cached, size, std::memory_order_relaxed)) {
+  }
+  DiskManagerPosix::TruncatePages(num_pages);
+}
+
+auto DiskManagerMmap::GetPageView(page_id_t page_id) -> const char * {
+  size_t end = PageOffset(page_id) + page_size_;
+  if (map_ == nullptr || end > map_size_ || !IsMapped(end)) {
+    return nullptr;
+  }
+  return map_ + PageOffset(page_id);
+}
+
+void DiskManagerMmap::ReadPage(page_id_t page_id, char *page_data) {
+  size_t end = PageOffset(page_id) + page_size_;
+  if (map_ == nullptr || end > map_size_ || !IsMapped(end)) {
+    // Past the mapping or past the end of the file, where pread zeroes what is missing.
+    DiskManagerPosix::ReadPage(page_id, page_data);
+    return;
+  }
+  memcpy(page_data, map_ + PageOffset(page_id), page_size_);
+}
+
+}  // namespace bustub
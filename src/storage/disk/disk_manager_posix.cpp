@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_posix.cpp
+//
+// Identification: src/storage/disk/disk_manager_posix.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_posix.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+/** @return a per-thread aligned buffer for O_DIRECT requests on unaligned buffers, large enough for any page size */
+static auto BounceBuffer() -> char * {
+  alignas(BUSTUB_PAGE_ALIGNMENT) static thread_local char buffer[BUSTUB_MAX_PAGE_SIZE];
+  return buffer;
+}
+
+static auto IsAligned(const char *data) -> bool {
+  return reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_ALIGNMENT == 0;
+}
+
+DiskManagerPosix::DiskManagerPosix(const std::string &db_file, bool direct_io, size_t sync_interval, size_t page_size)
+    : DiskManagerPosix(db_file, direct_io, sync_interval, page_size, FileFormat::Pages) {}
+
+DiskManagerPosix::DiskManagerPosix(const std::string &db_file, bool direct_io, size_t sync_interval, size_t page_size,
+                                   FileFormat file_format)
+    : direct_io_(direct_io), sync_interval_(sync_interval) {
+  CheckPageSize(page_size);
+  file_format_ = file_format;
+  page_size_ = page_size;
+  file_name_ = db_file;
+  if (file_name_.rfind('.') == std::string::npos) {
+    LOG_DEBUG("wrong file format");
+    return;
+  }
+  OpenLogFile();
+
+  int flags = O_RDWR | O_CREAT;
+  if (direct_io_) {
+    fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);
+    if (fd_ < 0 && errno == EINVAL) {
+      // e.g. tmpfs does not support O_DIRECT
+      LOG_WARN("O_DIRECT is not supported for %s, falling back to buffered I/O", db_file.c_str());
+      direct_io_ = false;
+    }
+  }
+  if (fd_ < 0) {
+    fd_ = open(db_file.c_str(), flags, 0644);
+  }
+  if (fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+
+  char *header = BounceBuffer();
+  ssize_t rc = pread(fd_, header, FILE_HEADER_SIZE, 0);
+  OpenFreeSpaceMapFile(rc == 0);
+  if (rc == 0) {
+    EncodeFileHeader(header);
+    rc = pwrite(fd_, header, FILE_HEADER_SIZE, 0);
+    if (rc != static_cast<ssize_t>(FILE_HEADER_SIZE)) {
+      throw Exception("can't write the header of the db file");
+    }
+  } else if (rc != static_cast<ssize_t>(FILE_HEADER_SIZE)) {
+    throw Exception("can't read the header of the db file");
+  } else {
+    DecodeFileHeader(header);
+  }
+}
+
+DiskManagerPosix::~DiskManagerPosix() {
+  if (fd_ >= 0) {
+    Sync();
+    close(fd_);
+  }
+}
+
+void DiskManagerPosix::ShutDown() {
+  if (fd_ >= 0) {
+    Sync();
+    close(fd_);
+    fd_ = -1;
+  }
+  log_io_.close();
+  CloseFreeSpaceMapFile();
+}
+
+void DiskManagerPosix::WritePage(page_id_t page_id, const char *page_data) {
+  auto offset = static_cast<off_t>(PageOffset(page_id));
+  if (direct_io_ && !IsAligned(page_data)) {
+    page_data = static_cast<const char *>(memcpy(BounceBuffer(), page_data, page_size_));
+  }
+  size_t written = 0;
+  while (written < page_size_) {
+    ssize_t rc = pwrite(fd_, page_data + written, page_size_ - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      throw Exception(std::string("I/O error while writing: ") + strerror(errno));
+    }
+    if (rc == 0) {
+      throw Exception("short write of page " + std::to_string(page_id));
+    }
+    written += rc;
+  }
+  CountWrite();
+}
+
+void DiskManagerPosix::ReadPage(page_id_t page_id, char *page_data) {
+  auto offset = static_cast<off_t>(PageOffset(page_id));
+  char *buffer = direct_io_ && !IsAligned(page_data) ? BounceBuffer() : page_data;
+
+  size_t read_count = 0;
+  while (read_count < page_size_) {
+    ssize_t rc = pread(fd_, buffer + read_count, page_size_ - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      throw Exception(std::string("I/O error while reading: ") + strerror(errno));
+    }
+    if (rc == 0) {
+      // if file ends before reading a whole page
+      LOG_DEBUG("Read less than a page");
+      memset(buffer + read_count, 0, page_size_ - read_count);
+      break;
+    }
+    read_count += rc;
+  }
+
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, page_size_);
+  }
+}
+
+void DiskManagerPosix::TruncatePages(size_t num_pages) {
+  struct stat file_stat;
+  if (fd_ < 0 || fstat(fd_, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) <= PageOffset(num_pages)) {
+    return;
+  }
+  if (ftruncate(fd_, static_cast<off_t>(PageOffset(num_pages))) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+  }
+}
+
+void DiskManagerPosix::CountWrite() {
+  num_writes_ += 1;
+  if (sync_interval_ > 0 && unsynced_writes_.fetch_add(1) + 1 >= sync_interval_) {
+    Sync();
+  }
+}
+
+void DiskManagerPosix::Sync() {
+  unsynced_writes_ = 0;
+  if (fdatasync(fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+}
+
+}  // namespace bustub
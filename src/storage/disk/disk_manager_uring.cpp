@@ -0,0 +1,317 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.cpp
+//
+// Identification: src/storage/disk/disk_manager_uring.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_uring.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <unordered_set>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define BUSTUB_HAS_IO_URING
+#endif
+
+namespace bustub {
+
+#ifdef BUSTUB_HAS_IO_URING
+
+/** An io_uring instance with its submission and completion queues mapped into memory. */
+struct DiskManagerUring::Ring {
+  ~Ring() {
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ >= 0) {
+      close(ring_fd_);
+    }
+  }
+
+  /** @return false if the kernel does not support io_uring with IORING_OP_READ and IORING_OP_WRITE */
+  auto Setup(unsigned entries) -> bool {
+    io_uring_params params{};
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) {
+      return false;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ptr_ = single_mmap ? sq_ptr_
+                          : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                 IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes =
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    auto *sq = static_cast<char *>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // IORING_OP_READ and IORING_OP_WRITE need Linux 5.6, which is also the first version with probing.
+    std::vector<char> probe_buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    auto *probe = reinterpret_cast<io_uring_probe *>(probe_buffer.data());
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+      return false;
+    }
+    auto supported = [&](int op) {
+      return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_WRITE) && supported(IORING_OP_READ_FIXED) &&
+           supported(IORING_OP_WRITE_FIXED);
+  }
+
+  /** Serializes the batches submitted on this ring. */
+  std::mutex latch_;
+  int ring_fd_{-1};
+  void *sq_ptr_{MAP_FAILED};
+  size_t sq_size_{0};
+  void *cq_ptr_{MAP_FAILED};
+  size_t cq_size_{0};
+  io_uring_sqe *sqes_{static_cast<io_uring_sqe *>(MAP_FAILED)};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+#else
+
+struct DiskManagerUring::Ring {
+  std::mutex latch_;
+};
+
+#endif
+
+DiskManagerUring::DiskManagerUring(const std::string &db_file, bool direct_io, size_t sync_interval, size_t num_rings,
+                                   size_t page_size)
+    : DiskManagerPosix(db_file, direct_io, sync_interval, page_size) {
+#ifdef BUSTUB_HAS_IO_URING
+  for (size_t i = 0; i < num_rings; ++i) {
+    auto ring = std::make_unique<Ring>();
+    if (!ring->Setup(RING_ENTRIES)) {
+      LOG_WARN("io_uring is not available, falling back to pread/pwrite");
+      rings_.clear();
+      return;
+    }
+    rings_.push_back(std::move(ring));
+  }
+#else
+  LOG_WARN("built without io_uring support, falling back to pread/pwrite");
+#endif
+}
+
+DiskManagerUring::~DiskManagerUring() = default;
+
+void DiskManagerUring::WritePage(page_id_t page_id, const char *page_data) {
+  if (!IsUringEnabled()) {
+    DiskManagerPosix::WritePage(page_id, page_data);
+    return;
+  }
+  ExecuteBatch({{true, page_id, const_cast<char *>(page_data)}});
+}
+
+void DiskManagerUring::ReadPage(page_id_t page_id, char *page_data) {
+  if (!IsUringEnabled()) {
+    DiskManagerPosix::ReadPage(page_id, page_data);
+    return;
+  }
+  ExecuteBatch({{false, page_id, page_data}});
+}
+
+void DiskManagerUring::ExecuteBatch(const std::vector<DiskIo> &batch) {
+  if (!IsUringEnabled()) {
+    DiskManager::ExecuteBatch(batch);
+    return;
+  }
+
+  // Every thread keeps using the same ring, so that threads only contend if there are more of them than rings.
+  static std::atomic<size_t> next_ring{0};
+  thread_local size_t ring_slot = next_ring.fetch_add(1);
+  Ring *ring = rings_[ring_slot % rings_.size()].get();
+  // The buffers latch is taken before the ring latch, in the order RegisterBuffers() and UnregisterBuffers() take them.
+  std::shared_lock buffers_lock(buffers_latch_);
+  std::scoped_lock lock(ring->latch_);
+
+  // Requests in flight together complete in any order, so a chunk must not contain the same page twice.
+  std::unordered_set<page_id_t> pages;
+  size_t chunk_start = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (i - chunk_start == RING_ENTRIES || pages.count(batch[i].page_id_) > 0) {
+      SubmitAndWait(ring, batch.data() + chunk_start, i - chunk_start);
+      chunk_start = i;
+      pages.clear();
+    }
+    pages.insert(batch[i].page_id_);
+  }
+  SubmitAndWait(ring, batch.data() + chunk_start, batch.size() - chunk_start);
+}
+
+void DiskManagerUring::SubmitAndWait(Ring *ring, const DiskIo *ios, size_t count) {
+#ifdef BUSTUB_HAS_IO_URING
+  std::vector<size_t> redo;
+
+  // Only this thread produces on the submission queue, so the tail can be read without synchronization.
+  unsigned tail = *ring->sq_tail_;
+  unsigned to_submit = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const auto &io = ios[i];
+    if (direct_io_ && reinterpret_cast<uintptr_t>(io.data_) % BUSTUB_PAGE_ALIGNMENT != 0) {
+      // Needs the bounce buffer of the pread/pwrite path.
+      redo.push_back(i);
+      continue;
+    }
+    unsigned index = tail & ring->sq_mask_;
+    io_uring_sqe *sqe = &ring->sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    auto it = buffer_index_.find(io.data_);
+    if (it != buffer_index_.end()) {
+      sqe->opcode = io.is_write_ ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+      sqe->buf_index = it->second;
+    } else {
+      sqe->opcode = io.is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd = fd_;
+    sqe->off = PageOffset(io.page_id_);
+    sqe->addr = reinterpret_cast<uint64_t>(io.data_);
+    sqe->len = page_size_;
+    sqe->user_data = i;
+    ring->sq_array_[index] = index;
+    tail++;
+    to_submit++;
+  }
+  __atomic_store_n(ring->sq_tail_, tail, __ATOMIC_RELEASE);
+
+  unsigned in_flight = to_submit;
+  while (in_flight > 0) {
+    int rc = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring->ring_fd_, to_submit, in_flight, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (rc < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      // The kernel may still be working on the submitted requests, so their buffers cannot be handed back.
+      throw Exception(std::string("io_uring_enter failed: ") + strerror(errno));
+    }
+    num_submissions_++;
+    to_submit -= static_cast<unsigned>(rc);
+
+    unsigned head = *ring->cq_head_;
+    unsigned cq_tail = __atomic_load_n(ring->cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != cq_tail; head++) {
+      const io_uring_cqe &cqe = ring->cqes_[head & ring->cq_mask_];
+      auto i = static_cast<size_t>(cqe.user_data);
+      if (cqe.res != static_cast<int32_t>(page_size_)) {
+        // Failed, or short because the read is past the end of the file. The synchronous retry throws if it fails too.
+        redo.push_back(i);
+      } else if (ios[i].is_write_) {
+        CountWrite();
+      }
+      in_flight--;
+    }
+    __atomic_store_n(ring->cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  for (auto i : redo) {
+    if (ios[i].is_write_) {
+      DiskManagerPosix::WritePage(ios[i].page_id_, ios[i].data_);
+    } else {
+      DiskManagerPosix::ReadPage(ios[i].page_id_, ios[i].data_);
+    }
+  }
+#endif
+}
+
+void DiskManagerUring::RegisterBuffers(const std::vector<char *> &buffers) {
+#ifdef BUSTUB_HAS_IO_URING
+  std::unique_lock buffers_lock(buffers_latch_);
+  if (!IsUringEnabled() || !buffer_index_.empty() || buffers.empty()) {
+    return;
+  }
+
+  std::vector<iovec> iovecs;
+  iovecs.reserve(buffers.size());
+  for (auto *buffer : buffers) {
+    iovecs.push_back({buffer, page_size_});
+  }
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    std::scoped_lock lock(rings_[i]->latch_);
+    if (syscall(__NR_io_uring_register, rings_[i]->ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) <
+        0) {
+      LOG_WARN("failed to register %zu buffers with io_uring: %s", buffers.size(), strerror(errno));
+      for (size_t j = 0; j < i; ++j) {
+        std::scoped_lock registered_lock(rings_[j]->latch_);
+        syscall(__NR_io_uring_register, rings_[j]->ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+      }
+      return;
+    }
+  }
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    buffer_index_[buffers[i]] = static_cast<int>(i);
+  }
+#endif
+}
+
+void DiskManagerUring::UnregisterBuffers() {
+#ifdef BUSTUB_HAS_IO_URING
+  std::unique_lock buffers_lock(buffers_latch_);
+  if (buffer_index_.empty()) {
+    return;
+  }
+  for (auto &ring : rings_) {
+    std::scoped_lock lock(ring->latch_);
+    syscall(__NR_io_uring_register, ring->ring_fd_, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+  }
+  buffer_index_.clear();
+#endif
+}
+
+}  // namespace bustub
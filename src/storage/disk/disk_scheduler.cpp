@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+  BUSTUB_ENSURE(num_workers > 0, "the disk scheduler needs at least one worker");
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([&] { StartWorkerThread(); });
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void DiskScheduler::Schedule(DiskRequest r) {
+  std::vector<DiskRequest> requests;
+  requests.push_back(std::move(r));
+  ScheduleBatch(std::move(requests));
+}
+
+void DiskScheduler::ScheduleBatch(std::vector<DiskRequest> requests) {
+  if (requests.empty()) {
+    return;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    queue_.push_back(std::move(requests));
+  }
+  cv_.notify_one();
+}
+
+auto DiskScheduler::TakeRun() -> std::vector<DiskRequest> {
+  std::vector<DiskRequest> run = std::move(queue_.front());
+  queue_.pop_front();
+
+  if (run.size() == 1) {
+    // Extend the run in both directions until no queued request is adjacent to it. Requests for pages already in the
+    // run are taken as well, so that they cannot overtake the ones in the run on another worker.
+    page_id_t low = run.front().page_id_;
+    page_id_t high = low;
+    bool extended = true;
+    while (extended && run.size() < MAX_RUN_LENGTH) {
+      extended = false;
+      for (auto it = queue_.begin(); it != queue_.end() && run.size() < MAX_RUN_LENGTH;) {
+        if (it->size() == 1 && it->front().page_id_ >= low - 1 && it->front().page_id_ <= high + 1) {
+          low = std::min(low, it->front().page_id_);
+          high = std::max(high, it->front().page_id_);
+          run.push_back(std::move(it->front()));
+          it = queue_.erase(it);
+          extended = true;
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  std::stable_sort(run.begin(), run.end(),
+                   [](const DiskRequest &a, const DiskRequest &b) { return a.page_id_ < b.page_id_; });
+  return run;
+}
+
+void DiskScheduler::StartWorkerThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    auto run = TakeRun();
+    if (!queue_.empty()) {
+      // More requests than this worker took, let another worker pick them up.
+      cv_.notify_one();
+    }
+    lock.unlock();
+
+    std::vector<DiskIo> batch;
+    batch.reserve(run.size());
+    for (const auto &request : run) {
+      batch.push_back({request.is_write_, request.page_id_, request.data_});
+    }
+    try {
+      disk_manager_->ExecuteBatch(batch);
+      for (auto &request : run) {
+        if (request.on_complete_) {
+          request.on_complete_(true);
+        }
+        request.callback_.set_value(true);
+      }
+    } catch (...) {
+      for (auto &request : run) {
+        if (request.on_complete_) {
+          request.on_complete_(false);
+        }
+        request.callback_.set_exception(std::current_exception());
+      }
+    }
+
+    lock.lock();
+  }
+}
+
+}  // namespace bustub
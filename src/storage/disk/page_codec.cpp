@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.cpp
+//
+// Identification: src/storage/disk/page_codec.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+/** A back reference copies at least this many bytes. */
+static constexpr size_t MIN_MATCH = 4;
+/** The last bytes of a page are always literals, as in LZ4. */
+static constexpr size_t LAST_LITERALS = 5;
+/** No back reference starts in the last bytes of a page, as in LZ4. */
+static constexpr size_t MATCH_FIND_LIMIT = 12;
+/** The largest distance of a back reference, it is encoded in 16 bits. */
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr size_t HASH_BITS = 12;
+
+static auto Read32(const char *data) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static auto Hash(uint32_t sequence) -> size_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append the part of a literal or match length that does not fit into its 4 bits of the token. */
+static auto WriteLength(size_t length, char *&op, const char *end) -> bool {
+  while (length >= 255) {
+    if (op >= end) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (op >= end) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+/**
+ * Append a sequence: a token, the literals, and a back reference to offset bytes before of match_length bytes. The
+ * last sequence has no back reference, match_length is 0 then.
+ */
+static auto WriteSequence(const char *literals, size_t num_literals, size_t offset, size_t match_length, char *&op,
+                          const char *end) -> bool {
+  if (op >= end) {
+    return false;
+  }
+  char *token = op++;
+  auto token_value = static_cast<uint8_t>(std::min<size_t>(num_literals, 15) << 4);
+  if (num_literals >= 15 && !WriteLength(num_literals - 15, op, end)) {
+    return false;
+  }
+  if (static_cast<size_t>(end - op) < num_literals) {
+    return false;
+  }
+  memcpy(op, literals, num_literals);
+  op += num_literals;
+
+  if (match_length > 0) {
+    if (end - op < 2) {
+      return false;
+    }
+    *op++ = static_cast<char>(offset & 0xFF);
+    *op++ = static_cast<char>(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    token_value |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+    if (length >= 15 && !WriteLength(length - 15, op, end)) {
+      return false;
+    }
+  }
+  *token = static_cast<char>(token_value);
+  return true;
+}
+
+/** Add the length bytes that follow a token to length. */
+static auto ReadLength(const uint8_t *&ip, const uint8_t *end, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (ip >= end) {
+      return false;
+    }
+    byte = *ip++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+auto PageCodec::Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  char *op = dst;
+  const char *end = dst + capacity;
+  size_t anchor = 0;
+
+  if (size > MATCH_FIND_LIMIT) {
+    // The last position each 4-byte sequence was seen at, -1 if none.
+    std::array<int32_t, 1 << HASH_BITS> positions;
+    positions.fill(-1);
+    size_t ip = 0;
+    size_t misses = 0;
+    while (ip < size - MATCH_FIND_LIMIT) {
+      uint32_t sequence = Read32(src + ip);
+      auto &position = positions[Hash(sequence)];
+      int32_t ref = position;
+      position = static_cast<int32_t>(ip);
+      if (ref < 0 || ip - ref > MAX_OFFSET || Read32(src + ref) != sequence) {
+        // Step faster through data that does not compress.
+        ip += 1 + (misses++ >> 6);
+        continue;
+      }
+      misses = 0;
+      size_t length = MIN_MATCH;
+      while (ip + length < size - LAST_LITERALS && src[ref + length] == src[ip + length]) {
+        length++;
+      }
+      if (!WriteSequence(src + anchor, ip - anchor, ip - ref, length, op, end)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+    }
+  }
+
+  if (!WriteSequence(src + anchor, size - anchor, 0, 0, op, end)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+auto PageCodec::Decompress(const char *src, size_t size, char *dst, size_t page_size) -> bool {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const auto *end = ip + size;
+  size_t op = 0;
+  while (ip < end) {
+    uint8_t token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !ReadLength(ip, end, &num_literals)) {
+      return false;
+    }
+    if (static_cast<size_t>(end - ip) < num_literals || page_size - op < num_literals) {
+      return false;
+    }
+    memcpy(dst + op, ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == end) {
+      // The last sequence has no back reference.
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    size_t length = token & 15;
+    if (length == 15 && !ReadLength(ip, end, &length)) {
+      return false;
+    }
+    length += MIN_MATCH;
+    if (offset == 0 || offset > op || page_size - op < length) {
+      return false;
+    }
+    // The reference may overlap the bytes it produces, e.g. a run of one repeated byte, so copy byte by byte.
+    for (size_t i = 0; i < length; ++i) {
+      dst[op + i] = dst[op - offset + i];
+    }
+    op += length;
+  }
+  return op == page_size;
+}
+
+}  // namespace bustub
@@ -1,5 +1,10 @@
+#include <cmath>
+#include <numeric>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -15,9 +20,12 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPool
       bpm_(buffer_pool_manager),
       comparator_(std::move(comparator)),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size),
-      header_page_id_(header_page_id) {
-  WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
+      internal_max_size_(
+          std::min(internal_max_size, static_cast<int>(INTERNAL_PAGE_SLOT_CNT(buffer_pool_manager->GetPageSize())))),
+      page_size_(static_cast<int>(buffer_pool_manager->GetPageSize())),
+      header_page_id_(header_page_id),
+      swizzled_(BTREE_SWIZZLE_SLOTS) {
+  WritePageGuard guard = FetchWrite(header_page_id_);
   auto root_page = guard.AsMut<BPlusTreeHeaderPage>();
   root_page->root_page_id_ = INVALID_PAGE_ID;
 }
@@ -26,7 +34,10 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPool
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
+  ReadPageGuard guard = FetchRead(header_page_id_);
+  return guard.As<BPlusTreeHeaderPage>()->root_page_id_ == INVALID_PAGE_ID;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -37,10 +48,309 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
-  // Declaration of context instance.
-  Context ctx;
-  (void)ctx;
-  return false;
+  // Lookups do not latch at all, not even the leaf: they read optimistically and start over if a writer interfered.
+  while (true) {
+    OptimisticPageGuard leaf;
+    auto descent = DescendOptimistic(key, &leaf);
+    if (descent == Descent::Empty) {
+      return false;
+    }
+    if (descent == Descent::Restart) {
+      continue;
+    }
+    auto leaf_page = leaf.template As<LeafPage>();
+    int size = leaf_page->GetSize();
+    if (size < 0 || size > leaf_max_size_) {
+      continue;
+    }
+    int index = leaf_page->KeyIndex(key, comparator_, size, page_size_);
+    auto item = leaf_page->GetItem(index, page_size_);
+    bool found = index < size && comparator_(item.first, key) == 0;
+    if (!leaf.Validate()) {
+      continue;
+    }
+    if (found) {
+      result->push_back(item.second);
+    }
+    return found;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValueBatch(const std::vector<KeyType> &keys, std::vector<std::optional<ValueType>> *result,
+                                   Transaction *txn) -> size_t {
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [this, &keys](size_t a, size_t b) { return comparator_(keys[a], keys[b]) < 0; });
+  result->assign(keys.size(), std::nullopt);
+
+  size_t found = 0;
+  size_t next = 0;
+  std::vector<std::pair<size_t, ValueType>> hits;
+  while (next < order.size()) {
+    OptimisticPageGuard leaf;
+    auto descent = DescendOptimistic(keys[order[next]], &leaf);
+    if (descent == Descent::Empty) {
+      break;
+    }
+    if (descent == Descent::Restart) {
+      continue;
+    }
+    auto leaf_page = leaf.template As<LeafPage>();
+    int size = leaf_page->GetSize();
+    if (size < 0 || size > leaf_max_size_) {
+      continue;
+    }
+    // The first key belongs to this leaf. The following ones are looked up in it too unless they are past its last key,
+    // then they need a descent of their own. Like GetValue(), nothing read is used before the leaf is validated.
+    hits.clear();
+    size_t end = next;
+    do {
+      const KeyType &key = keys[order[end]];
+      if (end > next && (size == 0 || comparator_(key, leaf_page->GetItem(size - 1, page_size_).first) > 0)) {
+        break;
+      }
+      int index = leaf_page->KeyIndex(key, comparator_, size, page_size_);
+      auto item = leaf_page->GetItem(index, page_size_);
+      if (index < size && comparator_(item.first, key) == 0) {
+        hits.emplace_back(order[end], item.second);
+      }
+      end++;
+    } while (end < order.size());
+    if (!leaf.Validate()) {
+      continue;
+    }
+    for (const auto &[i, value] : hits) {
+      (*result)[i] = value;
+    }
+    found += hits.size();
+    next = end;
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <class LeafGuard>
+auto BPLUSTREE_TYPE::DescendOptimistic(const KeyType &key, LeafGuard *leaf) -> Descent {
+  // Rather than waiting for a free frame with the pins of the path held, start over once they are released.
+  for (int attempt = 0;; attempt++) {
+    page_id_t page_id;
+    auto descent = TryDescendOptimistic(key, leaf, &page_id);
+    if (descent != Descent::NoFrame) {
+      return descent;
+    }
+    if (!BufferPoolManager::WaitForFrame(attempt)) {
+      FetchFailed(page_id, false);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <class LeafGuard>
+auto BPLUSTREE_TYPE::TryDescendOptimistic(const KeyType &key, LeafGuard *leaf, page_id_t *no_frame_page_id) -> Descent {
+  frame_id_t frame_id;
+  bool no_frame;
+  auto parent = FetchOptimistic(header_page_id_, &frame_id, &no_frame);
+  if (!parent.has_value()) {
+    if (no_frame) {
+      *no_frame_page_id = header_page_id_;
+      return Descent::NoFrame;
+    }
+    std::this_thread::yield();
+    return Descent::Restart;
+  }
+  page_id_t page_id = parent->template As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (!parent->Validate()) {
+    return Descent::Restart;
+  }
+  Swizzle(header_page_id_, frame_id);
+  if (page_id == INVALID_PAGE_ID) {
+    return Descent::Empty;
+  }
+
+  while (true) {
+    auto node = FetchOptimistic(page_id, &frame_id, &no_frame);
+    if (!node.has_value()) {
+      parent->Drop();
+      if (no_frame) {
+        *no_frame_page_id = page_id;
+        return Descent::NoFrame;
+      }
+      std::this_thread::yield();
+      return Descent::Restart;
+    }
+    // The parent has to be unchanged after the version of the child was taken, otherwise the child may have been split
+    // or merged away before that.
+    if (!parent->Validate()) {
+      return Descent::Restart;
+    }
+    parent->Drop();
+
+    if (node->template As<BPlusTreePage>()->IsLeafPage()) {
+      if constexpr (std::is_same_v<LeafGuard, OptimisticPageGuard>) {
+        *leaf = std::move(*node);
+      } else {
+        // The upgrade fails if the page changed since its version was taken, e.g. if it was not a leaf after all.
+        std::optional<LeafGuard> guard;
+        if constexpr (std::is_same_v<LeafGuard, ReadPageGuard>) {
+          guard = node->UpgradeRead();
+        } else {
+          guard = node->UpgradeWrite();
+        }
+        if (!guard.has_value()) {
+          return Descent::Restart;
+        }
+        *leaf = std::move(*guard);
+      }
+      return Descent::Leaf;
+    }
+
+    auto internal = node->template As<InternalPage>();
+    int size = internal->GetSize();
+    if (size < 1 || size > internal_max_size_) {
+      return Descent::Restart;
+    }
+    page_id_t child_id = internal->Lookup(key, comparator_, size, page_size_);
+    if (!node->Validate()) {
+      return Descent::Restart;
+    }
+    // Only inner pages are swizzled, they are few and read by every descent.
+    Swizzle(page_id, frame_id);
+    page_id = child_id;
+    parent = std::move(node);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchOptimistic(page_id_t page_id, frame_id_t *frame_id, bool *no_frame)
+    -> std::optional<OptimisticPageGuard> {
+  *frame_id = -1;
+  *no_frame = false;
+  uint64_t swizzled = swizzled_[page_id % swizzled_.size()].load(std::memory_order_relaxed);
+  if (static_cast<page_id_t>(swizzled & 0xFFFFFFFF) == page_id && (swizzled >> 32) != 0) {
+    auto guard = bpm_->FetchPageSwizzled(page_id, static_cast<frame_id_t>((swizzled >> 32) - 1));
+    if (guard.has_value()) {
+      return guard;
+    }
+  }
+  bool io_failed;
+  Page *page = bpm_->FetchPage(page_id, AccessType::Unknown, &io_failed);
+  if (page == nullptr) {
+    if (io_failed) {
+      FetchFailed(page_id, true);
+    }
+    *no_frame = true;
+    return std::nullopt;
+  }
+  OptimisticPageGuard guard(bpm_, page);
+  if (guard.IsLatched()) {
+    // Waiting for the writer with the pins of the path held could starve the writer of frames.
+    return std::nullopt;
+  }
+  *frame_id = bpm_->GetFrameId(page);
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Swizzle(page_id_t page_id, frame_id_t frame_id) {
+  if (frame_id == -1) {
+    return;
+  }
+  uint64_t swizzled = (static_cast<uint64_t>(frame_id) + 1) << 32 | static_cast<uint32_t>(page_id);
+  auto &slot = swizzled_[page_id % swizzled_.size()];
+  // Slots of hot pages are only read, so that descents on different cores do not bounce their cache line.
+  if (slot.load(std::memory_order_relaxed) != swizzled) {
+    slot.store(swizzled, std::memory_order_relaxed);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DescendPessimistic(const KeyType &key, Operation op, Context *ctx) {
+  page_id_t page_id = ctx->root_page_id_;
+  while (true) {
+    ctx->write_set_.push_back(FetchWrite(page_id));
+    auto page = ctx->write_set_.back().template As<BPlusTreePage>();
+    if (IsSafe(page, op, ctx->IsRootPage(page_id))) {
+      // Nothing above this page will be modified.
+      ctx->header_page_ = std::nullopt;
+      while (ctx->write_set_.size() > 1) {
+        ctx->write_set_.pop_front();
+      }
+    }
+    if (page->IsLeafPage()) {
+      return;
+    }
+    page_id = reinterpret_cast<const InternalPage *>(page)->Lookup(key, comparator_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *page, Operation op, bool is_root) const -> bool {
+  if (!page->IsLeafPage()) {
+    auto internal = reinterpret_cast<const InternalPage *>(page);
+    if (op == Operation::Insert) {
+      // A split below adds a key of any length.
+      return internal->HasRoomFor(sizeof(KeyType));
+    }
+    // A root with a single child is removed.
+    return is_root ? page->GetSize() > 2 : internal->CanSpare();
+  }
+  auto leaf = reinterpret_cast<const LeafPage *>(page);
+  if (op == Operation::Insert) {
+    // The key may share no prefix with the keys of the leaf.
+    return leaf->HasRoomForAnyKey();
+  }
+  if (is_root) {
+    // An empty root leaf is removed.
+    return page->GetSize() > 1;
+  }
+  return leaf->CanSpare();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PinPage(page_id_t page_id) const -> Page * {
+  Page *page;
+  bool io_failed;
+  for (int attempt = 0; (page = bpm_->FetchPage(page_id, AccessType::Unknown, &io_failed)) == nullptr; attempt++) {
+    if (io_failed || !BufferPoolManager::WaitForFrame(attempt)) {
+      FetchFailed(page_id, io_failed);
+    }
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FetchFailed(page_id_t page_id, bool io_failed) const {
+  throw Exception("cannot fetch page " + std::to_string(page_id) + " of index " + index_name_ +
+                  (io_failed ? ": the disk failed" : ": all frames of the buffer pool are pinned"));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchRead(page_id_t page_id) const -> ReadPageGuard {
+  Page *page = PinPage(page_id);
+  page->RLatch();
+  return {bpm_, page};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchWrite(page_id_t page_id) const -> WritePageGuard {
+  Page *page = PinPage(page_id);
+  page->WLatch();
+  return {bpm_, page};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewPage(page_id_t *page_id, page_id_t hint) const -> BasicPageGuard {
+  Page *page;
+  bool io_failed;
+  for (int attempt = 0; (page = bpm_->NewPage(page_id, hint, &io_failed)) == nullptr; attempt++) {
+    if (io_failed || !BufferPoolManager::WaitForFrame(attempt)) {
+      throw Exception("cannot allocate a page for index " + index_name_ +
+                      (io_failed ? ": the disk failed" : ": all frames of the buffer pool are pinned"));
+    }
+  }
+  return {bpm_, page};
 }
 
 /*****************************************************************************
@@ -55,10 +365,340 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *txn) -> bool {
-  // Declaration of context instance.
+  // Latching only the leaf is enough, unless the leaf is full and has to split.
+  while (true) {
+    WritePageGuard leaf;
+    auto descent = DescendOptimistic(key, &leaf);
+    if (descent == Descent::Restart) {
+      continue;
+    }
+    if (descent == Descent::Leaf) {
+      auto leaf_page = leaf.template As<LeafPage>();
+      if (leaf_page->HasRoomFor(key)) {
+        return leaf.template AsMut<LeafPage>()->Insert(key, value, comparator_);
+      }
+    }
+    break;
+  }
+  return InsertPessimistic(key, value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertBatch(std::vector<std::pair<KeyType, ValueType>> pairs, Transaction *txn) -> size_t {
+  // The sort is stable, so that the first of the pairs with equal keys comes first and is the one inserted.
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; });
+  InsertBatchCursor batch{&pairs, 0, 0};
+  while (batch.next_ < pairs.size()) {
+    const auto &[key, value] = pairs[batch.next_];
+    WritePageGuard leaf;
+    auto descent = DescendOptimistic(key, &leaf);
+    if (descent == Descent::Restart) {
+      continue;
+    }
+    batch.next_++;
+    if (descent == Descent::Leaf && leaf.template As<LeafPage>()->HasRoomFor(key)) {
+      // Like Insert(), only the leaf is latched while it has room. The following keys up to its last key go there too.
+      auto leaf_page = leaf.template AsMut<LeafPage>();
+      if (leaf_page->Insert(key, value, comparator_)) {
+        batch.inserted_++;
+      }
+      KeyType upper = leaf_page->KeyAt(leaf_page->GetSize() - 1);
+      InsertRun(leaf_page, &upper, true, &batch);
+      continue;
+    }
+    leaf.Drop();
+    if (InsertPessimistic(key, value, &batch)) {
+      batch.inserted_++;
+    }
+  }
+  return batch.inserted_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertRun(LeafPage *leaf, const KeyType *upper, bool inclusive, InsertBatchCursor *batch)
+    -> bool {
+  const auto &pairs = *batch->pairs_;
+  for (; batch->next_ < pairs.size(); batch->next_++) {
+    const auto &[key, value] = pairs[batch->next_];
+    if (upper != nullptr) {
+      int order = comparator_(key, *upper);
+      if (order > 0 || (order == 0 && !inclusive)) {
+        return true;
+      }
+    }
+    if (!leaf->HasRoomFor(key)) {
+      return false;
+    }
+    if (leaf->Insert(key, value, comparator_)) {
+      batch->inserted_++;
+    }
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertPessimistic(const KeyType &key, const ValueType &value, InsertBatchCursor *batch)
+    -> bool {
   Context ctx;
-  (void)ctx;
-  return false;
+  ctx.header_page_ = FetchWrite(header_page_id_);
+  ctx.root_page_id_ = ctx.header_page_->template As<BPlusTreeHeaderPage>()->root_page_id_;
+
+  if (ctx.root_page_id_ == INVALID_PAGE_ID) {
+    page_id_t root_page_id;
+    auto root_guard = NewPage(&root_page_id, header_page_id_);
+    auto root = root_guard.template AsMut<LeafPage>();
+    root->Init(leaf_max_size_, page_size_);
+    root->Insert(key, value, comparator_);
+    if (batch != nullptr) {
+      // The new root covers all keys.
+      InsertRun(root, nullptr, false, batch);
+    }
+    ctx.header_page_->template AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    return true;
+  }
+
+  DescendPessimistic(key, Operation::Insert, &ctx);
+  auto &leaf_guard = ctx.write_set_.back();
+  ValueType existing;
+  if (leaf_guard.template As<LeafPage>()->Lookup(key, &existing, comparator_)) {
+    return false;
+  }
+  auto leaf = leaf_guard.template AsMut<LeafPage>();
+  if (leaf->HasRoomFor(key)) {
+    bool inserted = leaf->Insert(key, value, comparator_);
+    if (batch != nullptr) {
+      KeyType upper = leaf->KeyAt(leaf->GetSize() - 1);
+      InsertRun(leaf, &upper, true, batch);
+    }
+    return inserted;
+  }
+
+  // Split the full leaf. It stays latched until its parent links the new page, so that no reader misses the moved keys.
+  AllocateSplitPages(&ctx);
+  page_id_t new_leaf_id;
+  auto new_leaf_guard = TakeSplitPage(&ctx, &new_leaf_id);
+  auto new_leaf = new_leaf_guard.template AsMut<LeafPage>();
+  new_leaf->Init(leaf_max_size_, page_size_);
+  leaf->InsertAndSplitTo(key, value, comparator_, new_leaf, new_leaf_id);
+  KeyType separator = InternalPage::Separator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0));
+  if (batch != nullptr) {
+    // Both halves are still latched: the keys less than the separator go to the old leaf, the keys up to the last key
+    // of the new leaf to the new one.
+    KeyType upper = new_leaf->KeyAt(new_leaf->GetSize() - 1);
+    if (InsertRun(leaf, &separator, false, batch)) {
+      InsertRun(new_leaf, &upper, true, batch);
+    }
+  }
+  InsertIntoParent(&ctx, ctx.write_set_.size() - 1, leaf_guard.PageId(), separator, new_leaf_id);
+  FreeSplitPages(&ctx);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AllocateSplitPages(Context *ctx) {
+  // Every latched page may split, except the topmost one if it is safe, and a new root is needed if the root splits,
+  // which it only can while the header page is latched. New pages are placed next to the page they split from, and a
+  // new root next to the old one, so that scans stay mostly sequential on disk.
+  size_t levels = ctx->write_set_.size();
+  size_t count = ctx->header_page_.has_value() ? levels + 1 : levels - 1;
+  try {
+    for (size_t i = 0; i < count; i++) {
+      page_id_t page_id;
+      auto guard = NewPage(&page_id, ctx->write_set_[levels - 1 - std::min(i, levels - 1)].PageId());
+      ctx->new_pages_.emplace_back(page_id, std::move(guard));
+    }
+  } catch (const Exception &) {
+    FreeSplitPages(ctx);
+    throw;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TakeSplitPage(Context *ctx, page_id_t *page_id) -> BasicPageGuard {
+  BUSTUB_ASSERT(!ctx->new_pages_.empty(), "a split takes a page that was allocated for it");
+  *page_id = ctx->new_pages_.front().first;
+  auto guard = std::move(ctx->new_pages_.front().second);
+  ctx->new_pages_.pop_front();
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FreeSplitPages(Context *ctx) {
+  for (auto &[page_id, guard] : ctx->new_pages_) {
+    guard.Drop();
+    bpm_->DeletePage(page_id);
+  }
+  ctx->new_pages_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(Context *ctx, size_t level, page_id_t left_id, const KeyType &key,
+                                      page_id_t right_id) {
+  if (level == 0) {
+    // Only the root can split without its parent being latched, since every other page that splits was not safe.
+    BUSTUB_ASSERT(ctx->IsRootPage(left_id), "the parent of a split page must be latched");
+    page_id_t root_page_id;
+    auto root_guard = TakeSplitPage(ctx, &root_page_id);
+    auto root = root_guard.template AsMut<InternalPage>();
+    root->Init(internal_max_size_, page_size_);
+    root->PopulateNewRoot(left_id, key, right_id);
+    ctx->header_page_->template AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    return;
+  }
+
+  auto &parent_guard = ctx->write_set_[level - 1];
+  auto parent = parent_guard.template AsMut<InternalPage>();
+  if (parent->HasRoomFor(InternalPage::KeyLength(key))) {
+    parent->InsertNodeAfter(left_id, key, right_id);
+    return;
+  }
+
+  page_id_t new_page_id;
+  auto new_guard = TakeSplitPage(ctx, &new_page_id);
+  auto new_page = new_guard.template AsMut<InternalPage>();
+  new_page->Init(internal_max_size_, page_size_);
+  KeyType middle_key = parent->InsertAndSplitTo(left_id, key, right_id, new_page);
+  InsertIntoParent(ctx, level - 1, parent_guard.PageId(), middle_key, new_page_id);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/** @return the number of entries a bulk loaded page is filled with */
+static auto BulkLoadFill(int max_size, int min_size, double fill_factor) -> int {
+  return std::clamp(static_cast<int>(std::lround(max_size * fill_factor)), min_size, max_size);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(KeyType *key, ValueType *value)> &next, double fill_factor)
+    -> bool {
+  // The header page stays latched until the root is linked, so no writer runs into the tree while it is built.
+  auto header_guard = FetchWrite(header_page_id_);
+  if (header_guard.template As<BPlusTreeHeaderPage>()->root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+
+  // The leaves are filled as the pairs stream in, and the first key and page id of each is kept for the level above.
+  // Every page is allocated next to the one before it, so that the tree is laid out in key order on disk. A leaf is
+  // filled up to the fill factor of its max size or of its bytes, whichever comes first.
+  int leaf_min_size = std::max(leaf_max_size_ / 2, 1);
+  int leaf_fill = BulkLoadFill(leaf_max_size_, leaf_min_size, fill_factor);
+  int leaf_fill_bytes = std::clamp(static_cast<int>(page_size_ * fill_factor),
+                                   page_size_ / 2 + static_cast<int>(sizeof(MappingType)), page_size_);
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  BasicPageGuard prev_guard;
+  BasicPageGuard leaf_guard;
+  LeafPage *prev = nullptr;
+  LeafPage *leaf = nullptr;
+  KeyType key;
+  ValueType value;
+  bool sorted = true;
+  while (next(&key, &value)) {
+    if (leaf != nullptr) {
+      int order = comparator_(key, leaf->KeyAt(leaf->GetSize() - 1));
+      if (order == 0) {
+        continue;
+      }
+      if (order < 0) {
+        sorted = false;
+        break;
+      }
+    }
+    if (leaf == nullptr || leaf->GetSize() == leaf_fill || leaf->GetUsedBytesWith(key) > leaf_fill_bytes ||
+        !leaf->HasRoomFor(key)) {
+      page_id_t page_id;
+      auto guard = NewPage(&page_id, level.empty() ? header_page_id_ : level.back().second);
+      auto new_leaf = guard.template AsMut<LeafPage>();
+      new_leaf->Init(leaf_max_size_, page_size_);
+      if (leaf != nullptr) {
+        leaf->SetNextPageId(page_id);
+      }
+      // The first leaf needs no separator, its key becomes the invalid first key of its parent.
+      level.emplace_back(leaf == nullptr ? key : InternalPage::Separator(leaf->KeyAt(leaf->GetSize() - 1), key),
+                         page_id);
+      prev_guard = std::move(leaf_guard);
+      prev = leaf;
+      leaf_guard = std::move(guard);
+      leaf = new_leaf;
+    }
+    leaf->Append(key, value);
+  }
+
+  if (!sorted) {
+    prev_guard.Drop();
+    leaf_guard.Drop();
+    for (const auto &[first_key, page_id] : level) {
+      bpm_->DeletePage(page_id);
+    }
+    return false;
+  }
+  if (prev != nullptr && !leaf->IsHalfFull()) {
+    if (leaf->FitsInto(prev)) {
+      leaf->MoveAllTo(prev);
+      leaf_guard.Drop();
+      bpm_->DeletePage(level.back().second);
+      level.pop_back();
+    } else {
+      while (!leaf->IsHalfFull() && prev->CanSpare() && leaf->HasRoomFor(prev->KeyAt(prev->GetSize() - 1))) {
+        prev->MoveLastToFrontOf(leaf);
+      }
+      level.back().first = InternalPage::Separator(prev->KeyAt(prev->GetSize() - 1), leaf->KeyAt(0));
+    }
+  }
+  prev_guard.Drop();
+  leaf_guard.Drop();
+
+  // Every inner level is built from the first keys and page ids of the level below, until a single page is left. An
+  // inner page is filled up to the fill factor of its max size or of its bytes, whichever comes first, and the last
+  // page of a level is fixed up like the last leaf.
+  int internal_fill = BulkLoadFill(internal_max_size_, std::max(internal_max_size_ / 2, 2), fill_factor);
+  int internal_fill_bytes = std::clamp(static_cast<int>(page_size_ * fill_factor),
+                                       page_size_ / 2 + INTERNAL_PAGE_SLOT_SIZE + static_cast<int>(sizeof(KeyType)),
+                                       page_size_);
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parents;
+    BasicPageGuard prev_node_guard;
+    BasicPageGuard node_guard;
+    InternalPage *prev_node = nullptr;
+    InternalPage *node = nullptr;
+    for (const auto &[first_key, child_id] : level) {
+      int key_length = InternalPage::KeyLength(first_key);
+      if (node == nullptr || node->GetSize() == internal_fill ||
+          node->GetUsedBytes() + INTERNAL_PAGE_SLOT_SIZE + key_length > internal_fill_bytes ||
+          !node->HasRoomFor(key_length)) {
+        page_id_t page_id;
+        auto guard = NewPage(&page_id, parents.empty() ? child_id : parents.back().second);
+        auto new_node = guard.template AsMut<InternalPage>();
+        new_node->Init(internal_max_size_, page_size_);
+        parents.emplace_back(first_key, page_id);
+        prev_node_guard = std::move(node_guard);
+        prev_node = node;
+        node_guard = std::move(guard);
+        node = new_node;
+      }
+      node->Append(first_key, child_id);
+    }
+    if (prev_node != nullptr && !node->IsHalfFull()) {
+      if (node->FitsInto(prev_node, parents.back().first)) {
+        node->MoveAllTo(prev_node, parents.back().first);
+        node_guard.Drop();
+        bpm_->DeletePage(parents.back().second);
+        parents.pop_back();
+      } else {
+        while (!node->IsHalfFull() && prev_node->CanSpare()) {
+          parents.back().first = prev_node->MoveLastToFrontOf(node, parents.back().first);
+        }
+      }
+    }
+    prev_node_guard.Drop();
+    node_guard.Drop();
+    level = std::move(parents);
+  }
+  if (!level.empty()) {
+    header_guard.template AsMut<BPlusTreeHeaderPage>()->root_page_id_ = level[0].second;
+  }
+  return true;
 }
 
 /*****************************************************************************
@@ -73,9 +713,176 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
-  // Declaration of context instance.
-  Context ctx;
-  (void)ctx;
+  // Latching only the leaf is enough, unless the leaf underflows.
+  while (true) {
+    WritePageGuard leaf;
+    auto descent = DescendOptimistic(key, &leaf);
+    if (descent == Descent::Restart) {
+      continue;
+    }
+    if (descent == Descent::Empty) {
+      return;
+    }
+    auto leaf_page = leaf.template As<LeafPage>();
+    ValueType value;
+    if (!leaf_page->Lookup(key, &value, comparator_)) {
+      return;
+    }
+    if (leaf_page->CanSpare()) {
+      leaf.template AsMut<LeafPage>()->Remove(key, comparator_);
+      return;
+    }
+    break;
+  }
+  RemovePessimistic(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemovePessimistic(const KeyType &key) {
+  std::vector<page_id_t> deleted;
+  {
+    Context ctx;
+    ctx.header_page_ = FetchWrite(header_page_id_);
+    ctx.root_page_id_ = ctx.header_page_->template As<BPlusTreeHeaderPage>()->root_page_id_;
+    if (ctx.root_page_id_ == INVALID_PAGE_ID) {
+      return;
+    }
+
+    DescendPessimistic(key, Operation::Remove, &ctx);
+    auto &leaf_guard = ctx.write_set_.back();
+    ValueType value;
+    if (!leaf_guard.template As<LeafPage>()->Lookup(key, &value, comparator_)) {
+      return;
+    }
+    auto siblings = PinSiblings(&ctx);
+    leaf_guard.template AsMut<LeafPage>()->Remove(key, comparator_);
+    Rebalance(&ctx, ctx.write_set_.size() - 1, &deleted);
+  }
+  // A page that is still pinned, e.g. by an optimistic reader that is about to notice the change, is not deleted.
+  for (auto page_id : deleted) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PinSiblings(Context *ctx) -> std::vector<BasicPageGuard> {
+  // Every latched page below the topmost one may underflow. Its parent is latched and not modified before the page is
+  // rebalanced, so the sibling Rebalance() picks is known already.
+  std::vector<BasicPageGuard> siblings;
+  for (size_t level = 1; level < ctx->write_set_.size(); level++) {
+    auto parent = ctx->write_set_[level - 1].template As<InternalPage>();
+    int index = parent->ValueIndex(ctx->write_set_[level].PageId());
+    page_id_t sibling_id = parent->ValueAt(index + 1 < parent->GetSize() ? index + 1 : index - 1);
+    siblings.emplace_back(bpm_, PinPage(sibling_id));
+  }
+  return siblings;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Rebalance(Context *ctx, size_t level, std::vector<page_id_t> *deleted) {
+  auto &guard = ctx->write_set_[level];
+  page_id_t page_id = guard.PageId();
+  auto page = guard.template As<BPlusTreePage>();
+
+  if (ctx->IsRootPage(page_id)) {
+    if (page->IsLeafPage() && page->GetSize() == 0) {
+      ctx->header_page_->template AsMut<BPlusTreeHeaderPage>()->root_page_id_ = INVALID_PAGE_ID;
+      deleted->push_back(page_id);
+    } else if (!page->IsLeafPage() && page->GetSize() == 1) {
+      ctx->header_page_->template AsMut<BPlusTreeHeaderPage>()->root_page_id_ =
+          guard.template As<InternalPage>()->ValueAt(0);
+      deleted->push_back(page_id);
+    }
+    return;
+  }
+  if (page->IsLeafPage() ? reinterpret_cast<const LeafPage *>(page)->IsHalfFull()
+                         : reinterpret_cast<const InternalPage *>(page)->IsHalfFull()) {
+    return;
+  }
+  BUSTUB_ASSERT(level > 0, "the parent of an underflowing page must be latched");
+
+  auto &parent_guard = ctx->write_set_[level - 1];
+  auto parent = parent_guard.template AsMut<InternalPage>();
+  int index = parent->ValueIndex(page_id);
+  bool sibling_is_right = index + 1 < parent->GetSize();
+  page_id_t sibling_id = parent->ValueAt(sibling_is_right ? index + 1 : index - 1);
+  WritePageGuard sibling_guard;
+  if (sibling_is_right || !page->IsLeafPage()) {
+    sibling_guard = FetchWrite(sibling_id);
+  } else {
+    // Index iterators latch leaves from left to right, waiting for the left sibling while holding this leaf could
+    // deadlock with one. An underfull leaf is still a valid leaf, it is left as it is if its sibling is busy.
+    Page *sibling_page = PinPage(sibling_id);
+    if (!sibling_page->TryWLatch()) {
+      bpm_->UnpinPage(sibling_id, false);
+      return;
+    }
+    sibling_guard = WritePageGuard(bpm_, sibling_page);
+  }
+
+  // The key in the parent that separates the page from its sibling. A page that is left underfull because the parent
+  // has no room for a longer separator, or the two pages do not fit into one, is still valid.
+  int separator_index = sibling_is_right ? index + 1 : index;
+  if (page->IsLeafPage()) {
+    auto node = guard.template AsMut<LeafPage>();
+    auto sibling = sibling_guard.template AsMut<LeafPage>();
+    int size = sibling->GetSize();
+    if (sibling->CanSpare() && node->HasRoomFor(sibling->KeyAt(sibling_is_right ? 0 : size - 1))) {
+      // The new separator goes between the pair that moves over and the pair next to it in the sibling.
+      KeyType separator = sibling_is_right
+                              ? InternalPage::Separator(sibling->KeyAt(0), sibling->KeyAt(1))
+                              : InternalPage::Separator(sibling->KeyAt(size - 2), sibling->KeyAt(size - 1));
+      if (!parent->CanSetKeyAt(separator_index, separator)) {
+        return;
+      }
+      if (sibling_is_right) {
+        sibling->MoveFirstToEndOf(node);
+      } else {
+        sibling->MoveLastToFrontOf(node);
+      }
+      parent->SetKeyAt(separator_index, separator);
+      return;
+    }
+    if (sibling_is_right ? !sibling->FitsInto(node) : !node->FitsInto(sibling)) {
+      return;
+    }
+    if (sibling_is_right) {
+      sibling->MoveAllTo(node);
+      parent->Remove(index + 1);
+      deleted->push_back(sibling_id);
+    } else {
+      node->MoveAllTo(sibling);
+      parent->Remove(index);
+      deleted->push_back(page_id);
+    }
+  } else {
+    auto node = guard.template AsMut<InternalPage>();
+    auto sibling = sibling_guard.template AsMut<InternalPage>();
+    KeyType middle_key = parent->KeyAt(separator_index);
+    if (sibling->CanSpare() &&
+        parent->CanSetKeyAt(separator_index,
+                            sibling_is_right ? sibling->KeyAt(1) : sibling->KeyAt(sibling->GetSize() - 1))) {
+      if (sibling_is_right) {
+        parent->SetKeyAt(index + 1, sibling->MoveFirstToEndOf(node, middle_key));
+      } else {
+        parent->SetKeyAt(index, sibling->MoveLastToFrontOf(node, middle_key));
+      }
+      return;
+    }
+    if (sibling_is_right ? !sibling->FitsInto(node, middle_key) : !node->FitsInto(sibling, middle_key)) {
+      return;
+    }
+    if (sibling_is_right) {
+      sibling->MoveAllTo(node, middle_key);
+      parent->Remove(index + 1);
+      deleted->push_back(sibling_id);
+    } else {
+      node->MoveAllTo(sibling, middle_key);
+      parent->Remove(index);
+      deleted->push_back(page_id);
+    }
+  }
+  Rebalance(ctx, level - 1, deleted);
 }
 
 /*****************************************************************************
@@ -87,7 +894,19 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  ReadPageGuard guard = FetchRead(header_page_id_);
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return End();
+  }
+  // Latch coupling with read latches, the assignment releases the parent after the child is latched.
+  guard = FetchRead(page_id);
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    guard = FetchRead(guard.As<InternalPage>()->ValueAt(0));
+  }
+  return INDEXITERATOR_TYPE(bpm_, std::move(guard), 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -95,7 +914,19 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  while (true) {
+    ReadPageGuard leaf;
+    auto descent = DescendOptimistic(key, &leaf);
+    if (descent == Descent::Empty) {
+      return End();
+    }
+    if (descent == Descent::Leaf) {
+      int index = leaf.As<LeafPage>()->KeyIndex(key, comparator_);
+      return INDEXITERATOR_TYPE(bpm_, std::move(leaf), index);
+    }
+  }
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -109,7 +940,10 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  * @return Page id of the root of this tree
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return header_page_id_; }
+auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
+  ReadPageGuard guard = FetchRead(header_page_id_);
+  return guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+}
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
@@ -154,6 +988,8 @@ void BPLUSTREE_TYPE::BatchOpsFromFile(const std::string &file_name, Transaction
   int64_t key;
   char instruction;
   std::ifstream input(file_name);
+  // Consecutive inserts are applied as one batch, before the next remove.
+  std::vector<std::pair<KeyType, ValueType>> inserts;
   while (input) {
     input >> instruction >> key;
     RID rid(key);
@@ -161,15 +997,18 @@ void BPLUSTREE_TYPE::BatchOpsFromFile(const std::string &file_name, Transaction
     index_key.SetFromInteger(key);
     switch (instruction) {
       case 'i':
-        Insert(index_key, rid, txn);
+        inserts.emplace_back(index_key, rid);
         break;
       case 'd':
+        InsertBatch(std::move(inserts), txn);
+        inserts.clear();
         Remove(index_key, txn);
         break;
       default:
         break;
     }
   }
+  InsertBatch(std::move(inserts), txn);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
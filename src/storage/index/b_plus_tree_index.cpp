@@ -11,6 +11,8 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+
 namespace bustub {
 /*
  * Constructor
@@ -20,15 +22,20 @@ BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
     : Index(std::move(metadata)), comparator_(GetMetadata()->GetKeySchema()) {
   page_id_t header_page_id;
   buffer_pool_manager->NewPage(&header_page_id);
-  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(GetMetadata()->GetName(), header_page_id,
-                                                                              buffer_pool_manager, comparator_);
+  // Fill the pages of the database, which are not necessarily BUSTUB_PAGE_SIZE bytes.
+  size_t page_size = buffer_pool_manager->GetPageSize();
+  auto leaf_max_size = static_cast<int>(LEAF_PAGE_SLOT_CNT(page_size));
+  // Inner pages are bounded by the bytes of their keys, which are stored without trailing zeros, not by a count.
+  auto internal_max_size = static_cast<int>(INTERNAL_PAGE_SLOT_CNT(page_size));
+  container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(
+      GetMetadata()->GetName(), header_page_id, buffer_pool_manager, comparator_, leaf_max_size, internal_max_size);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   return container_->Insert(index_key, rid, transaction);
 }
@@ -37,7 +44,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_->Remove(index_key, transaction);
 }
@@ -46,11 +53,29 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema());
 
   container_->GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> entries, Transaction *transaction)
+    -> bool {
+  // The sort is stable, so that the first of the entries with equal keys comes first and is the one kept.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [this](const auto &a, const auto &b) { return comparator_(a.first, b.first) < 0; });
+  auto it = entries.cbegin();
+  return container_->BulkLoad([&](KeyType *key, ValueType *value) {
+    if (it == entries.cend()) {
+      return false;
+    }
+    *key = it->first;
+    *value = it->second;
+    ++it;
+    return true;
+  });
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_->Begin(); }
 
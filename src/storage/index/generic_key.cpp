@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key.cpp
+//
+// Identification: src/storage/index/generic_key.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/generic_key.h"
+
+#include <algorithm>
+#include <string>
+
+#include "common/exception.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** @brief Append the num_bytes low bytes of bits to out, most significant first. */
+static void AppendBigEndian(uint64_t bits, size_t num_bytes, std::string *out) {
+  for (size_t i = num_bytes; i-- > 0;) {
+    out->push_back(static_cast<char>(bits >> (8 * i)));
+  }
+}
+
+/** @brief Read num_bytes bytes at pos of data, most significant first, as zeros where they are past size. */
+static auto ReadBigEndian(const char *data, size_t size, size_t *pos, size_t num_bytes) -> uint64_t {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < num_bytes; i++, (*pos)++) {
+    bits = bits << 8 | (*pos < size ? static_cast<uint8_t>(data[*pos]) : 0);
+  }
+  return bits;
+}
+
+/** @return the size of a fixed size type in a normalized key */
+static auto NormalizedSize(TypeId type) -> size_t {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return 1;
+    case TypeId::SMALLINT:
+      return 2;
+    case TypeId::INTEGER:
+      return 4;
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      return 8;
+    default:
+      throw Exception(ExceptionType::NOT_IMPLEMENTED, "type can't be part of an index key");
+  }
+}
+
+/** @return the bits that order like the value, stored with the size of its type at value_data */
+static auto NormalizeFixed(TypeId type, const char *value_data) -> uint64_t {
+  size_t size = NormalizedSize(type);
+  uint64_t bits = 0;
+  memcpy(&bits, value_data, size);
+  if (type == TypeId::DECIMAL) {
+    // Negative doubles order backwards by their bits, positive ones after them.
+    return (bits >> 63) != 0 ? ~bits : bits ^ (uint64_t{1} << 63);
+  }
+  if (type == TypeId::TIMESTAMP) {
+    return bits;
+  }
+  return bits ^ (uint64_t{1} << (8 * size - 1));
+}
+
+void NormalizeKey(const Tuple &key, const Schema &key_schema, char *data, size_t size) {
+  std::string normalized;
+  for (uint32_t i = 0; i < key_schema.GetColumnCount() && normalized.size() < size; i++) {
+    const auto &col = key_schema.GetColumn(i);
+    const char *col_data = key.GetData() + col.GetOffset();
+    if (col.IsInlined()) {
+      AppendBigEndian(NormalizeFixed(col.GetType(), col_data), NormalizedSize(col.GetType()), &normalized);
+      continue;
+    }
+    uint32_t offset;
+    uint32_t len;
+    memcpy(&offset, col_data, sizeof(uint32_t));
+    memcpy(&len, key.GetData() + offset, sizeof(uint32_t));
+    if (len == BUSTUB_VALUE_NULL) {
+      normalized.append(2, '\0');
+      continue;
+    }
+    const char *str = key.GetData() + offset + sizeof(uint32_t);
+    // The terminating zero byte of the varchar is not part of it.
+    if (len > 0 && str[len - 1] == '\0') {
+      len--;
+    }
+    for (uint32_t j = 0; j < len && normalized.size() < size; j++) {
+      normalized.push_back(str[j]);
+      if (str[j] == '\0') {
+        normalized.push_back('\xFF');
+      }
+    }
+    normalized.push_back('\0');
+    normalized.push_back('\x01');
+  }
+  memset(data, 0, size);
+  memcpy(data, normalized.data(), std::min(normalized.size(), size));
+}
+
+auto DenormalizeKeyColumn(const char *data, size_t size, const Schema &key_schema, uint32_t column_idx) -> Value {
+  size_t pos = 0;
+  for (uint32_t i = 0;; i++) {
+    TypeId type = key_schema.GetColumn(i).GetType();
+    if (type != TypeId::VARCHAR) {
+      size_t type_size = NormalizedSize(type);
+      uint64_t bits = ReadBigEndian(data, size, &pos, type_size);
+      if (i < column_idx) {
+        continue;
+      }
+      // Undo NormalizeFixed().
+      if (type == TypeId::DECIMAL) {
+        bits = (bits >> 63) != 0 ? bits ^ (uint64_t{1} << 63) : ~bits;
+        double d;
+        memcpy(&d, &bits, sizeof(double));
+        return {type, d};
+      }
+      if (type != TypeId::TIMESTAMP) {
+        bits ^= uint64_t{1} << (8 * type_size - 1);
+      }
+      switch (type) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          return {type, static_cast<int8_t>(bits)};
+        case TypeId::SMALLINT:
+          return {type, static_cast<int16_t>(bits)};
+        case TypeId::INTEGER:
+          return {type, static_cast<int32_t>(bits)};
+        case TypeId::BIGINT:
+          return {type, static_cast<int64_t>(bits)};
+        default:
+          return {type, bits};
+      }
+    }
+
+    std::string str;
+    bool is_null = pos + 1 < size && data[pos] == '\0' && data[pos + 1] == '\0';
+    while (pos < size) {
+      if (data[pos] != '\0') {
+        str.push_back(data[pos++]);
+        continue;
+      }
+      // 0x00 0xFF is an escaped zero byte, 0x00 0x01 or 0x00 0x00 the end of the varchar.
+      if (pos + 1 < size && data[pos + 1] == '\xFF') {
+        str.push_back('\0');
+        pos += 2;
+        continue;
+      }
+      pos += 2;
+      break;
+    }
+    if (i == column_idx) {
+      return is_null ? ValueFactory::GetNullValueByType(TypeId::VARCHAR) : Value(TypeId::VARCHAR, str);
+    }
+  }
+}
+
+}  // namespace bustub
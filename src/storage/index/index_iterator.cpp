@@ -2,29 +2,76 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <string>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index)
+    : bpm_(bpm), guard_(std::move(guard)), index_(index) {
+  page_id_ = guard_.PageId();
+  read_ahead_.emplace(bpm_);
+  read_ahead_->Access(page_id_);
+  SkipExhaustedLeaves();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_id_ == INVALID_PAGE_ID; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  item_ = guard_.As<LeafPage>()->GetItem(index_);
+  return item_;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (page_id_ != INVALID_PAGE_ID && index_ >= guard_.As<LeafPage>()->GetSize()) {
+    page_id_ = guard_.As<LeafPage>()->GetNextPageId();
+    index_ = 0;
+    if (page_id_ == INVALID_PAGE_ID) {
+      guard_.Drop();
+    } else {
+      // Latch coupling from left to right, the assignment releases the current leaf after the next one is latched. Wait
+      // for a free frame if the buffer pool has all of its frames pinned. The leaves are fetched as a scan, so that
+      // they are recycled before the leaves read ahead of them.
+      Page *page;
+      bool io_failed;
+      for (int attempt = 0; (page = bpm_->FetchPage(page_id_, AccessType::Scan, &io_failed)) == nullptr; attempt++) {
+        if (io_failed || !BufferPoolManager::WaitForFrame(attempt)) {
+          // The scan cannot go on, it ends here rather than skipping the leaf.
+          page_id_t page_id = page_id_;
+          page_id_ = INVALID_PAGE_ID;
+          guard_.Drop();
+          throw Exception("cannot fetch leaf page " + std::to_string(page_id) +
+                          (io_failed ? ": the disk failed" : ": all frames of the buffer pool are pinned"));
+        }
+      }
+      page->RLatch();
+      guard_ = ReadPageGuard(bpm_, page);
+      // Read ahead once the previous leaf is unpinned, so that it makes room for the leaves read ahead rather than them
+      // making room for each other.
+      read_ahead_->Access(page_id_);
+    }
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -9,11 +9,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_key_search.h"
 
 namespace bustub {
 /*****************************************************************************
@@ -21,14 +26,15 @@ namespace bustub {
  *****************************************************************************/
 /*
  * Init method after creating a new internal page
- * Including set page type, set current size, and set max page size
+ * Including set page type, set current size, set max page size and the bytes of the page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
-  // replace with your own code
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size, int page_size) {
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
   SetMaxSize(max_size);
+  page_size_ = page_size;
+  key_bytes_ = 0;
 }
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
@@ -37,15 +43,23 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   BUSTUB_ENSURE(index < GetSize(), "index out of range")
-  BUSTUB_ENSURE(index > 0, "index out of range")
-  return array_[index].first;
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  return ReadKey(Slots()[index], page_size_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
   BUSTUB_ENSURE(index < GetSize(), "index out of range")
   BUSTUB_ENSURE(index > 0, "index out of range")
-  array_[index].first = key;
+  BUSTUB_ENSURE(CanSetKeyAt(index, key), "no room for the key")
+  Slot &slot = Slots()[index];
+  if (KeyLength(key) == slot.key_length_) {
+    memcpy(reinterpret_cast<char *>(this) + slot.key_offset_, &key, slot.key_length_);
+    return;
+  }
+  auto items = GetItems();
+  items[index].first = key;
+  SetItems(items);
 }
 
 /*
@@ -55,8 +69,270 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
   BUSTUB_ENSURE(index < GetSize(), "index out of range")
-  BUSTUB_ENSURE(index > 0, "index out of range")
-  return array_[index].second;
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  return Slots()[index].value_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  BUSTUB_ENSURE(index < GetSize(), "index out of range")
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  Slots()[index].value_ = value;
+}
+
+/*
+ * Helper method to find the index of a child, -1 if the page does not contain it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (Slots()[i].value_ == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyLength(const KeyType &key) -> int {
+  auto data = reinterpret_cast<const char *>(&key);
+  int length = sizeof(KeyType);
+  while (length > 0 && data[length - 1] == 0) {
+    length--;
+  }
+  return length;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Separator(const KeyType &left, const KeyType &right) -> KeyType {
+  // The bytes of right up to the first one that differs from left, which is greater there.
+  auto left_data = reinterpret_cast<const char *>(&left);
+  auto right_data = reinterpret_cast<const char *>(&right);
+  size_t length = 0;
+  while (length < sizeof(KeyType) && left_data[length] == right_data[length]) {
+    length++;
+  }
+  KeyType separator{};
+  memcpy(reinterpret_cast<char *>(&separator), right_data, std::min(length + 1, sizeof(KeyType)));
+  return separator;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index, const KeyType &key) const -> bool {
+  return GetUsedBytes() - Slots()[index].key_length_ + KeyLength(key) <= page_size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FitsInto(const BPlusTreeInternalPage *recipient, const KeyType &middle_key) const
+    -> bool {
+  // The first key of this page is invalid and takes no bytes, middle_key takes its place.
+  return recipient->GetSize() + GetSize() <= recipient->GetMaxSize() &&
+         recipient->GetUsedBytes() + GetSize() * INTERNAL_PAGE_SLOT_SIZE + key_bytes_ + KeyLength(middle_key) <=
+             recipient->page_size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ReadKey(const Slot &slot, int page_size) const -> KeyType {
+  KeyType key{};
+  int length = slot.key_length_;
+  if (length <= static_cast<int>(sizeof(KeyType)) && slot.key_offset_ + length <= page_size) {
+    memcpy(reinterpret_cast<char *>(&key), reinterpret_cast<const char *>(this) + slot.key_offset_, length);
+  }
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItems() const -> std::vector<MappingType> {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.emplace_back(ReadKey(Slots()[i], page_size_), Slots()[i].value_);
+  }
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetItems(const std::vector<MappingType> &items) {
+  SetSize(0);
+  key_bytes_ = 0;
+  for (const auto &[key, value] : items) {
+    Append(key, value);
+  }
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+/*
+ * Find the last child whose key is not greater than key, the first key is invalid and treated as negative infinity
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChildIndex(const KeyType &key, const KeyComparator &comparator, int size,
+                                                int page_size) const -> int {
+  if constexpr (IntegerKey<KeyType, KeyComparator>::IS_INTEGER) {
+    // The number of keys after the first that are not greater than key, read like ReadKey() but as integers.
+    const Slot *slots = Slots() + 1;
+    auto page = reinterpret_cast<const char *>(this);
+    auto read = [slots, page, page_size](int i) -> uint64_t {
+      int length = slots[i].key_length_;
+      if (length > static_cast<int>(sizeof(KeyType)) || slots[i].key_offset_ + length > page_size) {
+        return 0;
+      }
+      return IntegerKey<KeyType, KeyComparator>::Read(page + slots[i].key_offset_, length);
+    };
+    return SearchIntegers(size - 1, IntegerKey<KeyType, KeyComparator>::Read(reinterpret_cast<const char *>(&key)),
+                          true, read);
+  }
+  int left = 1;
+  int right = size;
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator(ReadKey(Slots()[mid], page_size), key) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left - 1;
+}
+
+/*****************************************************************************
+ * INSERTION AND REMOVAL
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &key,
+                                                     const ValueType &new_value) {
+  SetSize(0);
+  key_bytes_ = 0;
+  Append(key, old_value);
+  Append(key, new_value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &key,
+                                                     const ValueType &new_value) {
+  int index = ValueIndex(old_value) + 1;
+  BUSTUB_ENSURE(index > 0, "old_value is not a child of the page")
+  BUSTUB_ENSURE(HasRoomFor(KeyLength(key)), "no room for the key")
+  if (index == GetSize()) {
+    Append(key, new_value);
+    return;
+  }
+  auto items = GetItems();
+  items.insert(items.begin() + index, {key, new_value});
+  SetItems(items);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  int length = GetSize() == 0 ? 0 : KeyLength(key);
+  BUSTUB_ENSURE(HasRoomFor(length), "no room for the key")
+  key_bytes_ += length;
+  Slot &slot = Slots()[GetSize()];
+  slot.value_ = value;
+  slot.key_offset_ = static_cast<uint16_t>(page_size_ - key_bytes_);
+  slot.key_length_ = static_cast<uint16_t>(length);
+  memcpy(reinterpret_cast<char *>(this) + slot.key_offset_, &key, length);
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  BUSTUB_ENSURE(index < GetSize(), "index out of range")
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  if (index == GetSize() - 1 && index > 0) {
+    // The key of the last child is the lowest in the page, dropping it leaves the others packed.
+    key_bytes_ -= Slots()[index].key_length_;
+    IncreaseSize(-1);
+    return;
+  }
+  auto items = GetItems();
+  items.erase(items.begin() + index);
+  SetItems(items);
+}
+
+/*****************************************************************************
+ * SPLIT AND MERGE
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAndSplitTo(const ValueType &old_value, const KeyType &key,
+                                                      const ValueType &new_value, BPlusTreeInternalPage *recipient)
+    -> KeyType {
+  // The page has no room for the new child, so the children are merged in a buffer and then split by their bytes.
+  int index = ValueIndex(old_value) + 1;
+  BUSTUB_ENSURE(index > 0, "old_value is not a child of the page")
+  auto items = GetItems();
+  items.insert(items.begin() + index, {key, new_value});
+  auto num_items = static_cast<int>(items.size());
+  std::vector<int> lengths(num_items);
+  int total_bytes = INTERNAL_PAGE_SLOT_SIZE;
+  for (int i = 1; i < num_items; i++) {
+    lengths[i] = KeyLength(items[i].first);
+    total_bytes += INTERNAL_PAGE_SLOT_SIZE + lengths[i];
+  }
+
+  // The first key of the recipient moves up to the parent, neither page keeps it. Among the splits that leave both
+  // pages within their max size and bytes, the one closest to even is found first. Then the shortest key near it is
+  // taken instead, so that the parent gets a short key, as long as both pages keep two children to be valid.
+  std::vector<int> imbalance(num_items, -1);
+  int even = -1;
+  int left_bytes = INTERNAL_PAGE_SLOT_SIZE;
+  for (int split = 1; split < num_items; split++) {
+    int right_bytes = total_bytes - left_bytes - lengths[split];
+    bool fits = split <= GetMaxSize() && num_items - split <= recipient->GetMaxSize() &&
+                INTERNAL_PAGE_HEADER_SIZE + left_bytes <= page_size_ &&
+                INTERNAL_PAGE_HEADER_SIZE + right_bytes <= recipient->page_size_;
+    if (fits) {
+      imbalance[split] = std::abs(left_bytes - right_bytes);
+      if (even == -1 || imbalance[split] < imbalance[even]) {
+        even = split;
+      }
+    }
+    left_bytes += INTERNAL_PAGE_SLOT_SIZE + lengths[split];
+  }
+  BUSTUB_ENSURE(even > 0, "the children do not fit into two pages")
+  int keep = even;
+  int interval = INTERNAL_PAGE_SPLIT_INTERVAL(num_items);
+  for (int split = std::max(even - interval, 2); split <= std::min(even + interval, num_items - 2); split++) {
+    if (imbalance[split] != -1 && (lengths[split] < lengths[keep] ||
+                                   (lengths[split] == lengths[keep] && imbalance[split] < imbalance[keep]))) {
+      keep = split;
+    }
+  }
+  SetItems({items.begin(), items.begin() + keep});
+  recipient->SetItems({items.begin() + keep, items.end()});
+  return items[keep].first;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
+  BUSTUB_ENSURE(FitsInto(recipient, middle_key), "the children do not fit into recipient")
+  for (int i = 0; i < GetSize(); i++) {
+    recipient->Append(i == 0 ? middle_key : KeyAt(i), Slots()[i].value_);
+  }
+  SetSize(0);
+  key_bytes_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key)
+    -> KeyType {
+  recipient->Append(middle_key, Slots()[0].value_);
+  KeyType new_middle_key = KeyAt(1);
+  Remove(0);
+  return new_middle_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key)
+    -> KeyType {
+  auto items = recipient->GetItems();
+  items[0].first = middle_key;
+  items.insert(items.begin(), {KeyType{}, Slots()[GetSize() - 1].value_});
+  recipient->SetItems(items);
+  KeyType new_middle_key = KeyAt(GetSize() - 1);
+  Remove(GetSize() - 1);
+  return new_middle_key;
 }
 
 // valuetype for internalNode should be page id_t
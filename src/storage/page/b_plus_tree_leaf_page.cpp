@@ -9,10 +9,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "storage/page/b_plus_tree_key_search.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -26,11 +30,13 @@ namespace bustub {
  * Including set page type, set current size to zero, set next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(int max_size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(int max_size, int page_size) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
   SetMaxSize(max_size);
   SetNextPageId(INVALID_PAGE_ID);
+  page_size_ = page_size;
+  prefix_length_ = 0;
 }
 
 /**
@@ -49,8 +55,269 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_pa
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   BUSTUB_ENSURE(index < GetSize(), "index out of range")
-  BUSTUB_ENSURE(index > 0, "index out of range")
-  return array_[index].first;
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  return GetItem(index).first;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  BUSTUB_ENSURE(index < GetSize(), "index out of range")
+  BUSTUB_ENSURE(index >= 0, "index out of range")
+  return GetItem(index).second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index, int page_size) const -> MappingType {
+  MappingType item{};
+  int prefix_length = PrefixLength();
+  int width = SlotWidth(prefix_length);
+  if (index < 0 || UsedBytes(prefix_length, index + 1) > page_size) {
+    return item;
+  }
+  const char *slot = data_ + prefix_length + index * width;
+  auto key = reinterpret_cast<char *>(&item.first);
+  memcpy(key, data_, prefix_length);
+  memcpy(key + prefix_length, slot, sizeof(KeyType) - prefix_length);
+  memcpy(&item.second, slot + sizeof(KeyType) - prefix_length, sizeof(ValueType));
+  return item;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::PrefixLength() const -> int {
+  if constexpr (PREFIX_COMPRESSED) {
+    return std::clamp(prefix_length_, 0, static_cast<int>(sizeof(KeyType)));
+  } else {
+    return 0;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::SharedPrefixLength(const KeyType &key) const -> int {
+  auto bytes = reinterpret_cast<const char *>(&key);
+  int prefix_length = PrefixLength();
+  int shared = 0;
+  while (shared < prefix_length && bytes[shared] == data_[shared]) {
+    shared++;
+  }
+  return shared;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetUsedBytesWith(const KeyType &key) const -> int {
+  if (GetSize() == 0) {
+    return UsedBytes(PREFIX_COMPRESSED ? static_cast<int>(sizeof(KeyType)) : 0, 1);
+  }
+  return UsedBytes(SharedPrefixLength(key), GetSize() + 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::FitsInto(const BPlusTreeLeafPage *recipient) const -> bool {
+  int size = recipient->GetSize() + GetSize();
+  if (GetSize() == 0 || recipient->GetSize() == 0) {
+    auto page = GetSize() == 0 ? recipient : this;
+    return size <= recipient->GetMaxSize() && UsedBytes(page->PrefixLength(), size) <= recipient->page_size_;
+  }
+  int prefix_length = std::min(recipient->SharedPrefixLength(KeyAt(0)), PrefixLength());
+  return size <= recipient->GetMaxSize() && UsedBytes(prefix_length, size) <= recipient->page_size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::WriteItem(int index, const MappingType &item) {
+  char *slot = Slot(index);
+  memcpy(slot, reinterpret_cast<const char *>(&item.first) + prefix_length_, sizeof(KeyType) - prefix_length_);
+  memcpy(slot + sizeof(KeyType) - prefix_length_, &item.second, sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const MappingType &item) {
+  if (GetSize() == 0 || SharedPrefixLength(item.first) < prefix_length_) {
+    // The key shortens the prefix, which widens all slots.
+    auto items = GetItems();
+    items.insert(items.begin() + index, item);
+    SetItems(items.data(), static_cast<int>(items.size()));
+    return;
+  }
+  memmove(Slot(index + 1), Slot(index), (GetSize() - index) * SlotWidth(prefix_length_));
+  WriteItem(index, item);
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) {
+  // The prefix stays, the keys left still start with it.
+  memmove(Slot(index), Slot(index + 1), (GetSize() - index - 1) * SlotWidth(prefix_length_));
+  IncreaseSize(-1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItems() const -> std::vector<MappingType> {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.push_back(GetItem(i));
+  }
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetItems(const MappingType *items, int size) {
+  int prefix_length = 0;
+  if (PREFIX_COMPRESSED && size > 0) {
+    auto first = reinterpret_cast<const char *>(&items[0].first);
+    prefix_length = sizeof(KeyType);
+    for (int i = 1; i < size && prefix_length > 0; i++) {
+      auto key = reinterpret_cast<const char *>(&items[i].first);
+      prefix_length = std::mismatch(first, first + prefix_length, key).first - first;
+    }
+    memcpy(data_, first, prefix_length);
+  }
+  prefix_length_ = prefix_length;
+  SetSize(size);
+  for (int i = 0; i < size; i++) {
+    WriteItem(i, items[i]);
+  }
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator, int size,
+                                          int page_size) const -> int {
+  int prefix_length = PrefixLength();
+  int width = SlotWidth(prefix_length);
+  size = std::clamp(size, 0, std::max(0, (page_size - UsedBytes(prefix_length, 0)) / width));
+  if constexpr (!PREFIX_COMPRESSED) {
+    return SearchPairs(reinterpret_cast<const MappingType *>(data_), size, key, comparator, false);
+  } else {
+    // The slots are searched in a key that holds the prefix, their suffixes are copied in one at a time.
+    KeyType probe;
+    auto bytes = reinterpret_cast<char *>(&probe);
+    memcpy(bytes, data_, prefix_length);
+    int left = 0;
+    int right = size;
+    while (left < right) {
+      int mid = left + (right - left) / 2;
+      memcpy(bytes + prefix_length, data_ + prefix_length + mid * width, sizeof(KeyType) - prefix_length);
+      if (comparator(probe, key) < 0) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    return left;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const
+    -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize()) {
+    return false;
+  }
+  MappingType item = GetItem(index);
+  if (comparator(item.first, key) != 0) {
+    return false;
+  }
+  *value = item.second;
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION AND REMOVAL
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator)
+    -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(KeyAt(index), key) == 0) {
+    return false;
+  }
+  InsertAt(index, {key, value});
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  InsertAt(GetSize(), {key, value});
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Remove(const KeyType &key, const KeyComparator &comparator) -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return false;
+  }
+  RemoveAt(index);
+  return true;
+}
+
+/*****************************************************************************
+ * SPLIT AND MERGE
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAndSplitTo(const KeyType &key, const ValueType &value,
+                                                  const KeyComparator &comparator, BPlusTreeLeafPage *recipient,
+                                                  page_id_t recipient_page_id) {
+  // The full page has no room for the new pair, so the pairs are merged in a buffer and then split.
+  auto items = GetItems();
+  items.insert(items.begin() + KeyIndex(key, comparator), {key, value});
+  int size = static_cast<int>(items.size());
+  // The prefixes shared by the first i and by the last size - i pairs, for each split point i.
+  std::vector<int> lower(size + 1, 0);
+  std::vector<int> upper(size + 1, 0);
+  auto shared = [&items](int a, int b, int length) {
+    auto first = reinterpret_cast<const char *>(&items[a].first);
+    auto other = reinterpret_cast<const char *>(&items[b].first);
+    return static_cast<int>(std::mismatch(first, first + length, other).first - first);
+  };
+  if constexpr (PREFIX_COMPRESSED) {
+    lower[1] = upper[size - 1] = sizeof(KeyType);
+    for (int i = 2; i <= size; i++) {
+      lower[i] = shared(0, i - 1, lower[i - 1]);
+    }
+    for (int i = size - 2; i >= 0; i--) {
+      upper[i] = shared(size - 1, i, upper[i + 1]);
+    }
+  }
+  auto fits = [&](int keep) {
+    return keep >= 1 && keep < size && keep <= GetMaxSize() && size - keep <= recipient->GetMaxSize() &&
+           UsedBytes(lower[keep], keep) <= page_size_ &&
+           UsedBytes(upper[keep], size - keep) <= recipient->page_size_;
+  };
+  // The most even split that fits, the new key shortens the prefix only when it is one of the ends, so there is one.
+  int keep = (size + 1) / 2;
+  for (int offset = 0; !fits(keep); offset++) {
+    BUSTUB_ASSERT(offset <= 2 * size, "the pairs do not fit into two pages");
+    keep += offset % 2 == 0 ? offset + 1 : -(offset + 1);
+  }
+  SetItems(items.data(), keep);
+  recipient->SetItems(items.data() + keep, size - keep);
+  recipient->SetNextPageId(GetNextPageId());
+  SetNextPageId(recipient_page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  auto items = recipient->GetItems();
+  auto moved = GetItems();
+  items.insert(items.end(), moved.begin(), moved.end());
+  recipient->SetItems(items.data(), static_cast<int>(items.size()));
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertAt(recipient->GetSize(), GetItem(0));
+  RemoveAt(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertAt(0, GetItem(GetSize() - 1));
+  RemoveAt(GetSize() - 1);
 }
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
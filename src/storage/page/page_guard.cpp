@@ -1,4 +1,6 @@
 #include "storage/page/page_guard.h"
+
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace bustub {
@@ -48,7 +50,7 @@ auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &
   if (this == &that) {
     return *this;
   }
-  this->guard_.page_->RUnlatch();
+  this->Drop();
   this->guard_ = std::move(that.guard_);
   return *this;
 }
@@ -69,7 +71,7 @@ auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard
   if (this == &that) {
     return *this;
   }
-  this->guard_.page_->WUnlatch();
+  this->Drop();
   this->guard_ = std::move(that.guard_);
   return *this;
 }
@@ -84,4 +86,89 @@ void WritePageGuard::Drop() {
 
 WritePageGuard::~WritePageGuard() { this->Drop(); }  // NOLINT
 
+OptimisticPageGuard::OptimisticPageGuard(BufferPoolManager *bpm, Page *page)
+    : bpm_(bpm), page_(page), page_id_(page->GetPageId()), guard_(bpm, page), version_(page->GetVersion()) {}
+
+OptimisticPageGuard::OptimisticPageGuard(OptimisticPageGuard &&that) noexcept
+    : bpm_(that.bpm_),
+      page_(that.page_),
+      page_id_(that.page_id_),
+      guard_(std::move(that.guard_)),
+      version_(that.version_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+}
+
+auto OptimisticPageGuard::operator=(OptimisticPageGuard &&that) noexcept -> OptimisticPageGuard & {
+  if (this == &that) {
+    return *this;
+  }
+  this->Drop();
+  this->bpm_ = that.bpm_;
+  this->page_ = that.page_;
+  this->page_id_ = that.page_id_;
+  this->guard_ = std::move(that.guard_);
+  this->version_ = that.version_;
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  return *this;
+}
+
+void OptimisticPageGuard::Drop() {
+  guard_.Drop();
+  bpm_ = nullptr;
+  page_ = nullptr;
+}
+
+OptimisticPageGuard::~OptimisticPageGuard() { this->Drop(); }  // NOLINT
+
+auto OptimisticPageGuard::Pin() -> bool {
+  if (guard_.page_ != nullptr) {
+    return true;
+  }
+  // Once pinned, the page stays in its frame, so the version check of the upgrade also tells whether the frame still
+  // held the page when the version was taken.
+  Page *page = bpm_->FetchPage(page_id_);
+  if (page == nullptr) {
+    return false;
+  }
+  guard_ = BasicPageGuard(bpm_, page);
+  return page == page_;
+}
+
+auto OptimisticPageGuard::UpgradeRead() -> std::optional<ReadPageGuard> {
+  if (!Pin()) {
+    Drop();
+    return std::nullopt;
+  }
+  page_->RLatch();
+  if (page_->GetVersion() != version_) {
+    page_->RUnlatch();
+    Drop();
+    return std::nullopt;
+  }
+  ReadPageGuard read_guard;
+  read_guard.guard_ = std::move(guard_);
+  Drop();
+  return read_guard;
+}
+
+auto OptimisticPageGuard::UpgradeWrite() -> std::optional<WritePageGuard> {
+  if (!Pin()) {
+    Drop();
+    return std::nullopt;
+  }
+  page_->WLatch();
+  // Acquiring the latch made the version odd.
+  if (page_->GetVersion() != version_ + 1) {
+    page_->WUnlatch();
+    Drop();
+    return std::nullopt;
+  }
+  WritePageGuard write_guard;
+  write_guard.guard_ = std::move(guard_);
+  Drop();
+  return write_guard;
+}
+
 }  // namespace bustub
@@ -22,10 +22,11 @@
 
 namespace bustub {
 
-void TablePage::Init() {
+void TablePage::Init(size_t page_size) {
   next_page_id_ = INVALID_PAGE_ID;
   num_tuples_ = 0;
   num_deleted_tuples_ = 0;
+  page_size_ = page_size;
 }
 
 auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t> {
@@ -34,7 +35,7 @@ auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) co
     auto &[offset, size, meta] = tuple_info_[num_tuples_ - 1];
     slot_end_offset = offset;
   } else {
-    slot_end_offset = BUSTUB_PAGE_SIZE;
+    slot_end_offset = page_size_;
   }
   auto tuple_offset = slot_end_offset - tuple.GetLength();
   auto offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
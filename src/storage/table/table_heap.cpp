@@ -33,7 +33,7 @@ TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
   auto first_page = guard.AsMut<TablePage>();
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init();
+  first_page->Init(bpm_->GetPageSize());
 }
 
 auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
@@ -50,13 +50,13 @@ auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManag
     BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
 
     page_id_t next_page_id = INVALID_PAGE_ID;
-    auto npg = bpm_->NewPage(&next_page_id);
+    auto npg = bpm_->NewPage(&next_page_id, last_page_id_);
     BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
 
     page->SetNextPageId(next_page_id);
 
     auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
-    next_page->Init();
+    next_page->Init(bpm_->GetPageSize());
 
     page_guard.Drop();
 
@@ -91,8 +91,8 @@ void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
   page->UpdateTupleMeta(meta, rid);
 }
 
-auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
-  auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+auto TableHeap::GetTuple(RID rid, AccessType access_type) -> std::pair<TupleMeta, Tuple> {
+  auto page_guard = bpm_->FetchPageRead(rid.GetPageId(), access_type);
   auto page = page_guard.As<TablePage>();
   auto [meta, tuple] = page->GetTuple(rid);
   tuple.rid_ = rid;
@@ -110,7 +110,7 @@ auto TableHeap::MakeIterator() -> TableIterator {
   auto last_page_id = last_page_id_;
   guard.unlock();
 
-  auto page_guard = bpm_->FetchPageRead(last_page_id);
+  auto page_guard = bpm_->FetchPageRead(last_page_id, AccessType::Scan);
   auto page = page_guard.As<TablePage>();
   return {this, {first_page_id_, 0}, {last_page_id, page->GetNumTuples()}};
 }
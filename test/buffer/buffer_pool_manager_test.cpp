@@ -12,14 +12,49 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
+#include "buffer/read_ahead.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
+/** Fails the next reads it is told to fail, and all writes while told to, like a disk that returns I/O errors. */
+class FailingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+    if (failed_reads_.fetch_sub(1) > 0) {
+      throw Exception("injected read error");
+    }
+    failed_reads_ = 0;
+  }
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (fail_writes_) {
+      throw Exception("injected write error");
+    }
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  void FailReads(int count) { failed_reads_ = count; }
+  void FailWrites(bool fail) { fail_writes_ = fail; }
+
+ private:
+  std::atomic<int> failed_reads_{0};
+  std::atomic<bool> fail_writes_{false};
+};
+
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(BufferPoolManagerTest, BinaryDataTest) {
@@ -293,4 +328,710 @@ TEST(BufferPoolManagerTest, IntegratedTest) {
   delete disk_manager;
 }
 
+// test a buffer pool partitioned into several instances
+TEST(BufferPoolManagerTest, MultipleInstancesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 5;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, k, nullptr, num_instances);
+  EXPECT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Scenario: new pages are spread over all the instances until every frame is pinned.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ(page_ids.end(), std::unique(page_ids.begin(), page_ids.end()));
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: unpinning a page only frees a frame in the instance owning it.
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], true));
+  auto *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page_ids[0] % num_instances, page_id_temp % num_instances);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: pages written back by an instance can be fetched again.
+  for (auto page_id : page_ids) {
+    bpm->UnpinPage(page_id, true);
+  }
+  for (auto page_id : page_ids) {
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// test concurrent fetches while misses and write-backs are in flight
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_pages = 32;
+  const size_t num_threads = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+    page_ids.push_back(page_id_temp);
+  }
+  disk_manager->SetLatency(1);
+
+  // Scenario: every thread reads and rewrites pages, so that misses, dirty write-backs and fetches of pages being
+  // loaded or written back by another thread all interleave. Every fetched page must hold its own content.
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back([&, thread_id] {
+      for (size_t i = 0; i < 50; ++i) {
+        auto page_id = page_ids[(thread_id * 7 + i * 3) % num_pages];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        page->WLatch();
+        EXPECT_EQ(std::to_string(page_id), page->GetData());
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+        page->WUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  bpm->FlushAllPages();
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentHitTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_hot_pages = 8;
+  const size_t num_pages = 64;
+  const size_t num_threads = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: most fetches hit a few hot pages and are served without the latch, while the other fetches keep
+  // evicting the cold pages. No frame may be switched to another page while it is pinned.
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back([&, thread_id] {
+      for (size_t i = 0; i < 2000; ++i) {
+        size_t index = i % 8 == 0 ? (thread_id * 13 + i) % num_pages : (thread_id + i) % num_hot_pages;
+        auto page_id = page_ids[index];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        page->RLatch();
+        EXPECT_EQ(std::to_string(page_id), page->GetData());
+        page->RUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(0, bpm->GetStats().hits_);
+
+  // Scenario: every unpin reached the replacer, so all frames can be evicted for new pages again.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ConcurrentDirtyHitTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_hot_pages = 4;
+  const size_t num_pages = 32;
+  const size_t num_threads = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: pages are modified through fetches and unpins that do not take the latch, while fetches of the other
+  // pages keep evicting them. An eviction must never drop a modification, so every page ends up with as many
+  // increments as were made to it.
+  std::vector<std::atomic<uint32_t>> increments(num_pages);
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back([&, thread_id] {
+      for (size_t i = 0; i < 2000; ++i) {
+        size_t index = i % 4 == 0 ? (thread_id * 13 + i) % num_pages : (thread_id + i) % num_hot_pages;
+        auto page_id = page_ids[index];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        page->WLatch();
+        uint32_t counter;
+        memcpy(&counter, page->GetData(), sizeof(counter));
+        counter++;
+        memcpy(page->GetData(), &counter, sizeof(counter));
+        page->WUnlatch();
+        increments[index]++;
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    uint32_t counter;
+    memcpy(&counter, page->GetData(), sizeof(counter));
+    EXPECT_EQ(increments[i].load(), counter) << "page " << page_ids[i];
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+}
+
+// test a buffer pool on pages larger than the default page size
+TEST(BufferPoolManagerTest, PageSizeTest) {
+  const size_t buffer_pool_size = 3;
+  const size_t num_pages = 10;
+  const size_t page_size = BUSTUB_MAX_PAGE_SIZE;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>(page_size);
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+  EXPECT_EQ(page_size, bpm->GetPageSize());
+
+  // Scenario: the whole page, not only its first BUSTUB_PAGE_SIZE bytes, survives an eviction.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_size, page->GetPageSize());
+    memset(page->GetData(), static_cast<int>(page_id_temp), page_size);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+  for (auto page_id : page_ids) {
+    auto guard = bpm->FetchPageRead(page_id);
+    const char *data = guard.GetData();
+    EXPECT_EQ(static_cast<char>(page_id), data[0]);
+    EXPECT_EQ(static_cast<char>(page_id), data[BUSTUB_PAGE_SIZE]);
+    EXPECT_EQ(static_cast<char>(page_id), data[page_size - 1]);
+  }
+}
+
+// test the buffer pool with every replacement policy
+TEST(BufferPoolManagerTest, ReplacerTypesTest) {
+  const size_t buffer_pool_size = 5;
+  const size_t num_pages = 20;
+  const size_t k = 2;
+
+  for (auto replacer_type : {ReplacerType::LRUK, ReplacerType::LRU, ReplacerType::Clock, ReplacerType::ClockPro}) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 1, replacer_type);
+
+    std::vector<page_id_t> page_ids;
+    for (size_t i = 0; i < num_pages; ++i) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+      page_ids.push_back(page_id_temp);
+    }
+
+    // Scenario: pinned pages are never evicted while the other pages cycle through the remaining frames.
+    auto *pinned = bpm->FetchPage(page_ids[0]);
+    ASSERT_NE(nullptr, pinned);
+    for (size_t round = 0; round < 3; ++round) {
+      for (auto page_id : page_ids) {
+        auto *page = bpm->FetchPage(page_id, round % 2 == 0 ? AccessType::Get : AccessType::Scan);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(page_id), page->GetData());
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    }
+    EXPECT_EQ(1, pinned->GetPinCount());
+    EXPECT_EQ(page_ids[0], pinned->GetPageId());
+    EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  }
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const size_t buffer_pool_size = 2;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  page_id_t page_ids[3];
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  // Scenario: creating the third page evicted the dirty first page.
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_write_backs_);
+  EXPECT_EQ(1, stats.disk_writes_);
+  EXPECT_EQ(1, stats.replacer_evicts_);
+
+  bpm->ResetStats();
+  // Scenario: the third page is a hit, the first page is a miss and evicts the dirty second page.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[2]));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  ASSERT_EQ(true, bpm->UnpinPage(page_ids[2], false));
+  ASSERT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  ASSERT_EQ(true, bpm->FlushPage(page_ids[0]));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(1, stats.disk_reads_);
+  EXPECT_EQ(1, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_write_backs_);
+  EXPECT_EQ(2, stats.disk_writes_);
+  EXPECT_EQ(0, stats.pin_waits_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids(2 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  bpm->ResetStats();
+
+  // Scenario: the first pages were evicted and are read back, the cached page and the never allocated page are
+  // skipped.
+  std::vector<page_id_t> prefetch(page_ids.begin(), page_ids.begin() + 5);
+  prefetch.push_back(page_ids.back());
+  prefetch.push_back(1000);
+  EXPECT_EQ(5, bpm->PrefetchPages(prefetch));
+  for (size_t i = 0; i < 5; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(page->GetData()));
+    ASSERT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+  // A fetch that comes before the read of its prefetch completed shares the read.
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(5, stats.prefetches_);
+  EXPECT_EQ(5, stats.hits_ + stats.shared_reads_);
+  EXPECT_EQ(0, stats.misses_);
+  EXPECT_EQ(0, stats.dirty_write_backs_);
+
+  // Scenario: when every frame holds a dirty page, a prefetch does not write any of them back.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    ASSERT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  EXPECT_EQ(0, bpm->PrefetchPages({page_ids[buffer_pool_size], page_ids[buffer_pool_size + 1]}));
+  EXPECT_EQ(0, bpm->GetStats().dirty_write_backs_);
+}
+
+TEST(BufferPoolManagerTest, ReadAheadTest) {
+  const size_t buffer_pool_size = 40;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids(2 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  // The last pages are cached, the first ones are on disk only.
+  bpm->ResetStats();
+
+  // Scenario: random accesses do not trigger any read-ahead.
+  SequentialReadAhead random_scan(bpm.get());
+  for (auto page_id : {page_ids[12], page_ids[3], page_ids[20], page_ids[7]}) {
+    random_scan.Access(page_id);
+  }
+  EXPECT_EQ(0, bpm->GetStats().prefetches_);
+
+  // Scenario: a sequential scan keeps a window of a quarter of the pool in flight, topped up once half of it is used.
+  const size_t window = buffer_pool_size / 4;
+  SequentialReadAhead scan(bpm.get());
+  scan.Access(page_ids[0]);
+  scan.Access(page_ids[1]);
+  EXPECT_EQ(0, bpm->GetStats().prefetches_);
+  scan.Access(page_ids[2]);
+  EXPECT_EQ(window, bpm->GetStats().prefetches_);
+  for (size_t i = 3; i < 2 + window / 2; i++) {
+    scan.Access(page_ids[i]);
+  }
+  EXPECT_EQ(window, bpm->GetStats().prefetches_);
+  scan.Access(page_ids[2 + window / 2]);
+  EXPECT_EQ(window + window / 2, bpm->GetStats().prefetches_);
+}
+
+TEST(BufferPoolManagerTest, SwizzledFetchTest) {
+  const size_t buffer_pool_size = 3;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get());
+
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  std::vector<frame_id_t> frame_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_ids[i]);
+    frame_ids[i] = bpm->GetFrameId(page);
+    ASSERT_EQ(true, bpm->UnpinPage(page_ids[i], true));
+  }
+  bpm->ResetStats();
+
+  // Scenario: a swizzled reference reads the page from its frame without pinning it, the wrong frame is a miss.
+  auto guard = bpm->FetchPageSwizzled(page_ids[0], frame_ids[0]);
+  ASSERT_TRUE(guard.has_value());
+  EXPECT_EQ("page " + std::to_string(page_ids[0]), std::string(guard->GetData()));
+  EXPECT_TRUE(guard->Validate());
+  EXPECT_EQ(0, bpm->GetPages()[frame_ids[0]].GetPinCount());
+  EXPECT_FALSE(bpm->FetchPageSwizzled(page_ids[0], frame_ids[1]).has_value());
+  EXPECT_FALSE(bpm->FetchPageSwizzled(page_ids[0], static_cast<frame_id_t>(buffer_pool_size)).has_value());
+  EXPECT_FALSE(bpm->FetchPageSwizzled(page_ids[0], -1).has_value());
+  EXPECT_EQ(1, bpm->GetStats().swizzled_hits_);
+  EXPECT_EQ(0, bpm->GetStats().hits_);
+
+  // Scenario: the replacer would evict the least recently created page, but it was just read through its swizzled
+  // reference, so the next one is evicted instead.
+  page_id_t new_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+  ASSERT_EQ(true, bpm->UnpinPage(new_page_id, false));
+  EXPECT_TRUE(guard->Validate());
+  EXPECT_TRUE(bpm->FetchPageSwizzled(page_ids[0], frame_ids[0]).has_value());
+  EXPECT_FALSE(bpm->FetchPageSwizzled(page_ids[1], frame_ids[1]).has_value());
+
+  // Scenario: upgrading the guard pins the page.
+  auto read_guard = guard->UpgradeRead();
+  ASSERT_TRUE(read_guard.has_value());
+  EXPECT_EQ(1, bpm->GetPages()[frame_ids[0]].GetPinCount());
+  read_guard->Drop();
+  EXPECT_EQ(0, bpm->GetPages()[frame_ids[0]].GetPinCount());
+
+  // Scenario: once the frame is switched to another page, the guard does not validate and cannot be upgraded.
+  guard = bpm->FetchPageSwizzled(page_ids[2], frame_ids[2]);
+  ASSERT_TRUE(guard.has_value());
+  ASSERT_EQ(true, bpm->DeletePage(page_ids[2]));
+  EXPECT_FALSE(guard->Validate());
+  EXPECT_FALSE(bpm->FetchPageSwizzled(page_ids[2], frame_ids[2]).has_value());
+  EXPECT_FALSE(guard->UpgradeWrite().has_value());
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the background writer cleans every dirty frame without anybody evicting.
+  bpm->StartBackgroundWriter(1.0);
+  for (size_t i = 0; i < 500 && bpm->GetStats().background_writes_ < buffer_pool_size; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(buffer_pool_size, bpm->GetStats().background_writes_);
+
+  // Scenario: evicting the cleaned pages does not write anything on the critical path.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().dirty_write_backs_);
+
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), page->GetData());
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PageReuseTest) {
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, 1);
+
+  for (page_id_t i = 0; i < 20; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(i, page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: deleted page ids are reused before new ones, the lowest first, whether they were resident or not.
+  ASSERT_EQ(true, bpm->DeletePage(3));
+  ASSERT_EQ(true, bpm->DeletePage(15));
+  ASSERT_EQ(true, bpm->DeletePage(17));
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(3, page_id);
+  // A reused page starts zeroed, not with the content of the deleted page.
+  EXPECT_EQ(0, page->GetData()[0]);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: with a hint, the free page id closest to it is reused.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 18));
+  EXPECT_EQ(17, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 2));
+  EXPECT_EQ(15, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(20, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: the zeroed pages replace the deleted ones on disk once evicted.
+  for (page_id_t i = 21; i < 40; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t i : {3, 15, 17}) {
+    page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+    ASSERT_EQ(true, bpm->UnpinPage(i, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, TruncateFileTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 2;
+  remove(db_name.c_str());
+
+  auto disk_manager = std::make_unique<DiskManager>(db_name);
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, num_instances);
+  for (page_id_t i = 0; i < 30; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  auto file_size = std::filesystem::file_size(db_name);
+
+  // Scenario: the file is cut after the last allocated page, and only then.
+  ASSERT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(30, bpm->TruncateFile());
+  EXPECT_EQ(file_size, std::filesystem::file_size(db_name));
+  for (page_id_t i = 20; i < 30; ++i) {
+    ASSERT_EQ(true, bpm->DeletePage(i));
+  }
+  EXPECT_EQ(20, bpm->TruncateFile());
+  EXPECT_EQ(file_size - 10 * disk_manager->GetPageSize(), std::filesystem::file_size(db_name));
+
+  // Scenario: new pages go into the freed hole, then past the new end of the file.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 7));
+  EXPECT_EQ(5, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 19));
+  EXPECT_EQ(21, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  bpm->FlushAllPages();
+  bpm.reset();
+  disk_manager->ShutDown();
+
+  // Scenario: the allocated pages survive reopening the database, and the next page id follows them.
+  disk_manager = std::make_unique<DiskManager>(db_name);
+  bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, num_instances);
+  auto *page = bpm->FetchPage(19);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("19", page->GetData());
+  ASSERT_EQ(true, bpm->UnpinPage(19, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 18));
+  EXPECT_EQ(20, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id, 21));
+  EXPECT_EQ(23, page_id);
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  bpm.reset();
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FailedPrefetchTest) {
+  const size_t buffer_pool_size = 4;
+  auto disk_manager = std::make_unique<FailingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, 1);
+
+  std::vector<page_id_t> page_ids(2 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  bpm->ResetStats();
+
+  // Scenario: a fetch joins a prefetch whose read fails. It must not get the buffer of the failed read, but reads the
+  // page again itself.
+  disk_manager->SetLatency(50);
+  disk_manager->FailReads(1);
+  ASSERT_EQ(1, bpm->PrefetchPages({page_ids[0]}));
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page " + std::to_string(page_ids[0]), std::string(page->GetData()));
+  ASSERT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  EXPECT_EQ(1, bpm->GetStats().pin_waits_);
+  EXPECT_EQ(1, bpm->GetStats().shared_reads_);
+  EXPECT_EQ(0, bpm->GetStats().hits_);
+
+  // Scenario: the frame of the failed read was freed, so every frame can still hold a page.
+  disk_manager->SetLatency(0);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_EQ(true, bpm->UnpinPage(page_ids[i], false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DiskErrorTest) {
+  const size_t buffer_pool_size = 2;
+  auto disk_manager = std::make_unique<FailingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, 1);
+
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the dirty victim cannot be written back, so the fetch gets no frame and the victim keeps its changes.
+  disk_manager->FailWrites(true);
+  page_id_t other_page_id = 100;
+  EXPECT_EQ(nullptr, bpm->FetchPage(other_page_id));
+  EXPECT_EQ(nullptr, bpm->FetchPage(other_page_id));
+
+  // Scenario: a failed flush leaves the page dirty and unpinned.
+  EXPECT_EQ(false, bpm->FlushPage(page_ids[0]));
+  bpm->FlushAllPages();
+
+  // Scenario: the background writer survives the failed writes.
+  bpm->StartBackgroundWriter(1.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(0, bpm->GetStats().background_writes_);
+
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_TRUE(page->IsDirty());
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: once the disk works again, the pages are written back and the frames are handed out.
+  disk_manager->FailWrites(false);
+  EXPECT_EQ(true, bpm->FlushPage(page_ids[0]));
+  for (page_id_t page_id : {other_page_id, other_page_id + 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a failed read gives up the frame, and neither a retry nor a later fetch waits for the failed read.
+  disk_manager->FailReads(3);
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_THROW(bpm->FetchPageRead(page_ids[0]), Exception);
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page " + std::to_string(page_ids[0]), std::string(page->GetData()));
+  ASSERT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: both frames are usable again.
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  for (auto page_id : page_ids) {
+    ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+}
+
 }  // namespace bustub
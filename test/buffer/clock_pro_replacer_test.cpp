@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer_test.cpp
+//
+// Identification: test/buffer/clock_pro_replacer_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/clock_pro_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ClockProReplacerTest, SampleTest) {
+  ClockProReplacer clock_pro_replacer(8);
+
+  // Scenario: frames 0-3 are read by regular accesses, frames 4-7 only by a scan.
+  for (frame_id_t fid = 0; fid < 8; ++fid) {
+    clock_pro_replacer.RecordAccess(fid, fid < 4 ? AccessType::Get : AccessType::Scan);
+    clock_pro_replacer.SetEvictable(fid, true);
+  }
+  EXPECT_EQ(8, clock_pro_replacer.Size());
+
+  // Scenario: untracked frames and pinned frames are never victims.
+  clock_pro_replacer.SetEvictable(6, false);
+  EXPECT_EQ(7, clock_pro_replacer.Size());
+
+  // Scenario: the referenced frames are promoted to hot, so the scanned frames go first.
+  int value;
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(4, value);
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(7, value);
+  EXPECT_EQ(4, clock_pro_replacer.Size());
+
+  // Scenario: only hot frames are left, they are demoted and evicted in clock order.
+  clock_pro_replacer.Remove(2);
+  EXPECT_EQ(3, clock_pro_replacer.Size());
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(0, clock_pro_replacer.Size());
+  EXPECT_EQ(false, clock_pro_replacer.Evict(&value));
+
+  // Scenario: the pinned frame becomes a victim once it is unpinned.
+  clock_pro_replacer.SetEvictable(6, true);
+  ASSERT_EQ(true, clock_pro_replacer.Evict(&value));
+  EXPECT_EQ(6, value);
+}
+
+TEST(ClockProReplacerTest, ConcurrentAccessTest) {
+  const size_t num_frames = 64;
+  ClockProReplacer clock_pro_replacer(num_frames);
+  for (frame_id_t fid = 0; fid < static_cast<frame_id_t>(num_frames); ++fid) {
+    clock_pro_replacer.RecordAccess(fid);
+    clock_pro_replacer.SetEvictable(fid, true);
+  }
+
+  // Scenario: accesses from many threads race with the hands without any latch.
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+    threads.emplace_back([&, thread_id] {
+      for (size_t i = 0; i < 1000; ++i) {
+        clock_pro_replacer.RecordAccess(static_cast<frame_id_t>((thread_id * 17 + i) % num_frames));
+      }
+    });
+  }
+  threads.emplace_back([&] {
+    for (size_t i = 0; i < 16; ++i) {
+      int value;
+      EXPECT_EQ(true, clock_pro_replacer.Evict(&value));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames - 16, clock_pro_replacer.Size());
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -19,44 +20,81 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
-  // Scenario: unpin six elements, i.e. add them to the replacer.
-  clock_replacer.Unpin(1);
-  clock_replacer.Unpin(2);
-  clock_replacer.Unpin(3);
-  clock_replacer.Unpin(4);
-  clock_replacer.Unpin(5);
-  clock_replacer.Unpin(6);
-  clock_replacer.Unpin(1);
+  // Scenario: access and unpin six elements, i.e. add them to the replacer.
+  for (frame_id_t fid = 1; fid <= 6; ++fid) {
+    clock_replacer.RecordAccess(fid);
+    clock_replacer.SetEvictable(fid, true);
+  }
+  clock_replacer.SetEvictable(1, true);
   EXPECT_EQ(6, clock_replacer.Size());
 
   // Scenario: get three victims from the clock.
   int value;
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(1, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(2, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(3, value);
 
   // Scenario: pin elements in the replacer.
   // Note that 3 has already been victimized, so pinning 3 should have no effect.
-  clock_replacer.Pin(3);
-  clock_replacer.Pin(4);
+  clock_replacer.SetEvictable(3, false);
+  clock_replacer.SetEvictable(4, false);
   EXPECT_EQ(2, clock_replacer.Size());
 
-  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
-  clock_replacer.Unpin(4);
+  // Scenario: access and unpin 4. We expect that the reference bit of 4 will be set to 1.
+  clock_replacer.RecordAccess(4);
+  clock_replacer.SetEvictable(4, true);
 
   // Scenario: continue looking for victims. We expect these victims.
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(5, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(6, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(4, value);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_EQ(false, clock_replacer.Evict(&value));
+}
+
+TEST(ClockReplacerTest, ConcurrentEvictTest) {
+  const size_t num_frames = 64;
+  const size_t num_rounds = 200;
+
+  for (size_t round = 0; round < num_rounds; ++round) {
+    ClockReplacer clock_replacer(num_frames);
+    for (frame_id_t fid = 0; fid < static_cast<frame_id_t>(num_frames); ++fid) {
+      clock_replacer.RecordAccess(fid, AccessType::Scan);
+      clock_replacer.SetEvictable(fid, true);
+    }
+
+    // Scenario: a frame that is being evicted is not tracked anymore, so unpins racing with the eviction must not make
+    // it evictable again and hand it out twice.
+    std::atomic<bool> done{false};
+    std::thread unpinner([&] {
+      while (!done) {
+        for (frame_id_t fid = 0; fid < static_cast<frame_id_t>(num_frames); ++fid) {
+          clock_replacer.SetEvictable(fid, true);
+        }
+      }
+    });
+    std::vector<bool> evicted(num_frames, false);
+    frame_id_t fid;
+    size_t num_evicted = 0;
+    while (clock_replacer.Evict(&fid)) {
+      EXPECT_FALSE(evicted[fid]);
+      evicted[fid] = true;
+      ++num_evicted;
+    }
+    done = true;
+    unpinner.join();
+    EXPECT_EQ(num_frames, num_evicted);
+    EXPECT_EQ(0, clock_replacer.Size());
+  }
 }
 
 }  // namespace bustub
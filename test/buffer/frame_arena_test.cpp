@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, LayoutTest) {
+  const size_t num_frames = 100;
+  for (size_t page_size : {static_cast<size_t>(BUSTUB_PAGE_SIZE), static_cast<size_t>(BUSTUB_MAX_PAGE_SIZE)}) {
+    for (bool huge_pages : {false, true}) {
+      FrameArena arena(num_frames, page_size, {huge_pages});
+      EXPECT_EQ(num_frames, arena.GetNumFrames());
+      EXPECT_EQ(page_size, arena.GetPageSize());
+      for (size_t i = 0; i < num_frames; i++) {
+        // Scenario: every frame is aligned for O_DIRECT, starts zeroed, and does not overlap the next one.
+        char *data = arena.FrameData(i);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_ALIGNMENT);
+        EXPECT_EQ(0, data[0]);
+        EXPECT_EQ(0, data[page_size - 1]);
+        if (i + 1 < num_frames) {
+          EXPECT_GE(arena.FrameData(i + 1), data + page_size);
+        }
+        memset(data, static_cast<int>(i), page_size);
+      }
+      for (size_t i = 0; i < num_frames; i++) {
+        EXPECT_EQ(static_cast<char>(i), arena.FrameData(i)[page_size - 1]);
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, NumaPolicyTest) {
+  // Scenario: a policy the kernel refuses falls back to the default placement. Whether the others are applied depends
+  // on the machine, but the arena is usable either way.
+  FrameArena invalid_node(10, BUSTUB_PAGE_SIZE, {false, NumaPolicy::Bind, 1 << 20});
+  EXPECT_EQ(NumaPolicy::Default, invalid_node.GetNumaPolicy());
+
+  for (auto policy : {NumaPolicy::Interleave, NumaPolicy::Bind}) {
+    FrameArena arena(10, BUSTUB_PAGE_SIZE, {false, policy, 0});
+    EXPECT_TRUE(arena.GetNumaPolicy() == policy || arena.GetNumaPolicy() == NumaPolicy::Default);
+    memset(arena.FrameData(9), 1, BUSTUB_PAGE_SIZE);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2, nullptr, 2,
+                                                 ReplacerType::LRUK, FrameArenaOptions{true, NumaPolicy::Interleave});
+
+  // Scenario: the frames hold their data in the arena, and their metadata in separate cache lines.
+  auto &arena = bpm->GetFrameArena();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(arena.FrameData(i), bpm->GetPages()[i].GetData());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages() + i) % 64);
+  }
+
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, true));
+  ASSERT_EQ(true, bpm->FlushPage(page_id));
+  ASSERT_EQ(true, bpm->DeletePage(page_id));
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+  ASSERT_EQ(true, bpm->UnpinPage(page_id, false));
+}
+
+}  // namespace bustub
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/buffer/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_space_map.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, AllocateTest) {
+  FreeSpaceMap map(BUSTUB_PAGE_SIZE);
+  auto pages_per_group = static_cast<page_id_t>(map.PagesPerGroup());
+  EXPECT_EQ(0, map.GetEnd());
+  EXPECT_FALSE(map.IsAllocated(0));
+
+  // Scenario: setting a bit reports the change once, and the end follows the largest allocated page.
+  EXPECT_TRUE(map.SetAllocated(3, true));
+  EXPECT_FALSE(map.SetAllocated(3, true));
+  EXPECT_TRUE(map.IsAllocated(3));
+  EXPECT_EQ(4, map.GetEnd());
+  EXPECT_TRUE(map.SetAllocated(2 * pages_per_group + 64, true));
+  EXPECT_EQ(2 * pages_per_group + 65, map.GetEnd());
+  EXPECT_FALSE(map.IsAllocated(pages_per_group));
+
+  // Scenario: freeing the last page moves the end back to the page before.
+  EXPECT_TRUE(map.SetAllocated(2 * pages_per_group + 64, false));
+  EXPECT_FALSE(map.SetAllocated(2 * pages_per_group + 64, false));
+  EXPECT_EQ(4, map.GetEnd());
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, ConcurrentAllocateTest) {
+  const int num_threads = 4;
+  FreeSpaceMap map(BUSTUB_PAGE_SIZE);
+  auto num_pages = static_cast<page_id_t>(3 * map.PagesPerGroup());
+
+  // Scenario: threads setting interleaved pages, which share bitmap words and add groups as they go, lose no bit.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&map, num_pages, t] {
+      for (page_id_t page_id = t; page_id < num_pages; page_id += num_threads) {
+        EXPECT_TRUE(map.SetAllocated(page_id, true));
+      }
+      for (page_id_t page_id = t; page_id < num_pages; page_id += 2 * num_threads) {
+        EXPECT_TRUE(map.SetAllocated(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    EXPECT_EQ(page_id % (2 * num_threads) >= num_threads, map.IsAllocated(page_id));
+  }
+  EXPECT_EQ(num_pages, map.GetEnd());
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, PersistTest) {
+  const std::string db_name = "fsm_test.db";
+  remove(db_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_name);
+  page_id_t pages_per_group;
+  {
+    FreeSpaceMap map(disk_manager->GetPageSize());
+    pages_per_group = static_cast<page_id_t>(map.PagesPerGroup());
+    map.SetAllocated(0, true);
+    map.SetAllocated(7, true);
+    map.SetAllocated(2 * pages_per_group + 1, true);
+    map.Flush(disk_manager.get());
+  }
+
+  // Scenario: a reloaded map has the same pages allocated, including the ones in later groups.
+  FreeSpaceMap map(disk_manager->GetPageSize());
+  map.Load(disk_manager.get());
+  EXPECT_TRUE(map.IsAllocated(0));
+  EXPECT_TRUE(map.IsAllocated(7));
+  EXPECT_FALSE(map.IsAllocated(8));
+  EXPECT_TRUE(map.IsAllocated(2 * pages_per_group + 1));
+  EXPECT_EQ(2 * pages_per_group + 2, map.GetEnd());
+
+  // Scenario: truncated groups are gone after a flush, so that they do not come back on the next load.
+  map.SetAllocated(2 * pages_per_group + 1, false);
+  map.Truncate(map.GetEnd());
+  map.Flush(disk_manager.get());
+  FreeSpaceMap reloaded(disk_manager->GetPageSize());
+  reloaded.Load(disk_manager.get());
+  EXPECT_EQ(8, reloaded.GetEnd());
+  EXPECT_FALSE(reloaded.IsAllocated(2 * pages_per_group + 1));
+
+  // Scenario: the map can grow again after it was truncated.
+  reloaded.SetAllocated(pages_per_group, true);
+  reloaded.Flush(disk_manager.get());
+  map.Load(disk_manager.get());
+  EXPECT_EQ(pages_per_group + 1, map.GetEnd());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("fsm_test.fsm");
+}
+
+}  // namespace bustub
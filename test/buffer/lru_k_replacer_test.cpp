@@ -152,4 +152,106 @@ TEST(LRUKReplacerTest, EvitTest2) {
 
   ASSERT_EQ(3, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: frames 1 and 2 are hot, frames 3 and 4 have only been touched by scans.
+  lru_replacer.RecordAccess(1, AccessType::Get);
+  lru_replacer.RecordAccess(2, AccessType::Get);
+  lru_replacer.RecordAccess(1, AccessType::Get);
+  lru_replacer.RecordAccess(2, AccessType::Get);
+  lru_replacer.RecordAccess(3, AccessType::Scan);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(3, AccessType::Scan);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(5, AccessType::Get);
+  for (frame_id_t fid = 1; fid <= 5; ++fid) {
+    lru_replacer.SetEvictable(fid, true);
+  }
+  ASSERT_EQ(5, lru_replacer.Size());
+
+  // Scenario: a scan touching a hot frame does not change its history.
+  lru_replacer.RecordAccess(1, AccessType::Scan);
+
+  // Scenario: a regular access to a scanned frame promotes it with a fresh history, so frame 4 now has +inf backward
+  // k-distance and an access after frame 5.
+  lru_replacer.RecordAccess(4, AccessType::Get);
+
+  // Scan-only frames are evicted first, then +inf frames in LRU order, then by backward k-distance.
+  int value;
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(4, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+TEST(LRUKReplacerTest, EvictionCandidatesTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: frame 1 has two accesses, frames 2 and 3 one, frame 4 was only scanned and frame 5 is pinned.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(5);
+  for (frame_id_t fid = 1; fid <= 4; ++fid) {
+    lru_replacer.SetEvictable(fid, true);
+  }
+
+  // Scenario: the candidates come in eviction order and nothing is evicted.
+  EXPECT_EQ((std::vector<frame_id_t>{4, 2, 3, 1}), lru_replacer.EvictionCandidates(10));
+  EXPECT_EQ((std::vector<frame_id_t>{4, 2}), lru_replacer.EvictionCandidates(2));
+  EXPECT_EQ(4, lru_replacer.Size());
+
+  // Scenario: pinning and unpinning a frame does not change its place.
+  lru_replacer.SetEvictable(2, false);
+  EXPECT_EQ((std::vector<frame_id_t>{4, 3, 1}), lru_replacer.EvictionCandidates(10));
+  lru_replacer.SetEvictable(2, true);
+  EXPECT_EQ((std::vector<frame_id_t>{4, 2, 3, 1}), lru_replacer.EvictionCandidates(10));
+
+  int value;
+  for (frame_id_t expected : {4, 2, 3, 1}) {
+    ASSERT_EQ(true, lru_replacer.Evict(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: frame 1 is a regular frame, frames 2 and 3 were read ahead of a scan, and the scan is done with frame 4.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2, AccessType::Prefetch);
+  lru_replacer.RecordAccess(3, AccessType::Prefetch);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  for (frame_id_t fid = 1; fid <= 4; ++fid) {
+    lru_replacer.SetEvictable(fid, true);
+  }
+  // Scenario: the frames read ahead outlive the older scanned frame, but not the regular one.
+  EXPECT_EQ((std::vector<frame_id_t>{4, 2, 3, 1}), lru_replacer.EvictionCandidates(10));
+
+  // Scenario: once the scan reaches frame 2, it is an ordinary scanned frame and goes before frame 3.
+  lru_replacer.RecordAccess(2, AccessType::Scan);
+  EXPECT_EQ((std::vector<frame_id_t>{4, 2, 3, 1}), lru_replacer.EvictionCandidates(10));
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  EXPECT_EQ((std::vector<frame_id_t>{2, 4, 3, 1}), lru_replacer.EvictionCandidates(10));
+
+  // Scenario: a regular access to a frame read ahead promotes it.
+  lru_replacer.RecordAccess(3);
+  int value;
+  for (frame_id_t expected : {2, 4, 1, 3}) {
+    ASSERT_EQ(true, lru_replacer.Evict(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
 }  // namespace bustub
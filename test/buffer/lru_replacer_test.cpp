@@ -19,44 +19,45 @@
 
 namespace bustub {
 
-TEST(LRUReplacerTest, DISABLED_SampleTest) {
+TEST(LRUReplacerTest, SampleTest) {
   LRUReplacer lru_replacer(7);
 
-  // Scenario: unpin six elements, i.e. add them to the replacer.
-  lru_replacer.Unpin(1);
-  lru_replacer.Unpin(2);
-  lru_replacer.Unpin(3);
-  lru_replacer.Unpin(4);
-  lru_replacer.Unpin(5);
-  lru_replacer.Unpin(6);
-  lru_replacer.Unpin(1);
+  // Scenario: access and unpin six elements, i.e. add them to the replacer.
+  for (frame_id_t fid = 1; fid <= 6; ++fid) {
+    lru_replacer.RecordAccess(fid);
+    lru_replacer.SetEvictable(fid, true);
+  }
+  lru_replacer.SetEvictable(1, true);
   EXPECT_EQ(6, lru_replacer.Size());
 
   // Scenario: get three victims from the lru.
   int value;
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(1, value);
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(2, value);
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(3, value);
 
   // Scenario: pin elements in the replacer.
   // Note that 3 has already been victimized, so pinning 3 should have no effect.
-  lru_replacer.Pin(3);
-  lru_replacer.Pin(4);
+  lru_replacer.SetEvictable(3, false);
+  lru_replacer.SetEvictable(4, false);
   EXPECT_EQ(2, lru_replacer.Size());
 
-  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
-  lru_replacer.Unpin(4);
+  // Scenario: access and unpin 4. We expect that the reference bit of 4 will be set to 1.
+  lru_replacer.RecordAccess(4);
+  lru_replacer.SetEvictable(4, true);
 
   // Scenario: continue looking for victims. We expect these victims.
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(5, value);
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(6, value);
-  lru_replacer.Victim(&value);
+  lru_replacer.Evict(&value);
   EXPECT_EQ(4, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_EQ(false, lru_replacer.Evict(&value));
 }
 
 }  // namespace bustub
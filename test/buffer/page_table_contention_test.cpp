@@ -0,0 +1,102 @@
+/**
+ * page_table_contention_test.cpp
+ */
+
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/**
+ * Run num_threads threads that look up lookups_per_thread resident pages each, while one more thread keeps replacing
+ * a small fraction of the pages, like a buffer pool with a high hit ratio.
+ * @return the elapsed time in milliseconds
+ */
+template <typename Lookup, typename Replace>
+auto PageTableBenchmarkCall(size_t num_threads, size_t lookups_per_thread, Lookup &&lookup, Replace &&replace)
+    -> size_t {
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> hits{0};
+  auto clock_start = std::chrono::steady_clock::now();
+  std::thread writer([&] {
+    for (size_t round = 0; !stop; ++round) {
+      replace(round);
+      std::this_thread::yield();
+    }
+  });
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      size_t local_hits = 0;
+      for (size_t j = 0; j < lookups_per_thread; ++j) {
+        local_hits += lookup(static_cast<page_id_t>((i * 7919 + j * 31) % 1024)) ? 1 : 0;
+      }
+      hits += local_hits;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  stop = true;
+  writer.join();
+  EXPECT_LT(0, hits.load());
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+}
+
+TEST(PageTableContentionTest, PageTableContentionBenchmark) {  // NOLINT
+  std::cout << "This test compares lookups in the lock-free page table of the buffer pool to lookups in an "
+               "std::unordered_map guarded by a latch, as the buffer pool used to do."
+            << std::endl;
+  const size_t num_frames = 1024;
+  const size_t lookups_per_thread = 200000;
+
+  PageTable table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> map;
+  std::mutex latch;
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_frames); ++page_id) {
+    table.Insert(page_id, page_id);
+    map[page_id] = page_id;
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8}) {
+    // Every round of the writer evicts one page and loads it again, the writer holds the latch for both tables.
+    size_t table_ms = PageTableBenchmarkCall(
+        num_threads, lookups_per_thread,
+        [&](page_id_t page_id) {
+          frame_id_t frame_id;
+          return table.Find(page_id, &frame_id);
+        },
+        [&](size_t round) {
+          std::scoped_lock lock(latch);
+          auto page_id = static_cast<page_id_t>(round % num_frames);
+          table.Erase(page_id);
+          table.Insert(page_id, page_id);
+        });
+    size_t map_ms = PageTableBenchmarkCall(
+        num_threads, lookups_per_thread,
+        [&](page_id_t page_id) {
+          std::scoped_lock lock(latch);
+          return map.find(page_id) != map.end();
+        },
+        [&](size_t round) {
+          std::scoped_lock lock(latch);
+          auto page_id = static_cast<page_id_t>(round % num_frames);
+          map.erase(page_id);
+          map[page_id] = page_id;
+        });
+    std::cout << "threads=" << num_threads << " PageTable: " << table_ms << " ms, latched unordered_map: " << map_ms
+              << " ms" << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
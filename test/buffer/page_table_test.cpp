@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  PageTable table(10);
+  EXPECT_EQ(0, table.Size());
+  EXPECT_LE(20, table.Capacity());
+
+  frame_id_t frame_id;
+  EXPECT_FALSE(table.Find(1, &frame_id));
+  table.Insert(1, 5);
+  table.Insert(2, 6);
+  ASSERT_TRUE(table.Find(1, &frame_id));
+  EXPECT_EQ(5, frame_id);
+  ASSERT_TRUE(table.Find(2, &frame_id));
+  EXPECT_EQ(6, frame_id);
+
+  // Scenario: inserting a mapped page replaces its frame.
+  table.Insert(1, 7);
+  EXPECT_EQ(2, table.Size());
+  ASSERT_TRUE(table.Find(1, &frame_id));
+  EXPECT_EQ(7, frame_id);
+
+  EXPECT_TRUE(table.Erase(1));
+  EXPECT_FALSE(table.Erase(1));
+  EXPECT_FALSE(table.Find(1, &frame_id));
+  EXPECT_EQ(1, table.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ChurnTest) {
+  // Scenario: a buffer pool replacing pages over and over. Erasing shifts entries back, so every mapped page must
+  // still be found afterwards, and no unmapped one.
+  const size_t num_frames = 64;
+  PageTable table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 gen(42);
+  page_id_t next_page_id = 0;
+  for (size_t i = 0; i < 100000; ++i) {
+    if (expected.size() == num_frames || (!expected.empty() && gen() % 2 == 0)) {
+      auto it = expected.begin();
+      std::advance(it, gen() % expected.size());
+      EXPECT_TRUE(table.Erase(it->first));
+      expected.erase(it);
+    } else {
+      // Page ids are spread like the ones of one of several buffer pool instances.
+      page_id_t page_id = next_page_id;
+      next_page_id += 1 + static_cast<page_id_t>(gen() % 4);
+      table.Insert(page_id, static_cast<frame_id_t>(i % num_frames));
+      expected[page_id] = static_cast<frame_id_t>(i % num_frames);
+    }
+  }
+  EXPECT_EQ(expected.size(), table.Size());
+  for (page_id_t page_id = 0; page_id < next_page_id; ++page_id) {
+    frame_id_t frame_id;
+    auto it = expected.find(page_id);
+    ASSERT_EQ(it != expected.end(), table.Find(page_id, &frame_id));
+    if (it != expected.end()) {
+      EXPECT_EQ(it->second, frame_id);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ConcurrentFindTest) {
+  // Scenario: readers look up pages while a writer keeps mapping and unmapping others. A lookup may miss a page that is
+  // being moved back by an erase, but every hit must be a frame the page was mapped to.
+  const size_t num_frames = 128;
+  PageTable table(num_frames);
+  for (page_id_t page_id = 0; page_id < 64; ++page_id) {
+    table.Insert(page_id, page_id);
+  }
+
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (size_t round = 0; round < 2000; ++round) {
+      for (page_id_t page_id = 64; page_id < 128; ++page_id) {
+        table.Insert(page_id + static_cast<page_id_t>(round % 2) * 64, page_id);
+      }
+      for (page_id_t page_id = 64; page_id < 128; ++page_id) {
+        table.Erase(page_id + static_cast<page_id_t>(round % 2) * 64);
+      }
+    }
+    stop = true;
+  });
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop) {
+        for (page_id_t page_id = 0; page_id < 192; ++page_id) {
+          frame_id_t frame_id;
+          bool found = table.Find(page_id, &frame_id);
+          if (found) {
+            EXPECT_EQ(page_id < 128 ? page_id : page_id - 64, frame_id);
+          }
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(64, table.Size());
+}
+
+}  // namespace bustub
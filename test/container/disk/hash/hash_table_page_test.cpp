@@ -51,8 +51,8 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
   bpm->UnpinPage(directory_page_id, true);
   disk_manager->ShutDown();
   remove("test.db");
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
 }
 
 // NOLINTNEXTLINE
@@ -109,8 +109,8 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   bpm->UnpinPage(bucket_page_id, true);
   disk_manager->ShutDown();
   remove("test.db");
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
 }
 
 }  // namespace bustub
@@ -113,8 +113,8 @@ TEST(HashTableTest, DISABLED_SampleTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
-  delete disk_manager;
   delete bpm;
+  delete disk_manager;
 }
 
 }  // namespace bustub
@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_batch_test.cpp
+//
+// Identification: test/storage/b_plus_tree_batch_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** @brief The pairs of keys, with the key as the slot of the rid. */
+static auto MakePairs(const std::vector<int64_t> &keys) -> std::vector<std::pair<GenericKey<8>, RID>> {
+  std::vector<std::pair<GenericKey<8>, RID>> pairs(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    pairs[i].first.SetFromInteger(keys[i]);
+    pairs[i].second.Set(0, static_cast<uint32_t>(keys[i]));
+  }
+  return pairs;
+}
+
+static auto MakeKeys(const std::vector<int64_t> &keys) -> std::vector<GenericKey<8>> {
+  std::vector<GenericKey<8>> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromInteger(keys[i]);
+  }
+  return index_keys;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, InsertBatchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+
+  for (int leaf_max_size : {2, 3, 16}) {
+    page_id_t header_page_id;
+    bpm->NewPageGuarded(&header_page_id).Drop();
+    Tree tree("foo_pk", header_page_id, bpm.get(), comparator, leaf_max_size, 3);
+
+    // Scenario: a batch into an empty tree, in random order and with duplicate keys, inserts every key once.
+    std::vector<int64_t> keys;
+    for (int64_t key = 0; key < 1000; key += 2) {
+      keys.push_back(key);
+    }
+    keys.push_back(10);
+    keys.push_back(500);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(leaf_max_size));
+    EXPECT_EQ(500, tree.InsertBatch(MakePairs(keys)));
+
+    // Scenario: a second batch interleaves with the keys in the tree, and skips the ones already there.
+    keys.clear();
+    for (int64_t key = 1; key < 1200; key += 2) {
+      keys.push_back(key);
+    }
+    keys.push_back(4);
+    keys.push_back(998);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(leaf_max_size + 1));
+    EXPECT_EQ(600, tree.InsertBatch(MakePairs(keys)));
+
+    int64_t expected = 0;
+    for (auto it = tree.Begin(); it != tree.End(); ++it) {
+      ASSERT_EQ(expected, (*it).first.ToString());
+      expected += expected < 999 ? 1 : 2;
+    }
+    EXPECT_EQ(1201, expected);
+    EXPECT_EQ(0, tree.InsertBatch({}));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, GetValueBatchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 3, 3);
+
+  // Scenario: every key of an empty tree is missing.
+  std::vector<std::optional<RID>> result;
+  EXPECT_EQ(0, tree.GetValueBatch(MakeKeys({1, 2}), &result));
+  EXPECT_EQ(std::vector<std::optional<RID>>(2), result);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 300; key += 3) {
+    keys.push_back(key);
+  }
+  tree.InsertBatch(MakePairs(keys));
+
+  // Scenario: results come back in the order of the keys, with gaps for the missing ones and every duplicate served.
+  std::vector<int64_t> lookups;
+  for (int64_t key = 400; key-- > -5;) {
+    lookups.push_back(key);
+  }
+  lookups.push_back(42);
+  EXPECT_EQ(101, tree.GetValueBatch(MakeKeys(lookups), &result));
+  ASSERT_EQ(lookups.size(), result.size());
+  for (size_t i = 0; i < lookups.size(); i++) {
+    if (lookups[i] >= 0 && lookups[i] < 300 && lookups[i] % 3 == 0) {
+      ASSERT_TRUE(result[i].has_value());
+      EXPECT_EQ(lookups[i], result[i]->GetSlotNum());
+    } else {
+      EXPECT_FALSE(result[i].has_value());
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, ConcurrentInsertBatchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 4, 4);
+
+  // Scenario: batches of interleaved keys split and fill the same leaves from several threads.
+  const int64_t num_threads = 4;
+  const int64_t keys_per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&tree, t] {
+      for (int64_t batch = 0; batch < 10; batch++) {
+        std::vector<int64_t> keys;
+        for (int64_t i = batch; i < keys_per_thread; i += 10) {
+          keys.push_back(i * num_threads + t);
+        }
+        EXPECT_EQ(keys.size(), tree.InsertBatch(MakePairs(keys)));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<int64_t> keys(num_threads * keys_per_thread);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int64_t>(i);
+  }
+  std::vector<std::optional<RID>> result;
+  EXPECT_EQ(keys.size(), tree.GetValueBatch(MakeKeys(keys), &result));
+}
+
+}  // namespace bustub
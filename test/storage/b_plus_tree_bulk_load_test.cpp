@@ -0,0 +1,209 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** @brief Bulk load the keys in order, with the key as the slot of the rid. */
+static auto BulkLoadKeys(Tree *tree, const std::vector<int64_t> &keys, double fill_factor) -> bool {
+  size_t next = 0;
+  return tree->BulkLoad(
+      [&](GenericKey<8> *key, RID *rid) {
+        if (next == keys.size()) {
+          return false;
+        }
+        key->SetFromInteger(keys[next]);
+        rid->Set(static_cast<int32_t>(keys[next] >> 32), static_cast<uint32_t>(keys[next]));
+        next++;
+        return true;
+      },
+      fill_factor);
+}
+
+/** @brief Check that the tree holds exactly keys, through a scan and through lookups. */
+static void CheckKeys(Tree *tree, const std::vector<int64_t> &keys) {
+  size_t i = 0;
+  for (auto it = tree->Begin(); it != tree->End(); ++it, ++i) {
+    ASSERT_LT(i, keys.size());
+    EXPECT_EQ(keys[i], (*it).second.GetSlotNum());
+  }
+  EXPECT_EQ(keys.size(), i);
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree->GetValue(index_key, &rids));
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+
+  // Scenario: trees of every height, with last pages that are full, short or nearly empty, are built correctly.
+  for (double fill_factor : {1.0, 0.7, 0.1}) {
+    for (int64_t num_keys : {0, 1, 2, 3, 4, 5, 7, 10, 31, 100, 1000}) {
+      page_id_t header_page_id;
+      bpm->NewPageGuarded(&header_page_id).Drop();
+      Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 4, 5);
+      std::vector<int64_t> keys;
+      for (int64_t key = 0; key < num_keys; key++) {
+        keys.push_back(key * 3);
+      }
+      ASSERT_TRUE(BulkLoadKeys(&tree, keys, fill_factor));
+      CheckKeys(&tree, keys);
+
+      // Scenario: the tree stays valid while it is modified afterwards, down to empty and back.
+      GenericKey<8> index_key;
+      RID rid;
+      for (auto key : keys) {
+        index_key.SetFromInteger(key + 1);
+        rid.Set(0, static_cast<uint32_t>(key + 1));
+        ASSERT_TRUE(tree.Insert(index_key, rid));
+      }
+      for (auto key : keys) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key, nullptr);
+      }
+      std::vector<int64_t> inserted;
+      for (auto key : keys) {
+        inserted.push_back(key + 1);
+      }
+      CheckKeys(&tree, inserted);
+      for (auto key : inserted) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key, nullptr);
+      }
+      EXPECT_TRUE(tree.IsEmpty());
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, ScanReadAheadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 16, 16);
+  const int64_t num_leaves = 250;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 16 * num_leaves; key++) {
+    keys.push_back(key);
+  }
+  ASSERT_TRUE(BulkLoadKeys(&tree, keys, 1.0));
+  // Read-ahead does not write back dirty pages to make room.
+  bpm->FlushAllPages();
+
+  // Scenario: a scan over bulk loaded leaves, most of which are no longer cached, reads them ahead instead of missing
+  // on every leaf.
+  bpm->ResetStats();
+  int64_t num_scanned = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    num_scanned++;
+  }
+  EXPECT_EQ(16 * num_leaves, num_scanned);
+  EXPECT_GT(bpm->GetStats().prefetches_, num_leaves / 2);
+  EXPECT_LT(bpm->GetStats().misses_, num_leaves / 4);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, BulkLoadRejectTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 4, 5);
+
+  // Scenario: duplicate keys are dropped, the first one is kept.
+  ASSERT_TRUE(BulkLoadKeys(&tree, {1, 1, 2, 3, 3, 3}, 1.0));
+  CheckKeys(&tree, {1, 2, 3});
+
+  // Scenario: a tree that is not empty is not bulk loaded.
+  EXPECT_FALSE(BulkLoadKeys(&tree, {4}, 1.0));
+  for (int64_t key : {1, 2, 3}) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, nullptr);
+  }
+
+  // Scenario: unsorted input leaves the tree empty, and the pages built so far are freed for reuse.
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 100; key++) {
+    keys.push_back(key);
+  }
+  keys.push_back(50);
+  EXPECT_FALSE(BulkLoadKeys(&tree, keys, 1.0));
+  EXPECT_TRUE(tree.IsEmpty());
+  page_id_t page_id;
+  bpm->NewPageGuarded(&page_id).Drop();
+  EXPECT_LT(page_id, 10);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, IndexBulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  std::vector<uint32_t> key_attrs{0};
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", key_schema.get(), key_attrs);
+  BPlusTreeIndexForTwoIntegerColumn index(std::move(metadata), bpm.get());
+
+  // Scenario: entries in random order with duplicate keys are sorted, and the first entry of each key is kept.
+  std::vector<std::pair<IntegerKeyType, RID>> entries;
+  std::mt19937 gen(42);
+  for (int64_t i = 0; i < 10000; i++) {
+    IntegerKeyType key;
+    key.SetFromInteger(static_cast<int64_t>(gen() % 5000));
+    entries.emplace_back(key, RID(0, static_cast<uint32_t>(i)));
+  }
+  std::map<int64_t, uint32_t> expected;
+  for (const auto &[key, rid] : entries) {
+    expected.emplace(key.ToString(), rid.GetSlotNum());
+  }
+  ASSERT_TRUE(index.BulkLoad(entries, nullptr));
+
+  auto expected_it = expected.begin();
+  for (auto it = index.GetBeginIterator(); it != index.GetEndIterator(); ++it, ++expected_it) {
+    ASSERT_NE(expected.end(), expected_it);
+    EXPECT_EQ(expected_it->first, (*it).first.ToString());
+    EXPECT_EQ(expected_it->second, (*it).second.GetSlotNum());
+  }
+  EXPECT_EQ(expected.end(), expected_it);
+  EXPECT_FALSE(index.BulkLoad(entries, nullptr));
+}
+
+}  // namespace bustub
@@ -11,9 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "storage/index/b_plus_tree.h"
@@ -23,6 +25,46 @@ namespace bustub {
 
 using bustub::DiskManagerUnlimitedMemory;
 
+/** An in-memory disk manager whose reads or writes can be made to fail. */
+class FailingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (fail_reads_) {
+      throw Exception("injected read error");
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (fail_writes_) {
+      throw Exception("injected write error");
+    }
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  void FailReads(bool fail) { fail_reads_ = fail; }
+  void FailWrites(bool fail) { fail_writes_ = fail; }
+
+ private:
+  std::atomic<bool> fail_reads_{false};
+  std::atomic<bool> fail_writes_{false};
+};
+
+/** Evict the pages of num_frames frames by filling them with new pages, which are deleted again. */
+static void EvictFrames(BufferPoolManager *bpm, size_t num_frames) {
+  std::vector<page_id_t> page_ids(num_frames);
+  for (auto &page_id : page_ids) {
+    // A frame may still be pinned by a read ahead.
+    for (int attempt = 0; bpm->NewPage(&page_id) == nullptr; attempt++) {
+      ASSERT_TRUE(BufferPoolManager::WaitForFrame(attempt));
+    }
+  }
+  for (auto page_id : page_ids) {
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+  }
+}
+
 TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
@@ -184,4 +226,105 @@ TEST(BPlusTreeTests, InsertTest3) {
   delete transaction;
   delete bpm;
 }
+TEST(BPlusTreeTests, DiskErrorTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<FailingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page_id, bpm.get(), comparator, 2, 3);
+
+  GenericKey<8> index_key;
+  RID rid;
+  std::vector<RID> rids;
+  auto contains = [&](int64_t key) {
+    index_key.SetFromInteger(key);
+    rids.clear();
+    return tree.GetValue(index_key, &rids);
+  };
+  for (int64_t key = 1; key <= 50; key++) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    ASSERT_TRUE(tree.Insert(index_key, rid));
+  }
+
+  // Scenario: the disk fails to read the pages of the tree. Every operation throws instead of retrying forever, and
+  // the tree is left as it was.
+  EvictFrames(bpm.get(), buffer_pool_size);
+  disk_manager->FailReads(true);
+  EXPECT_THROW(contains(1), Exception);
+  index_key.SetFromInteger(100);
+  EXPECT_THROW(tree.Insert(index_key, rid), Exception);
+  index_key.SetFromInteger(1);
+  EXPECT_THROW(tree.Remove(index_key, nullptr), Exception);
+  EXPECT_THROW(tree.Begin(), Exception);
+  disk_manager->FailReads(false);
+  for (int64_t key = 1; key <= 50; key++) {
+    EXPECT_TRUE(contains(key));
+  }
+  EXPECT_FALSE(contains(100));
+
+  // Scenario: a scan cannot read its next leaf. It ends with an error.
+  {
+    auto iterator = tree.Begin();
+    disk_manager->FailReads(true);
+    EvictFrames(bpm.get(), buffer_pool_size - 1);
+    EXPECT_THROW(
+        {
+          while (!iterator.IsEnd()) {
+            ++iterator;
+          }
+        },
+        Exception);
+    EXPECT_TRUE(iterator.IsEnd());
+    disk_manager->FailReads(false);
+  }
+
+  // Scenario: all frames are pinned. A lookup waits for one only so long, then throws.
+  {
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id;
+    while (bpm->NewPage(&page_id) != nullptr) {
+      page_ids.push_back(page_id);
+    }
+    EXPECT_THROW(contains(1), Exception);
+    for (auto pinned_page_id : page_ids) {
+      bpm->UnpinPage(pinned_page_id, false);
+      bpm->DeletePage(pinned_page_id);
+    }
+    EXPECT_TRUE(contains(1));
+  }
+
+  // Scenario: the disk fails to write back pages, so the buffer pool eventually has no frame for a split. The insert
+  // that fails leaves the tree as it was.
+  disk_manager->FailWrites(true);
+  int64_t failed_key = 0;
+  for (int64_t key = 51; key <= 1000 && failed_key == 0; key++) {
+    index_key.SetFromInteger(key);
+    rid.Set(0, key);
+    try {
+      tree.Insert(index_key, rid);
+    } catch (const Exception &) {
+      failed_key = key;
+    }
+  }
+  ASSERT_NE(0, failed_key);
+  disk_manager->FailWrites(false);
+  EXPECT_FALSE(contains(failed_key));
+  for (int64_t key = 1; key < failed_key; key++) {
+    EXPECT_TRUE(contains(key));
+  }
+  index_key.SetFromInteger(failed_key);
+  rid.Set(0, failed_key);
+  EXPECT_TRUE(tree.Insert(index_key, rid));
+  int64_t count = 0;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+    EXPECT_EQ(++count, (*iterator).second.GetSlotNum());
+  }
+  EXPECT_EQ(failed_key, count);
+}
 }  // namespace bustub
@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_search_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_key_search.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+static_assert(IntegerKey<GenericKey<8>, GenericComparator<8>>::IS_INTEGER);
+static_assert(!IntegerKey<GenericKey<16>, GenericComparator<16>>::IS_INTEGER);
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, IntegerKeySearchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::mt19937_64 rng(42);
+
+  // Scenario: for every size around the block boundaries, the integer search finds what the binary search through
+  // the comparator finds, for keys in the page, between them and beyond both ends.
+  for (int size = 0; size <= 300; size++) {
+    std::vector<int64_t> values;
+    for (int i = 0; i < size; i++) {
+      values.push_back(static_cast<int64_t>(rng() >> 1) * (i % 2 == 0 ? 1 : -1) / 4);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    std::vector<std::pair<GenericKey<8>, RID>> pairs(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+      pairs[i].first.SetFromInteger(values[i]);
+    }
+
+    std::vector<int64_t> targets{INT64_MIN, INT64_MAX, 0, -1};
+    for (auto value : values) {
+      targets.push_back(value);
+      targets.push_back(value + 1);
+      targets.push_back(value - 1);
+    }
+    GenericKey<8> key;
+    for (auto target : targets) {
+      key.SetFromInteger(target);
+      for (bool inclusive : {false, true}) {
+        int expected = BinarySearchPairs(pairs.data(), static_cast<int>(pairs.size()), key, comparator, inclusive);
+        ASSERT_EQ(expected, SearchPairs(pairs.data(), static_cast<int>(pairs.size()), key, comparator, inclusive))
+            << size << " " << target << " " << inclusive;
+      }
+    }
+  }
+}
+
+}  // namespace bustub
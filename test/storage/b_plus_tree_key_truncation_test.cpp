@@ -0,0 +1,428 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_truncation_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_truncation_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using InternalPage = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+using Tree = BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+
+/** @brief The number of children an inner page would hold if it stored the full 64 bytes of every key. */
+static const int UNTRUNCATED_FANOUT =
+    (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<64>, page_id_t>);
+
+/** @brief The number of pairs a leaf would hold if it stored the full 64 bytes of every key. */
+static const int UNCOMPRESSED_LEAF_SIZE =
+    (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<64>, RID>);
+
+/** @brief The most pairs a leaf holds, see LEAF_PAGE_SLOT_CNT. */
+static const int LEAF_MAX_SIZE = (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(RID) + 1);
+
+/** @brief A key that starts with a long path shared by all keys with the same directory, followed by a number. */
+static auto PathKey(const char *directory, int64_t number) -> GenericKey<64> {
+  GenericKey<64> key;
+  memset(key.data_, 0, sizeof(key.data_));
+  snprintf(key.data_, sizeof(key.data_), "%s/item-%010ld", directory, static_cast<long>(number));  // NOLINT
+  return key;
+}
+
+static const char *const PATH = "warehouse/europe/region-0042/orders";
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, InternalPageKeyTruncationTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  std::vector<char> buffer(BUSTUB_PAGE_SIZE);
+  std::vector<char> recipient_buffer(BUSTUB_PAGE_SIZE);
+  auto page = reinterpret_cast<InternalPage *>(buffer.data());
+  page->Init(INTERNAL_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+
+  // Scenario: keys are stored without their trailing zeros, so far more children fit than with full keys.
+  GenericKey<64> key;
+  int num_children = 0;
+  while (true) {
+    key.SetFromInteger(num_children * 1000);
+    if (!page->HasRoomFor(InternalPage::KeyLength(key))) {
+      break;
+    }
+    page->Append(key, num_children);
+    num_children++;
+  }
+  EXPECT_GT(num_children, 4 * UNTRUNCATED_FANOUT);
+  for (int i = 1; i < num_children; i++) {
+    ASSERT_EQ(i * 1000, page->KeyAt(i).ToString());
+    ASSERT_EQ(i, page->ValueAt(i));
+  }
+  key.SetFromInteger(5500);
+  EXPECT_EQ(5, page->Lookup(key, comparator));
+
+  // Scenario: a page without room splits into two pages of about the same bytes, separated by the key that moves up.
+  auto recipient = reinterpret_cast<InternalPage *>(recipient_buffer.data());
+  recipient->Init(INTERNAL_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  key.SetFromInteger(10500);
+  auto middle_key = page->InsertAndSplitTo(10, key, -10, recipient);
+  EXPECT_EQ(num_children + 1, page->GetSize() + recipient->GetSize());
+  EXPECT_LE(std::abs(page->GetUsedBytes() - recipient->GetUsedBytes()),
+            (2 * INTERNAL_PAGE_SPLIT_INTERVAL(num_children + 1) + 1) * (2 * INTERNAL_PAGE_SLOT_SIZE + 16));
+  EXPECT_LT(comparator(page->KeyAt(page->GetSize() - 1), middle_key), 0);
+  EXPECT_LT(comparator(middle_key, recipient->KeyAt(1)), 0);
+  EXPECT_EQ(-10, page->Lookup(key, comparator));
+
+  // Scenario: a key is replaced by a longer one only if the page has room for it.
+  std::vector<char> full_buffer(BUSTUB_PAGE_SIZE);
+  auto full_page = reinterpret_cast<InternalPage *>(full_buffer.data());
+  full_page->Init(INTERNAL_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  for (int i = 0;; i++) {
+    key.SetFromInteger(i);
+    if (!full_page->HasRoomFor(InternalPage::KeyLength(key))) {
+      break;
+    }
+    full_page->Append(key, i);
+  }
+  key.SetFromInteger(INT64_MAX);
+  key.data_[sizeof(key.data_) - 1] = 1;
+  EXPECT_FALSE(full_page->CanSetKeyAt(full_page->GetSize() - 1, key));
+  EXPECT_TRUE(recipient->CanSetKeyAt(recipient->GetSize() - 1, key));
+  recipient->SetKeyAt(recipient->GetSize() - 1, key);
+  EXPECT_EQ(INT64_MAX, recipient->KeyAt(recipient->GetSize() - 1).ToString());
+
+  // Scenario: the two halves merge back into one page, with the separator in between, once they fit into it.
+  EXPECT_FALSE(recipient->FitsInto(page, middle_key));
+  int num_removed = 0;
+  while (!recipient->FitsInto(page, middle_key)) {
+    recipient->Remove(recipient->GetSize() - 1);
+    num_removed++;
+  }
+  EXPECT_LE(num_removed, 2);
+  recipient->MoveAllTo(page, middle_key);
+  EXPECT_EQ(num_children + 1 - num_removed, page->GetSize());
+  EXPECT_EQ(0, recipient->GetSize());
+  for (int i = 2; i < page->GetSize(); i++) {
+    ASSERT_LT(comparator(page->KeyAt(i - 1), page->KeyAt(i)), 0);
+  }
+  key.SetFromInteger(10500);
+  EXPECT_EQ(-10, page->Lookup(key, comparator));
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, SeparatorTruncationTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  // Scenario: a separator is the shortest prefix of the right key that is still greater than the left key.
+  GenericKey<64> left;
+  GenericKey<64> right;
+  left.SetFromInteger(0x0102030405060708);
+  right.SetFromInteger(0x0102040000000001);
+  auto separator = InternalPage::Separator(left, right);
+  EXPECT_EQ(3, InternalPage::KeyLength(separator));
+  EXPECT_EQ(0x0102040000000000, separator.ToString());
+  left.SetFromInteger(41);
+  right.SetFromInteger(42);
+  EXPECT_EQ(42, InternalPage::Separator(left, right).ToString());
+
+  // Scenario: among the splits that are about as even, an internal page split moves up the shortest key. Every eighth
+  // key leaves out its last two bytes, which are zero, the others are stored whole.
+  std::vector<char> buffer(BUSTUB_PAGE_SIZE);
+  std::vector<char> recipient_buffer(BUSTUB_PAGE_SIZE);
+  auto page = reinterpret_cast<InternalPage *>(buffer.data());
+  auto recipient = reinterpret_cast<InternalPage *>(recipient_buffer.data());
+  page->Init(INTERNAL_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  recipient->Init(INTERNAL_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  GenericKey<64> key;
+  int num_children = 0;
+  while (true) {
+    key.SetFromInteger((static_cast<int64_t>(num_children) << 16) + (num_children % 8 == 0 ? 0 : 1));
+    if (!page->HasRoomFor(InternalPage::KeyLength(key))) {
+      break;
+    }
+    page->Append(key, num_children);
+    num_children++;
+  }
+  key.SetFromInteger((int64_t{10} << 16) + 2);
+  auto middle_key = page->InsertAndSplitTo(10, key, -10, recipient);
+  EXPECT_EQ(6, InternalPage::KeyLength(middle_key));
+  EXPECT_LE(std::abs(page->GetUsedBytes() - recipient->GetUsedBytes()),
+            (2 * INTERNAL_PAGE_SPLIT_INTERVAL(num_children + 1) + 1) * (2 * INTERNAL_PAGE_SLOT_SIZE + 16));
+  EXPECT_EQ(0, middle_key.ToString() % (1 << 16));
+  EXPECT_LT(comparator(page->KeyAt(page->GetSize() - 1), middle_key), 0);
+  EXPECT_LT(comparator(middle_key, recipient->KeyAt(1)), 0);
+  EXPECT_EQ(-10, page->Lookup(key, comparator));
+
+  // Scenario: leaves split by keys that differ early are separated by short keys, which route every key to its leaf.
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 3);
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < 200; i++) {
+    keys.push_back((i << 24) + 0xFFFFFF);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(44));
+  for (auto k : keys) {
+    key.SetFromInteger(k);
+    ASSERT_TRUE(tree.Insert(key, RID(0, static_cast<uint32_t>(k >> 24))));
+  }
+  {
+    auto root_guard = bpm->FetchPageRead(tree.GetRootPageId());
+    auto root = root_guard.As<InternalPage>();
+    ASSERT_FALSE(root->IsLeafPage());
+    for (int i = 1; i < root->GetSize(); i++) {
+      EXPECT_LE(InternalPage::KeyLength(root->KeyAt(i)), 5);
+      auto left_guard = bpm->FetchPageRead(root->ValueAt(i - 1));
+      auto left_leaf = left_guard.As<LeafPage>();
+      auto right_guard = bpm->FetchPageRead(root->ValueAt(i));
+      auto right_leaf = right_guard.As<LeafPage>();
+      EXPECT_LT(comparator(left_leaf->KeyAt(left_leaf->GetSize() - 1), root->KeyAt(i)), 0);
+      EXPECT_LE(comparator(root->KeyAt(i), right_leaf->KeyAt(0)), 0);
+    }
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(45));
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (i % 2 == 0) {
+      key.SetFromInteger(keys[i]);
+      tree.Remove(key, nullptr);
+    }
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<RID> rids;
+    key.SetFromInteger(keys[i]);
+    ASSERT_EQ(i % 2 == 1, tree.GetValue(key, &rids));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, KeyTruncationFanoutTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator, 3);
+
+  // Scenario: far more leaves than untruncated keys allow are linked from a single root.
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 400; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  GenericKey<64> index_key;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key))));
+  }
+  {
+    auto root_guard = bpm->FetchPageRead(tree.GetRootPageId());
+    auto root = root_guard.As<InternalPage>();
+    ASSERT_FALSE(root->IsLeafPage());
+    EXPECT_GT(root->GetSize(), 2 * UNTRUNCATED_FANOUT);
+    for (int i = 0; i < root->GetSize(); i++) {
+      EXPECT_TRUE(bpm->FetchPageRead(root->ValueAt(i)).As<BPlusTreePage>()->IsLeafPage());
+    }
+  }
+
+  // Scenario: the tree shrinks back to empty, and every key left is found on the way.
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(43));
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_key.SetFromInteger(keys[i]);
+    tree.Remove(index_key, nullptr);
+    if (i % 50 == 0) {
+      for (size_t j = i + 1; j < keys.size(); j++) {
+        std::vector<RID> rids;
+        index_key.SetFromInteger(keys[j]);
+        ASSERT_TRUE(tree.GetValue(index_key, &rids));
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  // Scenario: a bulk loaded tree with several inner pages per level fills them by their bytes.
+  const int64_t num_keys = 20000;
+  int64_t next = 0;
+  ASSERT_TRUE(tree.BulkLoad([&](GenericKey<64> *key, RID *rid) {
+    if (next == num_keys) {
+      return false;
+    }
+    key->SetFromInteger(next);
+    rid->Set(0, static_cast<uint32_t>(next));
+    next++;
+    return true;
+  }));
+  int64_t expected = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, ++expected) {
+    ASSERT_EQ(expected, (*it).first.ToString());
+  }
+  EXPECT_EQ(num_keys, expected);
+  for (int64_t key = 0; key < num_keys; key += 7) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, LeafPagePrefixCompressionTest) {
+  auto key_schema = ParseCreateStatement("a varchar(64)");
+  GenericComparator<64> comparator(key_schema.get());
+  std::vector<char> buffer(BUSTUB_PAGE_SIZE);
+  std::vector<char> recipient_buffer(BUSTUB_PAGE_SIZE);
+  auto page = reinterpret_cast<LeafPage *>(buffer.data());
+  page->Init(LEAF_MAX_SIZE, BUSTUB_PAGE_SIZE);
+
+  // Scenario: the path all keys start with is stored once, so far more pairs fit than with full keys.
+  std::vector<int64_t> numbers;
+  for (int64_t i = 0; i < 1000; i++) {
+    numbers.push_back(i);
+  }
+  std::shuffle(numbers.begin(), numbers.end(), std::mt19937(46));
+  int num_pairs = 0;
+  while (page->HasRoomFor(PathKey(PATH, numbers[num_pairs]))) {
+    ASSERT_TRUE(page->Insert(PathKey(PATH, numbers[num_pairs]), RID(0, numbers[num_pairs]), comparator));
+    num_pairs++;
+  }
+  EXPECT_GT(num_pairs, 2 * UNCOMPRESSED_LEAF_SIZE);
+  EXPECT_GE(page->GetPrefixLength(), static_cast<int>(strlen(PATH)));
+  EXPECT_LE(page->GetUsedBytes(), BUSTUB_PAGE_SIZE);
+  for (int i = 0; i < num_pairs; i++) {
+    RID rid;
+    ASSERT_TRUE(page->Lookup(PathKey(PATH, numbers[i]), &rid, comparator));
+    ASSERT_EQ(numbers[i], rid.GetSlotNum());
+  }
+  for (int i = 1; i < num_pairs; i++) {
+    ASSERT_LT(comparator(page->KeyAt(i - 1), page->KeyAt(i)), 0);
+  }
+
+  // Scenario: the full page splits into two pages that both fit, and the pairs stay in order across them.
+  auto recipient = reinterpret_cast<LeafPage *>(recipient_buffer.data());
+  recipient->Init(LEAF_MAX_SIZE, BUSTUB_PAGE_SIZE);
+  GenericKey<64> key = PathKey(PATH, numbers[num_pairs]);
+  page->InsertAndSplitTo(key, RID(0, numbers[num_pairs]), comparator, recipient, 1);
+  EXPECT_EQ(num_pairs + 1, page->GetSize() + recipient->GetSize());
+  EXPECT_LE(page->GetUsedBytes(), BUSTUB_PAGE_SIZE);
+  EXPECT_LE(recipient->GetUsedBytes(), BUSTUB_PAGE_SIZE);
+  EXPECT_TRUE(page->IsHalfFull());
+  EXPECT_TRUE(recipient->IsHalfFull());
+  EXPECT_EQ(1, page->GetNextPageId());
+  EXPECT_LT(comparator(page->KeyAt(page->GetSize() - 1), recipient->KeyAt(0)), 0);
+
+  // Scenario: a key from another directory shortens the prefix, and every pair is still read back whole.
+  page->Init(LEAF_MAX_SIZE, BUSTUB_PAGE_SIZE);
+  for (int64_t i = 0; i < 20; i++) {
+    ASSERT_TRUE(page->Insert(PathKey(PATH, i), RID(0, i), comparator));
+  }
+  int prefix_length = page->GetPrefixLength();
+  key = PathKey("warehouse/asia", 7);
+  ASSERT_TRUE(page->HasRoomFor(key));
+  ASSERT_TRUE(page->Insert(key, RID(1, 7), comparator));
+  EXPECT_LT(page->GetPrefixLength(), prefix_length);
+  EXPECT_EQ(static_cast<int>(strlen("warehouse/")), page->GetPrefixLength());
+  EXPECT_EQ(0, comparator(key, page->KeyAt(0)));
+  EXPECT_EQ(RID(1, 7), page->ValueAt(0));
+  for (int64_t i = 0; i < 20; i++) {
+    ASSERT_EQ(0, comparator(PathKey(PATH, i), page->KeyAt(i + 1)));
+    ASSERT_EQ(RID(0, i), page->ValueAt(i + 1));
+  }
+
+  // Scenario: the pairs of one page are merged into another, and both prefixes give way to the one they share.
+  recipient->Init(LEAF_MAX_SIZE, BUSTUB_PAGE_SIZE);
+  ASSERT_TRUE(recipient->Insert(PathKey("archive", 1), RID(2, 1), comparator));
+  ASSERT_TRUE(page->FitsInto(recipient));
+  page->MoveAllTo(recipient);
+  EXPECT_EQ(0, page->GetSize());
+  EXPECT_EQ(22, recipient->GetSize());
+  EXPECT_EQ(0, recipient->GetPrefixLength());
+  EXPECT_EQ(0, comparator(PathKey("archive", 1), recipient->KeyAt(0)));
+  EXPECT_EQ(0, comparator(PathKey(PATH, 19), recipient->KeyAt(21)));
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, PrefixCompressedTreeTest) {
+  auto key_schema = ParseCreateStatement("a varchar(64)");
+  GenericComparator<64> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t header_page_id;
+  bpm->NewPageGuarded(&header_page_id).Drop();
+  Tree tree("foo_pk", header_page_id, bpm.get(), comparator);
+
+  // Scenario: keys with a long shared path need far fewer leaves than full keys would.
+  const int64_t num_keys = 5000;
+  std::vector<int64_t> numbers;
+  for (int64_t i = 0; i < num_keys; i++) {
+    numbers.push_back(i);
+  }
+  std::shuffle(numbers.begin(), numbers.end(), std::mt19937(47));
+  for (auto number : numbers) {
+    ASSERT_TRUE(tree.Insert(PathKey(PATH, number), RID(0, number)));
+  }
+  {
+    auto root_guard = bpm->FetchPageRead(tree.GetRootPageId());
+    auto root = root_guard.As<InternalPage>();
+    ASSERT_FALSE(root->IsLeafPage());
+    EXPECT_LT(root->GetSize(), num_keys / UNCOMPRESSED_LEAF_SIZE);
+  }
+  int64_t expected = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, ++expected) {
+    ASSERT_EQ(0, comparator(PathKey(PATH, expected), (*it).first));
+    ASSERT_EQ(expected, (*it).second.GetSlotNum());
+  }
+  EXPECT_EQ(num_keys, expected);
+
+  // Scenario: keys from other directories shorten the prefixes of the leaves they land in, and half of the keys are
+  // removed again, merging the leaves that are left underfull.
+  for (int64_t i = 0; i < num_keys; i += 100) {
+    ASSERT_TRUE(tree.Insert(PathKey("warehouse/europe/region-0042/returns", i), RID(1, i)));
+    ASSERT_TRUE(tree.Insert(PathKey("warehouse/asia", i), RID(2, i)));
+  }
+  for (size_t i = 0; i < numbers.size(); i += 2) {
+    tree.Remove(PathKey(PATH, numbers[i]), nullptr);
+  }
+  for (size_t i = 0; i < numbers.size(); i++) {
+    std::vector<RID> rids;
+    ASSERT_EQ(i % 2 == 1, tree.GetValue(PathKey(PATH, numbers[i]), &rids));
+  }
+  for (int64_t i = 0; i < num_keys; i += 100) {
+    std::vector<RID> rids;
+    ASSERT_TRUE(tree.GetValue(PathKey("warehouse/europe/region-0042/returns", i), &rids));
+    ASSERT_EQ(RID(1, i), rids[0]);
+    ASSERT_TRUE(tree.GetValue(PathKey("warehouse/asia", i), &rids));
+    ASSERT_EQ(RID(2, i), rids[1]);
+  }
+  int64_t count = 0;
+  GenericKey<64> previous;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, ++count) {
+    if (count > 0) {
+      ASSERT_LT(comparator(previous, (*it).first), 0);
+    }
+    previous = (*it).first;
+  }
+  EXPECT_EQ(num_keys / 2 + 2 * num_keys / 100, count);
+}
+
+}  // namespace bustub
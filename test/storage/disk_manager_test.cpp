@@ -11,10 +11,21 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_mmap.h"
+#include "storage/disk/disk_manager_posix.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -24,12 +35,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
   };
 };
 
@@ -75,4 +88,454 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageSizeTest) {
+  const size_t page_size = 16384;
+  std::string db_file("test.db");
+  EXPECT_THROW(DiskManager(db_file, 1000), Exception);
+  EXPECT_THROW(DiskManager(db_file, 2 * BUSTUB_MAX_PAGE_SIZE), Exception);
+  remove("test.db");
+
+  std::vector<char> data(page_size);
+  for (size_t i = 0; i < page_size; i++) {
+    data[i] = static_cast<char>(i * 7);
+  }
+  {
+    auto dm = DiskManager(db_file, page_size);
+    EXPECT_EQ(page_size, dm.GetPageSize());
+    dm.WritePage(0, data.data());
+    dm.WritePage(3, data.data());
+    dm.ShutDown();
+  }
+
+  // Scenario: the page size is stored in the file, and wins over the one asked for when the file is opened again.
+  for (bool posix : {false, true}) {
+    std::unique_ptr<DiskManager> dm;
+    if (posix) {
+      dm = std::make_unique<DiskManagerPosix>(db_file);
+    } else {
+      dm = std::make_unique<DiskManager>(db_file);
+    }
+    EXPECT_EQ(page_size, dm->GetPageSize());
+    std::vector<char> buf(page_size);
+    for (page_id_t page_id : {0, 3}) {
+      dm->ReadPage(page_id, buf.data());
+      EXPECT_EQ(data, buf);
+    }
+    dm->ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixReadWritePageTest) {
+  for (bool direct_io : {false, true}) {
+    // Page buffers of the buffer pool are aligned, a stack buffer goes through the bounce buffer with O_DIRECT.
+    auto *buf = new (std::align_val_t(BUSTUB_PAGE_ALIGNMENT)) char[BUSTUB_PAGE_SIZE];
+    char data[BUSTUB_PAGE_SIZE] = {0};
+    std::string db_file("test.db");
+    auto dm = DiskManagerPosix(db_file, direct_io, 2);
+    std::strncpy(data, "A test string.", sizeof(data));
+
+    // Scenario: reading past the end of the file yields a zeroed page.
+    std::memset(buf, 1, BUSTUB_PAGE_SIZE);
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(0, buf[BUSTUB_PAGE_SIZE - 1]);
+
+    dm.WritePage(0, data);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+
+    std::memset(buf, 0, BUSTUB_PAGE_SIZE);
+    dm.WritePage(5, data);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+    EXPECT_EQ(2, dm.GetNumWrites());
+
+    dm.ShutDown();
+
+    // Scenario: I/O errors are reported to the caller, here because the file is closed.
+    EXPECT_THROW(dm.WritePage(0, data), Exception);
+    EXPECT_THROW(dm.ReadPage(0, buf), Exception);
+
+    // Scenario: the pages survive reopening the file, and the fstream disk manager reads the same layout.
+    auto dm_fstream = DiskManager(db_file);
+    std::memset(buf, 0, BUSTUB_PAGE_SIZE);
+    dm_fstream.ReadPage(5, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+    dm_fstream.ShutDown();
+
+    ::operator delete[](buf, std::align_val_t(BUSTUB_PAGE_ALIGNMENT));
+    remove("test.db");
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixConcurrentReadWriteTest) {
+  const size_t num_threads = 8;
+  const size_t num_pages = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManagerPosix(db_file);
+
+  // Scenario: threads write and read back disjoint pages without any latch in between.
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back([&, thread_id] {
+      char data[BUSTUB_PAGE_SIZE];
+      char buf[BUSTUB_PAGE_SIZE];
+      for (size_t page_id = thread_id; page_id < num_pages; page_id += num_threads) {
+        std::memset(data, static_cast<int>(page_id), sizeof(data));
+        dm.WritePage(static_cast<page_id_t>(page_id), data);
+      }
+      for (size_t page_id = thread_id; page_id < num_pages; page_id += num_threads) {
+        dm.ReadPage(static_cast<page_id_t>(page_id), buf);
+        EXPECT_EQ(static_cast<char>(page_id), buf[0]);
+        EXPECT_EQ(static_cast<char>(page_id), buf[BUSTUB_PAGE_SIZE - 1]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadWritePageTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+  {
+    // A mapping of 8 pages, the pages after it are read with pread.
+    auto dm = DiskManagerMmap(db_file, DISK_SYNC_INTERVAL, BUSTUB_PAGE_SIZE, 8 * BUSTUB_PAGE_SIZE);
+
+    // Scenario: reading past the end of the file yields a zeroed page, and has no view.
+    std::memset(buf, 1, BUSTUB_PAGE_SIZE);
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(0, buf[BUSTUB_PAGE_SIZE - 1]);
+    EXPECT_EQ(nullptr, dm.GetPageView(3));
+
+    // Scenario: writes that grow the file are seen by the mapping.
+    dm.WritePage(0, data);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+    dm.WritePage(5, data);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+    const char *view = dm.GetPageView(5);
+    ASSERT_NE(nullptr, view);
+    EXPECT_EQ(std::memcmp(view, data, BUSTUB_PAGE_SIZE), 0);
+
+    // Scenario: a rewrite shows through an existing view.
+    std::strncpy(data, "Another test string.", sizeof(data));
+    dm.WritePage(5, data);
+    EXPECT_EQ(std::memcmp(view, data, BUSTUB_PAGE_SIZE), 0);
+
+    // Scenario: pages past the mapping are read and written with pread and pwrite.
+    dm.WritePage(20, data);
+    dm.ReadPage(20, buf);
+    EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+    EXPECT_EQ(nullptr, dm.GetPageView(20));
+    dm.ShutDown();
+  }
+
+  // Scenario: the file has the plain layout of DiskManagerPosix.
+  auto dm_posix = DiskManagerPosix(db_file);
+  std::memset(buf, 0, BUSTUB_PAGE_SIZE);
+  dm_posix.ReadPage(5, buf);
+  EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_SIZE), 0);
+  dm_posix.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedReadWritePageTest) {
+  const size_t num_pages = 32;
+  std::string db_file("test.db");
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE, 0));
+  for (size_t i = 0; i < num_pages; ++i) {
+    // Rows of a table page that repeat the same few values.
+    for (size_t offset = 0; offset + 32 < BUSTUB_PAGE_SIZE; offset += 32) {
+      snprintf(pages[i].data() + offset, 32, "customer-%zu status-%zu", offset % 5, i % 3);
+    }
+  }
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  {
+    auto dm = DiskManagerCompressed(db_file);
+
+    // Scenario: a page that was never written reads as zeros.
+    std::fill(buf.begin(), buf.end(), 1);
+    dm.ReadPage(3, buf.data());
+    EXPECT_EQ(std::vector<char>(BUSTUB_PAGE_SIZE, 0), buf);
+
+    for (size_t i = 0; i < num_pages; ++i) {
+      dm.WritePage(static_cast<page_id_t>(i), pages[i].data());
+    }
+    EXPECT_EQ(num_pages, dm.GetNumPages());
+    EXPECT_GT(num_pages * BUSTUB_PAGE_SIZE / 4, dm.GetStoredBytes());
+
+    // Scenario: a page that no longer compresses moves to a larger extent, and one that compresses better again moves
+    // to a smaller one.
+    std::mt19937 gen(5);
+    for (auto &byte : pages[7]) {
+      byte = static_cast<char>(gen());
+    }
+    dm.WritePage(7, pages[7].data());
+    std::fill(pages[8].begin(), pages[8].end(), 0);
+    dm.WritePage(8, pages[8].data());
+    EXPECT_EQ(num_pages, dm.GetNumPages());
+
+    for (size_t i = 0; i < num_pages; ++i) {
+      dm.ReadPage(static_cast<page_id_t>(i), buf.data());
+      EXPECT_EQ(pages[i], buf);
+    }
+    dm.ShutDown();
+  }
+
+  // Scenario: the page map is rebuilt from the extents when the file is opened again, with the newest extent of page 7.
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    EXPECT_EQ(num_pages, dm.GetNumPages());
+    for (size_t i = 0; i < num_pages; ++i) {
+      dm.ReadPage(static_cast<page_id_t>(i), buf.data());
+      EXPECT_EQ(pages[i], buf);
+    }
+    // Scenario: the extent page 7 left behind is reused by the next page that needs the space.
+    std::fill(pages[9].begin(), pages[9].end(), 0);
+    dm.WritePage(40, pages[9].data());
+    dm.ReadPage(40, buf.data());
+    EXPECT_EQ(pages[9], buf);
+    dm.ShutDown();
+  }
+
+  // Scenario: a file of compressed pages cannot be opened as a file of plain pages, and the other way round.
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+  EXPECT_THROW(DiskManagerPosix{db_file}, Exception);
+  remove("test.db");
+  DiskManagerPosix{db_file}.ShutDown();
+  EXPECT_THROW(DiskManagerCompressed{db_file}, Exception);
+}
+
+/** Flip a byte of a file, the offset counts from the end of the file. */
+static void CorruptFile(const std::string &file_name, size_t offset_from_end) {
+  std::fstream file(file_name, std::ios::binary | std::ios::in | std::ios::out);
+  auto offset = static_cast<std::streamoff>(std::filesystem::file_size(file_name) - offset_from_end);
+  char byte;
+  file.seekg(offset);
+  file.read(&byte, 1);
+  byte = static_cast<char>(~byte);
+  file.seekp(offset);
+  file.write(&byte, 1);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedTornWriteTest) {
+  std::string db_file("test.db");
+  std::string crash_file("crash.db");
+  std::vector<char> old_data(BUSTUB_PAGE_SIZE, 0);
+  std::vector<char> new_data(BUSTUB_PAGE_SIZE, 0);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  snprintf(old_data.data(), BUSTUB_PAGE_SIZE, "old copy");
+  snprintf(new_data.data(), BUSTUB_PAGE_SIZE, "new copy");
+
+  {
+    auto dm = DiskManagerCompressed(db_file, 0);
+    dm.WritePage(0, old_data.data());
+    dm.Sync();
+    dm.WritePage(0, new_data.data());
+
+    // Scenario: the file is copied as a crash would leave it, with the new copy of the page torn. The new copy was
+    // appended to the file, so the page keeps its old copy.
+    remove(crash_file.c_str());
+    std::filesystem::copy_file(db_file, crash_file);
+    CorruptFile(crash_file, 1);
+
+    // Scenario: reading a corrupt extent is an error rather than an empty page.
+    CorruptFile(db_file, 1);
+    EXPECT_THROW(dm.ReadPage(0, buf.data()), Exception);
+    CorruptFile(db_file, 1);
+    dm.ReadPage(0, buf.data());
+    EXPECT_EQ(new_data, buf);
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManagerCompressed(crash_file);
+    EXPECT_EQ(1, dm.GetNumPages());
+    dm.ReadPage(0, buf.data());
+    EXPECT_EQ(old_data, buf);
+    dm.ShutDown();
+  }
+  remove(crash_file.c_str());
+  remove("crash.log");
+  remove("crash.fsm");
+
+  // Scenario: once the new copy was synced, the old copy is freed and the page keeps the new copy after reopening.
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    dm.ReadPage(0, buf.data());
+    EXPECT_EQ(new_data, buf);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, TruncatePagesTest) {
+  const size_t num_pages = 32;
+  std::string db_file("test.db");
+  std::vector<char> data(BUSTUB_PAGE_SIZE, 0);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  std::vector<char> zeros(BUSTUB_PAGE_SIZE, 0);
+
+  // Scenario: a file of plain pages is cut after the kept pages, and a cut page reads as zeros.
+  {
+    auto dm = DiskManagerPosix(db_file);
+    for (size_t i = 0; i < num_pages; ++i) {
+      snprintf(data.data(), BUSTUB_PAGE_SIZE, "page %zu", i);
+      dm.WritePage(static_cast<page_id_t>(i), data.data());
+    }
+    auto file_size = std::filesystem::file_size(db_file);
+    dm.TruncatePages(num_pages / 2);
+    EXPECT_EQ(file_size - num_pages / 2 * BUSTUB_PAGE_SIZE, std::filesystem::file_size(db_file));
+    dm.TruncatePages(num_pages);
+    EXPECT_EQ(file_size - num_pages / 2 * BUSTUB_PAGE_SIZE, std::filesystem::file_size(db_file));
+    dm.ReadPage(num_pages / 2 - 1, buf.data());
+    EXPECT_STREQ("page 15", buf.data());
+    dm.ReadPage(num_pages / 2, buf.data());
+    EXPECT_EQ(zeros, buf);
+    dm.ShutDown();
+  }
+  remove("test.db");
+
+  // Scenario: the extents of the cut pages of a compressed file stay dropped when it is opened again.
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    for (size_t i = 0; i < num_pages; ++i) {
+      snprintf(data.data(), BUSTUB_PAGE_SIZE, "page %zu", i);
+      dm.WritePage(static_cast<page_id_t>(i), data.data());
+    }
+    auto file_size = std::filesystem::file_size(db_file);
+    dm.TruncatePages(num_pages / 2);
+    EXPECT_EQ(num_pages / 2, dm.GetNumPages());
+    EXPECT_GT(file_size, std::filesystem::file_size(db_file));
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    EXPECT_EQ(num_pages / 2, dm.GetNumPages());
+    dm.ReadPage(num_pages / 2 - 1, buf.data());
+    EXPECT_STREQ("page 15", buf.data());
+    dm.ReadPage(num_pages / 2, buf.data());
+    EXPECT_EQ(zeros, buf);
+    dm.ShutDown();
+  }
+  remove("test.db");
+
+  // Scenario: a cut page that moved to a larger extent is not brought back from the extent it left, even though a
+  // kept page moved after it and the file is not cut short of that extent.
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    for (page_id_t i = 0; i < 4; ++i) {
+      snprintf(data.data(), BUSTUB_PAGE_SIZE, "page %d", i);
+      dm.WritePage(i, data.data());
+    }
+    std::mt19937 gen(7);
+    for (auto &byte : data) {
+      byte = static_cast<char>(gen());
+    }
+    dm.WritePage(2, data.data());
+    dm.WritePage(1, data.data());
+    dm.TruncatePages(2);
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManagerCompressed(db_file);
+    EXPECT_EQ(2, dm.GetNumPages());
+    dm.ReadPage(1, buf.data());
+    EXPECT_EQ(data, buf);
+    dm.ReadPage(2, buf.data());
+    EXPECT_EQ(zeros, buf);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, UringBatchTest) {
+  const size_t num_pages = 100;
+  for (bool direct_io : {false, true}) {
+    std::string db_file("test.db");
+    auto dm = DiskManagerUring(db_file, direct_io);
+
+    std::vector<char *> buffers;
+    for (size_t i = 0; i < num_pages; ++i) {
+      buffers.push_back(new (std::align_val_t(BUSTUB_PAGE_ALIGNMENT)) char[BUSTUB_PAGE_SIZE]);
+    }
+    // Scenario: half of the buffers are registered, the others are plain buffers.
+    dm.RegisterBuffers(std::vector<char *>(buffers.begin(), buffers.begin() + num_pages / 2));
+
+    std::vector<DiskIo> writes;
+    for (size_t i = 0; i < num_pages; ++i) {
+      std::memset(buffers[i], static_cast<int>(i + 1), BUSTUB_PAGE_SIZE);
+      writes.push_back({true, static_cast<page_id_t>(i), buffers[i]});
+    }
+    dm.ExecuteBatch(writes);
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+    if (dm.IsUringEnabled()) {
+      // Scenario: a batch is submitted in chunks of the ring size, not one request at a time.
+      EXPECT_LE(dm.GetNumSubmissions(), 2 * ((num_pages + 63) / 64));
+    }
+
+    // Scenario: a write and a read of the same page in one batch are executed in order, and a read past the end of
+    // the file yields a zeroed page.
+    char data[BUSTUB_PAGE_SIZE];
+    std::memset(data, 'x', sizeof(data));
+    std::vector<DiskIo> reads;
+    for (size_t i = 0; i < num_pages; ++i) {
+      std::memset(buffers[i], 0, BUSTUB_PAGE_SIZE);
+      reads.push_back({false, static_cast<page_id_t>(num_pages - 1 - i), buffers[i]});
+    }
+    reads.push_back({true, 0, data});
+    reads.push_back({false, 0, buffers[num_pages - 1]});
+    reads.push_back({false, static_cast<page_id_t>(num_pages + 10), buffers[0]});
+    dm.ExecuteBatch(reads);
+
+    for (size_t i = 1; i + 1 < num_pages; ++i) {
+      EXPECT_EQ(static_cast<char>(num_pages - i), buffers[i][0]);
+      EXPECT_EQ(static_cast<char>(num_pages - i), buffers[i][BUSTUB_PAGE_SIZE - 1]);
+    }
+    EXPECT_EQ('x', buffers[num_pages - 1][0]);
+    EXPECT_EQ(0, buffers[0][0]);
+
+    // Scenario: batches keep running on the rings while the buffers are unregistered and registered again, and
+    // neither side deadlocks.
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t <= 4; ++t) {
+      threads.emplace_back([&dm, &buffers, t] {
+        for (size_t round = 0; round < 50; ++round) {
+          dm.ExecuteBatch({{false, static_cast<page_id_t>(t), buffers[t]}});
+        }
+      });
+    }
+    for (size_t round = 0; round < 20; ++round) {
+      dm.UnregisterBuffers();
+      dm.RegisterBuffers(std::vector<char *>(buffers.begin(), buffers.begin() + num_pages / 2));
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (size_t t = 1; t <= 4; ++t) {
+      EXPECT_EQ(static_cast<char>(t + 1), buffers[t][0]);
+    }
+
+    dm.UnregisterBuffers();
+    dm.ShutDown();
+    for (auto *buffer : buffers) {
+      ::operator delete[](buffer, std::align_val_t(BUSTUB_PAGE_ALIGNMENT));
+    }
+    remove("test.db");
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+/** Records the order in which pages are written. */
+class RecordingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+    std::scoped_lock lock(mutex_);
+    written_.push_back(page_id);
+  }
+
+  auto GetWritten() -> std::vector<page_id_t> {
+    std::scoped_lock lock(mutex_);
+    return written_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<page_id_t> written_;
+};
+
+/** Fails every write, like a disk that returns an I/O error. */
+class FailingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override { throw Exception("injected write error"); }
+};
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, ScheduleWriteReadPageTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+
+  auto dm = std::make_unique<DiskManagerUnlimitedMemory>();
+  dm->SetLatency(1);
+  auto disk_scheduler = std::make_unique<DiskScheduler>(dm.get());
+
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  auto promise1 = disk_scheduler->CreatePromise();
+  auto future1 = promise1.get_future();
+  auto promise2 = disk_scheduler->CreatePromise();
+  auto future2 = promise2.get_future();
+
+  // Scenario: a read queued behind a write of the same page sees the written data.
+  disk_scheduler->Schedule({/*is_write=*/true, data, /*page_id=*/0, std::move(promise1)});
+  disk_scheduler->Schedule({/*is_write=*/false, buf, /*page_id=*/0, std::move(promise2)});
+
+  ASSERT_TRUE(future1.get());
+  ASSERT_TRUE(future2.get());
+  ASSERT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+}
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, ConcurrentRequestsTest) {
+  const size_t num_workers = 4;
+  const size_t num_requests = 8;
+  const size_t latency_ms = 50;
+
+  auto dm = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto disk_scheduler = std::make_unique<DiskScheduler>(dm.get(), num_workers);
+  std::vector<std::array<char, BUSTUB_PAGE_SIZE>> pages(num_requests);
+  dm->SetLatency(latency_ms);
+
+  // Scenario: requests for pages that are not adjacent are spread over the workers and are in flight at once.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<bool>> futures;
+  for (size_t i = 0; i < num_requests; ++i) {
+    auto promise = disk_scheduler->CreatePromise();
+    futures.push_back(promise.get_future());
+    disk_scheduler->Schedule({true, pages[i].data(), static_cast<page_id_t>(i * 2), std::move(promise)});
+  }
+  for (auto &future : futures) {
+    ASSERT_TRUE(future.get());
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(latency_ms * num_requests));
+}
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, MergeAdjacentPagesTest) {
+  auto dm = std::make_unique<RecordingDiskManager>();
+  dm->SetLatency(50);
+  auto disk_scheduler = std::make_unique<DiskScheduler>(dm.get(), 1);
+  char data[BUSTUB_PAGE_SIZE] = {0};
+
+  // Scenario: while the only worker is busy with page 100, the other requests pile up in the queue.
+  std::vector<std::future<bool>> futures;
+  for (page_id_t page_id : {100, 7, 3, 50, 5, 4, 6}) {
+    auto promise = disk_scheduler->CreatePromise();
+    futures.push_back(promise.get_future());
+    disk_scheduler->Schedule({true, data, page_id, std::move(promise)});
+  }
+  for (auto &future : futures) {
+    ASSERT_TRUE(future.get());
+  }
+
+  // Scenario: the worker takes the pages adjacent to page 7 as one ascending run before it gets to page 50.
+  EXPECT_EQ((std::vector<page_id_t>{100, 3, 4, 5, 6, 7, 50}), dm->GetWritten());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, DiskErrorTest) {
+  auto dm = std::make_unique<FailingDiskManager>();
+  auto disk_scheduler = std::make_unique<DiskScheduler>(dm.get());
+  char data[BUSTUB_PAGE_SIZE] = {0};
+
+  // Scenario: the error of the disk manager reaches both the issuer waiting for the request and its completion.
+  std::promise<bool> completed;
+  auto completed_future = completed.get_future();
+  auto promise = disk_scheduler->CreatePromise();
+  auto future = promise.get_future();
+  disk_scheduler->Schedule({true, data, 0, std::move(promise),
+                            [&completed](bool success) { completed.set_value(success); }});
+  EXPECT_THROW(future.get(), Exception);
+  EXPECT_FALSE(completed_future.get());
+
+  // Scenario: the worker keeps serving requests after the error.
+  auto read_promise = disk_scheduler->CreatePromise();
+  auto read_future = read_promise.get_future();
+  disk_scheduler->Schedule({false, data, 0, std::move(read_promise)});
+  EXPECT_TRUE(read_future.get());
+}
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/generic_key.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, NormalizedOrderTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(16),c double");
+  GenericComparator<32> comparator(key_schema.get());
+  auto row = [](const Value &a, const std::string &b, double c) {
+    return std::vector<Value>{a, Value(TypeId::VARCHAR, b), Value(TypeId::DECIMAL, c)};
+  };
+  auto integer = [](int32_t i) { return Value(TypeId::INTEGER, i); };
+
+  // Scenario: the bytes of the keys order like their columns, with nulls first and shorter strings before longer ones.
+  std::vector<std::vector<Value>> rows{
+      row(ValueFactory::GetNullValueByType(TypeId::INTEGER), "a", 0.0),
+      row(integer(-100), "b", 0.0),
+      row(integer(-1), "", 5.0),
+      row(integer(-1), "a", -2.5),
+      row(integer(-1), "a", 3.0),
+      row(integer(-1), std::string("a\0b", 3), 0.0),
+      row(integer(-1), "ab", -1e9),
+      row(integer(0), "a", -3.0),
+      row(integer(0), "a", -2.0),
+      row(integer(0), "a", 0.0),
+      row(integer(1), "a", 0.0),
+      row(integer(70000), "a", 0.0),
+      row(integer(INT32_MAX), "a", 0.0),
+  };
+  std::vector<GenericKey<32>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], key_schema.get()), *key_schema);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      ASSERT_EQ(static_cast<int>(i > j) - static_cast<int>(i < j), comparator(keys[i], keys[j])) << i << " " << j;
+    }
+  }
+
+  // Scenario: the columns are read back from the keys.
+  EXPECT_TRUE(keys[0].ToValue(key_schema.get(), 0).IsNull());
+  for (size_t i = 1; i < rows.size(); i++) {
+    for (uint32_t col = 0; col < 3; col++) {
+      Value value = keys[i].ToValue(key_schema.get(), col);
+      EXPECT_EQ(CmpBool::CmpTrue, value.CompareEquals(rows[i][col])) << i << " " << col;
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(GenericKeyTest, TruncatedKeyTest) {
+  auto key_schema = ParseCreateStatement("a bigint,b varchar(16)");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Scenario: a test key set from an integer is the key of a bigint column.
+  GenericKey<8> key;
+  GenericKey<8> integer_key;
+  key.SetFromKey(Tuple({Value(TypeId::BIGINT, int64_t{-42}), Value(TypeId::VARCHAR, "x")}, key_schema.get()),
+                 *key_schema);
+  integer_key.SetFromInteger(-42);
+  EXPECT_EQ(0, comparator(key, integer_key));
+  EXPECT_EQ(-42, key.ToString());
+
+  // Scenario: columns that do not fit are cut off, keys that only differ there compare equal.
+  GenericKey<8> other_key;
+  other_key.SetFromKey(Tuple({Value(TypeId::BIGINT, int64_t{-42}), Value(TypeId::VARCHAR, "y")}, key_schema.get()),
+                       *key_schema);
+  EXPECT_EQ(0, comparator(key, other_key));
+  integer_key.SetFromInteger(-41);
+  EXPECT_EQ(-1, comparator(key, integer_key));
+}
+
+}  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec_test.cpp
+//
+// Identification: test/storage/page_codec_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "storage/disk/page_codec.h"
+
+namespace bustub {
+
+static void ExpectRoundTrip(const std::vector<char> &page, size_t max_compressed_size) {
+  std::vector<char> compressed(PageCodec::MaxCompressedSize(page.size()));
+  size_t size = PageCodec::Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_LT(0, size);
+  EXPECT_GE(max_compressed_size, size);
+  std::vector<char> decompressed(page.size());
+  ASSERT_TRUE(PageCodec::Decompress(compressed.data(), size, decompressed.data(), decompressed.size()));
+  EXPECT_EQ(page, decompressed);
+}
+
+// NOLINTNEXTLINE
+TEST(PageCodecTest, RoundTripTest) {
+  // Scenario: an empty page is a single long run.
+  std::vector<char> page(BUSTUB_PAGE_SIZE, 0);
+  ExpectRoundTrip(page, 64);
+
+  // Scenario: a table page full of a few repeated VARCHARs.
+  std::vector<std::string> values{"pending", "shipped", "delivered", "returned"};
+  size_t offset = 0;
+  for (size_t i = 0; offset + 16 < page.size(); ++i) {
+    const auto &value = values[i * 7 % values.size()];
+    memcpy(page.data() + offset, value.data(), value.size());
+    offset += value.size() + 4;
+  }
+  ExpectRoundTrip(page, BUSTUB_PAGE_SIZE / 4);
+
+  // Scenario: random bytes do not compress, but still round trip within the worst case size.
+  std::mt19937 gen(17);
+  for (auto &byte : page) {
+    byte = static_cast<char>(gen());
+  }
+  ExpectRoundTrip(page, PageCodec::MaxCompressedSize(page.size()));
+
+  // Scenario: random bytes do not fit into a page.
+  std::vector<char> compressed(page.size());
+  EXPECT_EQ(0, PageCodec::Compress(page.data(), page.size(), compressed.data(), compressed.size()));
+
+  // Scenario: inputs shorter than a back reference are stored as literals.
+  ExpectRoundTrip(std::vector<char>(7, 'x'), 8);
+}
+
+// NOLINTNEXTLINE
+TEST(PageCodecTest, CorruptInputTest) {
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < page.size(); ++i) {
+    page[i] = static_cast<char>(i % 13);
+  }
+  std::vector<char> compressed(PageCodec::MaxCompressedSize(page.size()));
+  size_t size = PageCodec::Compress(page.data(), page.size(), compressed.data(), compressed.size());
+  ASSERT_LT(0, size);
+  std::vector<char> decompressed(page.size());
+
+  // Scenario: truncated data, or data that decompresses to another size, is rejected.
+  EXPECT_FALSE(PageCodec::Decompress(compressed.data(), size / 2, decompressed.data(), decompressed.size()));
+  EXPECT_FALSE(PageCodec::Decompress(compressed.data(), size, decompressed.data(), decompressed.size() / 2));
+
+  // Scenario: flipping bytes never makes the codec read or write out of bounds.
+  std::mt19937 gen(3);
+  for (size_t i = 0; i < 1000; ++i) {
+    auto corrupt = compressed;
+    corrupt[gen() % size] = static_cast<char>(gen());
+    PageCodec::Decompress(corrupt.data(), size, decompressed.data(), decompressed.size());
+  }
+}
+
+}  // namespace bustub
@@ -10,9 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager.h"
 #include "storage/disk/disk_manager_memory.h"
@@ -178,5 +180,75 @@ TEST(PageGuardTest, WriteTest) {
   //  // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
 }
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticTest) {
+  const size_t buffer_pool_size = 5;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: an optimistic guard pins without latching, and stays valid until a writer latches the page.
+  {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    EXPECT_EQ(2, page0->GetPinCount());
+    auto reader = bpm->FetchPageRead(page_id_temp);
+    EXPECT_TRUE(guard.Validate());
+    reader.Drop();
+    { auto writer = bpm->FetchPageWrite(page_id_temp); }
+    EXPECT_FALSE(guard.Validate());
+  }
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // Scenario: an upgrade succeeds and keeps the pin only if the page did not change.
+  {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    auto writer = guard.UpgradeWrite();
+    ASSERT_TRUE(writer.has_value());
+    EXPECT_EQ(2, page0->GetPinCount());
+  }
+  {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    { auto writer = bpm->FetchPageWrite(page_id_temp); }
+    EXPECT_FALSE(guard.UpgradeRead().has_value());
+    EXPECT_EQ(1, page0->GetPinCount());
+    guard = bpm->FetchPageOptimistic(page_id_temp);
+    auto reader = guard.UpgradeRead();
+    ASSERT_TRUE(reader.has_value());
+    EXPECT_EQ(2, page0->GetPinCount());
+  }
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // Scenario: a reader never accepts a torn read of two counters that a writer keeps equal.
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (int64_t i = 1; i <= 20000; i++) {
+      auto guard = bpm->FetchPageWrite(page_id_temp);
+      auto *counters = guard.AsMut<int64_t>();
+      counters[0] = i;
+      counters[100] = i;
+    }
+    stop = true;
+  });
+  size_t validated = 0;
+  while (!stop || validated == 0) {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    auto *counters = guard.As<int64_t>();
+    int64_t first = counters[0];
+    int64_t second = counters[100];
+    if (guard.Validate()) {
+      EXPECT_EQ(first, second);
+      validated++;
+    }
+  }
+  writer.join();
+  EXPECT_GT(validated, 0);
+
+  disk_manager->ShutDown();
+}
 }  // namespace bustub
 // namespace bustub
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -29,40 +32,144 @@ auto ClockMs() -> uint64_t {
   return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
 }
 
-static const size_t BUSTUB_SCAN_THREAD = 8;
-static const size_t BUSTUB_GET_THREAD = 8;
-static const size_t LRU_K_SIZE = 16;
-static const size_t BUSTUB_PAGE_CNT = 6400;
-static const size_t BUSTUB_BPM_SIZE = 64;
+auto ClockNs() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/** Everything a run of the benchmark can be configured with, see main() for the command line options. */
+struct BpmBenchConfig {
+  uint64_t duration_ms_{30000};
+  uint64_t latency_ms_{0};
+  size_t scan_threads_{8};
+  size_t get_threads_{8};
+  size_t update_threads_{0};
+  size_t pages_{6400};
+  size_t frames_{64};
+  /** Skew of the page accesses of get and update threads, 0 for uniform accesses. */
+  double zipf_theta_{0.8};
+  bustub::ReplacerType replacer_type_{bustub::ReplacerType::LRUK};
+  std::string replacer_name_{"lru-k"};
+  size_t lru_k_{16};
+  size_t max_instances_{1};
+  /** Threads of the disk scheduler, more than the default of the library to keep the scan threads' reads in flight. */
+  size_t disk_workers_{16};
+  bool background_writer_{false};
+  bustub::FrameArenaOptions arena_options_;
+  uint64_t seed_{0};
+};
+
+/** The kinds of operations the threads of the benchmark issue. */
+enum class BpmOp { Scan = 0, Get, Update };
+static constexpr size_t NUM_BPM_OPS = 3;
+static constexpr std::array<const char *, NUM_BPM_OPS> BPM_OP_NAMES{"scan", "get", "update"};
+
+/**
+ * A latency histogram with log-linear buckets: every value below 2^SUB_BITS nanoseconds has a bucket, and every power
+ * of two above is split into 2^SUB_BITS buckets, so a percentile read from the histogram is off by at most
+ * 1/2^SUB_BITS.
+ */
+class LatencyHistogram {
+ public:
+  void Record(uint64_t ns) {
+    buckets_[BucketOf(ns)]++;
+    count_++;
+    sum_ns_ += ns;
+    max_ns_ = std::max(max_ns_, ns);
+  }
+
+  void Merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ns_ += other.sum_ns_;
+    max_ns_ = std::max(max_ns_, other.max_ns_);
+  }
+
+  /** @return the latency in nanoseconds that the fraction p of the operations did not exceed */
+  auto Percentile(double p) const -> uint64_t {
+    auto rank = static_cast<uint64_t>(p * static_cast<double>(count_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      seen += buckets_[i];
+      if (seen > rank) {
+        // The upper end of the bucket, as no value in it is larger.
+        return std::min(BucketStart(i + 1) - 1, max_ns_);
+      }
+    }
+    return max_ns_;
+  }
+
+  auto Count() const -> uint64_t { return count_; }
+  auto MeanNs() const -> double { return count_ == 0 ? 0 : static_cast<double>(sum_ns_) / count_; }
+  auto MaxNs() const -> uint64_t { return max_ns_; }
+
+ private:
+  static constexpr size_t SUB_BITS = 5;
+  static constexpr size_t SUB_BUCKETS = 1 << SUB_BITS;
+  static constexpr size_t NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  static auto BucketOf(uint64_t value) -> size_t {
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+    size_t shift = 63 - __builtin_clzll(value) - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  static auto BucketStart(size_t bucket) -> uint64_t {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+    size_t shift = bucket / SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  }
+
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_ns_{0};
+  uint64_t max_ns_{0};
+};
 
 struct BpmTotalMetrics {
-  uint64_t scan_cnt_{0};
-  uint64_t get_cnt_{0};
+  std::array<LatencyHistogram, NUM_BPM_OPS> latencies_;
+  uint64_t fetch_failures_{0};
   uint64_t start_time_{0};
+  uint64_t elapsed_ms_{0};
   std::mutex mutex_;
 
   void Begin() { start_time_ = ClockMs(); }
 
-  void ReportScan(uint64_t scan_cnt) {
+  void ReportThread(BpmOp op, const LatencyHistogram &latencies, uint64_t fetch_failures) {
     std::unique_lock<std::mutex> l(mutex_);
-    scan_cnt_ += scan_cnt;
+    latencies_[static_cast<size_t>(op)].Merge(latencies);
+    fetch_failures_ += fetch_failures;
   }
 
-  void ReportGet(uint64_t get_cnt) {
-    std::unique_lock<std::mutex> l(mutex_);
-    get_cnt_ += get_cnt;
+  auto PerSec(BpmOp op) const -> double {
+    return latencies_[static_cast<size_t>(op)].Count() / static_cast<double>(elapsed_ms_) * 1000;
   }
 
   void Report() {
-    auto now = ClockMs();
-    auto elsped = now - start_time_;
-    auto scan_per_sec = scan_cnt_ / static_cast<double>(elsped) * 1000;
-    auto get_per_sec = get_cnt_ / static_cast<double>(elsped) * 1000;
+    elapsed_ms_ = std::max<uint64_t>(ClockMs() - start_time_, 1);
 
     fmt::print("<<< BEGIN\n");
-    fmt::print("scan: {}\n", scan_per_sec);
-    fmt::print("get: {}\n", get_per_sec);
+    fmt::print("scan: {}\n", PerSec(BpmOp::Scan));
+    fmt::print("get: {}\n", PerSec(BpmOp::Get));
+    fmt::print("update: {}\n", PerSec(BpmOp::Update));
     fmt::print(">>> END\n");
+
+    fmt::print("<<< LATENCY\n");
+    fmt::print("{:>8} {:>12} {:>10} {:>10} {:>10} {:>10} {:>12}\n", "op", "count", "mean_ns", "p50_ns", "p99_ns",
+               "p999_ns", "max_ns");
+    for (size_t i = 0; i < NUM_BPM_OPS; i++) {
+      const auto &latencies = latencies_[i];
+      fmt::print("{:>8} {:>12} {:>10.0f} {:>10} {:>10} {:>10} {:>12}\n", BPM_OP_NAMES[i], latencies.Count(),
+                 latencies.MeanNs(), latencies.Percentile(0.5), latencies.Percentile(0.99),
+                 latencies.Percentile(0.999), latencies.MaxNs());
+    }
+    fmt::print(">>> LATENCY\n");
   }
 };
 
@@ -71,13 +178,19 @@ struct BpmMetrics {
   uint64_t last_report_at_{0};
   uint64_t last_cnt_{0};
   uint64_t cnt_{0};
+  uint64_t fetch_failures_{0};
+  LatencyHistogram latencies_;
   std::string reporter_;
   uint64_t duration_ms_;
 
   explicit BpmMetrics(std::string reporter, uint64_t duration_ms)
       : reporter_(std::move(reporter)), duration_ms_(duration_ms) {}
 
-  void Tick() { cnt_ += 1; }
+  /** Count an operation that started at start_ns, the result of ClockNs(). */
+  void Tick(uint64_t start_ns) {
+    latencies_.Record(ClockNs() - start_ns);
+    cnt_ += 1;
+  }
 
   void Begin() { start_time_ = ClockMs(); }
 
@@ -100,43 +213,89 @@ struct BpmMetrics {
   }
 };
 
-// NOLINTNEXTLINE
-auto main(int argc, char **argv) -> int {
-  using bustub::AccessType;
-  using bustub::BufferPoolManager;
-  using bustub::DiskManagerUnlimitedMemory;
-  using bustub::page_id_t;
-
-  argparse::ArgumentParser program("bustub-bpm-bench");
-  program.add_argument("--duration").help("run bpm bench for n milliseconds");
-  program.add_argument("--latency").help("set disk latency to n milliseconds");
+/** Draws the page indexes of get and update threads, zipfian or uniform. */
+class PageDistribution {
+ public:
+  PageDistribution(size_t pages, double theta) : uniform_(0, pages - 1) {
+    if (theta > 0) {
+      // Computing the zeta constant is linear in the number of pages, so it is done once and shared by all threads.
+      zipf_ = std::make_unique<zipfian_int_distribution<size_t>::param_type>(0, pages - 1, theta);
+    }
+  }
 
-  try {
-    program.parse_args(argc, argv);
-  } catch (const std::runtime_error &err) {
-    std::cerr << err.what() << std::endl;
-    std::cerr << program;
-    return 1;
+  template <class Generator>
+  auto operator()(Generator &gen) const -> size_t {
+    if (zipf_ == nullptr) {
+      auto uniform = uniform_;
+      return uniform(gen);
+    }
+    zipfian_int_distribution<size_t> dist(*zipf_);
+    return dist(gen);
   }
 
-  uint64_t duration_ms = 30000;
-  if (program.present("--duration")) {
-    duration_ms = std::stoi(program.get("--duration"));
+ private:
+  std::uniform_int_distribution<size_t> uniform_;
+  std::unique_ptr<zipfian_int_distribution<size_t>::param_type> zipf_;
+};
+
+struct BpmBenchResult {
+  size_t instances_;
+  std::array<double, NUM_BPM_OPS> per_sec_;
+  std::array<LatencyHistogram, NUM_BPM_OPS> latencies_;
+  uint64_t fetch_failures_;
+  std::vector<std::pair<std::string, std::string>> stats_;
+};
+
+/** Fetch a page for an operation, and touch it the way the operation does. */
+static auto RunOp(bustub::BufferPoolManager *bpm, bustub::page_id_t page_id, size_t page_idx, BpmOp op) -> bool {
+  using bustub::AccessType;
+  auto access_type = op == BpmOp::Scan ? AccessType::Scan : AccessType::Get;
+  auto *page = bpm->FetchPage(page_id, access_type);
+  if (page == nullptr) {
+    return false;
   }
 
-  uint64_t latency_ms = 0;
-  if (program.present("--latency")) {
-    latency_ms = std::stoi(program.get("--latency"));
+  char &ch = page->GetData()[page_idx % 1024];
+  if (op == BpmOp::Get) {
+    page->RLatch();
+    char value = ch;
+    page->RUnlatch();
+    if (value == 0) {
+      throw std::runtime_error("invalid data");
+    }
+  } else {
+    page->WLatch();
+    ch += 1;
+    if (ch == 0) {
+      ch = 1;
+    }
+    page->WUnlatch();
   }
 
+  bpm->UnpinPage(page->GetPageId(), op != BpmOp::Get, access_type);
+  return true;
+}
+
+auto RunBench(const BpmBenchConfig &config, size_t instances) -> BpmBenchResult {
+  using bustub::BufferPoolManager;
+  using bustub::DiskManagerUnlimitedMemory;
+  using bustub::page_id_t;
+
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  auto bpm = std::make_unique<BufferPoolManager>(config.frames_, disk_manager.get(), config.lru_k_, nullptr, instances,
+                                                 config.replacer_type_, config.arena_options_, config.disk_workers_);
   std::vector<page_id_t> page_ids;
 
-  fmt::print(stderr, "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}\n",
-             BUSTUB_PAGE_CNT, duration_ms, latency_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] total_page={}, duration_ms={}, latency_ms={}, scan_threads={}, get_threads={}, "
+             "update_threads={}, zipf_theta={}, replacer={}, lru_k_size={}, bpm_size={}, instances={}, "
+             "disk_workers={}, background_writer={}, huge_tlb={}, numa_policy={}\n",
+             config.pages_, config.duration_ms_, config.latency_ms_, config.scan_threads_, config.get_threads_,
+             config.update_threads_, config.zipf_theta_, config.replacer_name_, config.lru_k_, config.frames_,
+             instances, config.disk_workers_, config.background_writer_, bpm->GetFrameArena().UsesHugeTlb(),
+             static_cast<int>(bpm->GetFrameArena().GetNumaPolicy()));
 
-  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
+  for (size_t i = 0; i < config.pages_; i++) {
     page_id_t page_id;
     auto *page = bpm->NewPage(&page_id);
     if (page == nullptr) {
@@ -149,8 +308,13 @@ auto main(int argc, char **argv) -> int {
     page_ids.push_back(page_id);
   }
 
-  // enable disk latency after creating all pages
-  disk_manager->SetLatency(latency_ms);
+  // enable disk latency after creating all pages, and only count what happens during the benchmark
+  disk_manager->SetLatency(config.latency_ms_);
+  bpm->ResetStats();
+  if (config.background_writer_) {
+    bpm->StartBackgroundWriter();
+  }
+  PageDistribution page_dist(config.pages_, config.zipf_theta_);
 
   fmt::print(stderr, "[info] benchmark start\n");
 
@@ -159,74 +323,235 @@ auto main(int argc, char **argv) -> int {
 
   std::vector<std::thread> threads;
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_SCAN_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
-      BpmMetrics metrics(fmt::format("scan {:>2}", thread_id), duration_ms);
+  for (size_t thread_id = 0; thread_id < config.scan_threads_; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &config, &page_ids, &bpm, &total_metrics] {
+      BpmMetrics metrics(fmt::format("scan   {:>2}", thread_id), config.duration_ms_);
       metrics.Begin();
 
-      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / BUSTUB_SCAN_THREAD;
+      size_t page_idx = config.pages_ * thread_id / config.scan_threads_;
 
       while (!metrics.ShouldFinish()) {
-        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Scan);
-        if (page == nullptr) {
+        auto start_ns = ClockNs();
+        if (!RunOp(bpm.get(), page_ids[page_idx], page_idx, BpmOp::Scan)) {
+          metrics.fetch_failures_++;
           continue;
         }
-
-        char &ch = page->GetData()[page_idx % 1024];
-        page->WLatch();
-        ch += 1;
-        if (ch == 0) {
-          ch = 1;
-        }
-        page->WUnlatch();
-
-        bpm->UnpinPage(page->GetPageId(), true, AccessType::Scan);
-        page_idx = (page_idx + 1) % BUSTUB_PAGE_CNT;
-        metrics.Tick();
+        page_idx = (page_idx + 1) % config.pages_;
+        metrics.Tick(start_ns);
         metrics.Report();
       }
 
-      total_metrics.ReportScan(metrics.cnt_);
+      total_metrics.ReportThread(BpmOp::Scan, metrics.latencies_, metrics.fetch_failures_);
     }));
   }
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
-      std::random_device r;
-      std::default_random_engine gen(r());
-      zipfian_int_distribution<size_t> dist(0, BUSTUB_PAGE_CNT - 1, 0.8);
-
-      BpmMetrics metrics(fmt::format("get  {:>2}", thread_id), duration_ms);
-      metrics.Begin();
-
-      while (!metrics.ShouldFinish()) {
-        auto page_idx = dist(gen);
-        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
-        if (page == nullptr) {
-          continue;
-        }
-
-        page->RLatch();
-        char ch = page->GetData()[page_idx % 1024];
-        page->RUnlatch();
-        if (ch == 0) {
-          throw std::runtime_error("invalid data");
+  for (auto op : {BpmOp::Get, BpmOp::Update}) {
+    size_t num_threads = op == BpmOp::Get ? config.get_threads_ : config.update_threads_;
+    for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+      threads.emplace_back(std::thread([thread_id, op, &config, &page_ids, &bpm, &page_dist, &total_metrics] {
+        std::default_random_engine gen(config.seed_ == 0 ? std::random_device()()
+                                                         : config.seed_ + thread_id * NUM_BPM_OPS +
+                                                               static_cast<size_t>(op));
+
+        BpmMetrics metrics(fmt::format("{:<6} {:>2}", BPM_OP_NAMES[static_cast<size_t>(op)], thread_id),
+                           config.duration_ms_);
+        metrics.Begin();
+
+        while (!metrics.ShouldFinish()) {
+          auto page_idx = page_dist(gen);
+          auto start_ns = ClockNs();
+          if (!RunOp(bpm.get(), page_ids[page_idx], page_idx, op)) {
+            metrics.fetch_failures_++;
+            continue;
+          }
+          metrics.Tick(start_ns);
+          metrics.Report();
         }
 
-        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
-        metrics.Tick();
-        metrics.Report();
-      }
-
-      total_metrics.ReportGet(metrics.cnt_);
-    }));
+        total_metrics.ReportThread(op, metrics.latencies_, metrics.fetch_failures_);
+      }));
+    }
   }
 
   for (auto &thread : threads) {
     thread.join();
   }
+  bpm->StopBackgroundWriter();
 
   total_metrics.Report();
 
+  BpmBenchResult result{instances, {}, total_metrics.latencies_, total_metrics.fetch_failures_,
+                        bpm->GetStats().ToItems()};
+  for (size_t i = 0; i < NUM_BPM_OPS; i++) {
+    result.per_sec_[i] = total_metrics.PerSec(static_cast<BpmOp>(i));
+  }
+
+  fmt::print("<<< BPM STATS\n");
+  fmt::print("fetch_failures: {}\n", result.fetch_failures_);
+  for (const auto &[name, value] : result.stats_) {
+    fmt::print("{}: {}\n", name, value);
+  }
+  fmt::print(">>> BPM STATS\n");
+
+  return result;
+}
+
+/** @return the configuration and the results of all runs as a JSON document, for tracking regressions across builds */
+auto ToJson(const BpmBenchConfig &config, const std::vector<BpmBenchResult> &results) -> std::string {
+  std::ostringstream out;
+  out << fmt::format(
+      "{{\n  \"config\": {{\"duration_ms\": {}, \"latency_ms\": {}, \"scan_threads\": {}, \"get_threads\": {}, "
+      "\"update_threads\": {}, \"pages\": {}, \"frames\": {}, \"zipf_theta\": {}, \"replacer\": \"{}\", "
+      "\"lru_k\": {}, \"disk_workers\": {}, \"background_writer\": {}, \"huge_pages\": {}}},\n  \"runs\": [",
+      config.duration_ms_, config.latency_ms_, config.scan_threads_, config.get_threads_, config.update_threads_,
+      config.pages_, config.frames_, config.zipf_theta_, config.replacer_name_, config.lru_k_, config.disk_workers_,
+      config.background_writer_, config.arena_options_.huge_pages_);
+  for (size_t run = 0; run < results.size(); run++) {
+    const auto &result = results[run];
+    out << fmt::format("{}\n    {{\"instances\": {}, \"fetch_failures\": {}, \"ops\": {{", run == 0 ? "" : ",",
+                       result.instances_, result.fetch_failures_);
+    for (size_t i = 0; i < NUM_BPM_OPS; i++) {
+      const auto &latencies = result.latencies_[i];
+      out << fmt::format(
+          "{}\n      \"{}\": {{\"count\": {}, \"per_sec\": {:.3f}, \"mean_ns\": {:.1f}, \"p50_ns\": {}, "
+          "\"p99_ns\": {}, \"p999_ns\": {}, \"max_ns\": {}}}",
+          i == 0 ? "" : ",", BPM_OP_NAMES[i], latencies.Count(), result.per_sec_[i], latencies.MeanNs(),
+          latencies.Percentile(0.5), latencies.Percentile(0.99), latencies.Percentile(0.999), latencies.MaxNs());
+    }
+    out << "},\n      \"stats\": {";
+    for (size_t i = 0; i < result.stats_.size(); i++) {
+      // Every statistic is a number.
+      out << fmt::format("{}\"{}\": {}", i == 0 ? "" : ", ", result.stats_[i].first, result.stats_[i].second);
+    }
+    out << "}}";
+  }
+  out << "\n  ]\n}\n";
+  return out.str();
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run bpm bench for n milliseconds");
+  program.add_argument("--latency").help("set disk latency to n milliseconds");
+  program.add_argument("--scan-threads").help("number of threads scanning all pages in order (default 8)");
+  program.add_argument("--get-threads").help("number of threads reading random pages (default 8)");
+  program.add_argument("--update-threads").help("number of threads modifying random pages (default 0)");
+  program.add_argument("--pages").help("number of pages in the database (default 6400)");
+  program.add_argument("--frames").help("number of frames of the buffer pool (default 64)");
+  program.add_argument("--zipf").help("skew of the random page accesses in [0, 1), 0 for uniform (default 0.8)");
+  program.add_argument("--replacer").help("replacement policy: lru-k, lru, clock or clock-pro (default lru-k)");
+  program.add_argument("--lru-k").help("lookback window of the lru-k replacer (default 16)");
+  program.add_argument("--seed").help("seed the random page accesses, so that runs draw the same pages");
+  program.add_argument("--instances").help("run bpm bench with 1..n buffer pool instances");
+  program.add_argument("--disk-workers").help("number of threads of the disk scheduler (default 16)");
+  program.add_argument("--json").help("write the configuration and the results as JSON to a file, - for stdout");
+  program.add_argument("--background-writer")
+      .help("run the background writer of the buffer pool")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--huge-pages")
+      .help("back the frames of the buffer pool with huge pages")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--numa").help("place the frames on NUMA nodes: interleave, or the node to bind them to");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  BpmBenchConfig config;
+  auto get_size = [&program](const std::string &name, auto *value) {
+    if (program.present(name)) {
+      *value = std::stoull(program.get(name));
+    }
+  };
+  get_size("--duration", &config.duration_ms_);
+  get_size("--latency", &config.latency_ms_);
+  get_size("--scan-threads", &config.scan_threads_);
+  get_size("--get-threads", &config.get_threads_);
+  get_size("--update-threads", &config.update_threads_);
+  get_size("--pages", &config.pages_);
+  get_size("--frames", &config.frames_);
+  get_size("--lru-k", &config.lru_k_);
+  get_size("--seed", &config.seed_);
+  get_size("--instances", &config.max_instances_);
+  get_size("--disk-workers", &config.disk_workers_);
+  if (program.present("--zipf")) {
+    config.zipf_theta_ = std::stod(program.get("--zipf"));
+  }
+  if (config.pages_ == 0 || config.disk_workers_ == 0 || config.zipf_theta_ < 0 || config.zipf_theta_ >= 1) {
+    std::cerr << "--pages and --disk-workers must be positive and --zipf in [0, 1)" << std::endl;
+    return 1;
+  }
+
+  if (program.present("--replacer")) {
+    config.replacer_name_ = program.get("--replacer");
+    if (config.replacer_name_ == "lru-k") {
+      config.replacer_type_ = bustub::ReplacerType::LRUK;
+    } else if (config.replacer_name_ == "lru") {
+      config.replacer_type_ = bustub::ReplacerType::LRU;
+    } else if (config.replacer_name_ == "clock") {
+      config.replacer_type_ = bustub::ReplacerType::Clock;
+    } else if (config.replacer_name_ == "clock-pro") {
+      config.replacer_type_ = bustub::ReplacerType::ClockPro;
+    } else {
+      std::cerr << "unknown replacer " << config.replacer_name_ << std::endl;
+      return 1;
+    }
+  }
+
+  config.background_writer_ = program.get<bool>("--background-writer");
+
+  config.arena_options_.huge_pages_ = program.get<bool>("--huge-pages");
+  if (program.present("--numa")) {
+    auto numa = program.get("--numa");
+    if (numa == "interleave") {
+      config.arena_options_.numa_policy_ = bustub::NumaPolicy::Interleave;
+    } else {
+      config.arena_options_.numa_policy_ = bustub::NumaPolicy::Bind;
+      config.arena_options_.numa_node_ = std::stoi(numa);
+    }
+  }
+
+  // Run with 1, 2, 4, ... instances (and finally with max_instances) to report the scaling curve.
+  std::vector<BpmBenchResult> results;
+  for (size_t instances = 1; instances <= config.max_instances_; instances *= 2) {
+    results.push_back(RunBench(config, instances));
+    if (instances < config.max_instances_ && instances * 2 > config.max_instances_) {
+      results.push_back(RunBench(config, config.max_instances_));
+    }
+  }
+
+  if (results.size() > 1) {
+    fmt::print("<<< SCALING\n");
+    fmt::print("{:>10} {:>15} {:>15} {:>15}\n", "instances", "scan/s", "get/s", "update/s");
+    for (const auto &result : results) {
+      fmt::print("{:>10} {:>15.3f} {:>15.3f} {:>15.3f}\n", result.instances_, result.per_sec_[0], result.per_sec_[1],
+                 result.per_sec_[2]);
+    }
+    fmt::print(">>> SCALING\n");
+  }
+
+  if (program.present("--json")) {
+    auto json = ToJson(config, results);
+    auto path = program.get("--json");
+    if (path == "-") {
+      fmt::print("{}", json);
+    } else {
+      FILE *file = fopen(path.c_str(), "w");
+      if (file == nullptr) {
+        std::cerr << "can't open " << path << std::endl;
+        return 1;
+      }
+      fmt::print(file, "{}", json);
+      fclose(file);
+    }
+  }
+
   return 0;
 }
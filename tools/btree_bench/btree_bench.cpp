@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <cpp_random_distributions/zipfian_int_distribution.h>
@@ -57,7 +58,8 @@ struct BTreeTotalMetrics {
     read_cnt_ += get_cnt;
   }
 
-  void Report() {
+  /** @return the write and read throughput per second */
+  auto Report() -> std::pair<double, double> {
     auto now = ClockMs();
     auto elsped = now - start_time_;
     auto write_per_sec = write_cnt_ / static_cast<double>(elsped) * 1000;
@@ -67,6 +69,7 @@ struct BTreeTotalMetrics {
     fmt::print("write: {}\n", write_per_sec);
     fmt::print("read: {}\n", read_per_sec);
     fmt::print(">>> END\n");
+    return {write_per_sec, read_per_sec};
   }
 };
 
@@ -110,43 +113,34 @@ auto KeyWillVanish(size_t key) -> bool { return key % 7 == 0; }
 // These keys will be overwritten to a new value
 auto KeyWillChange(size_t key) -> bool { return key % 5 == 0; }
 
-// NOLINTNEXTLINE
-auto main(int argc, char **argv) -> int {
-  using bustub::AccessType;
+/** @brief Run the benchmark on pages of page_size bytes. @return the write and read throughput per second */
+auto RunBench(size_t page_size, uint64_t duration_ms) -> std::pair<double, double> {
+  using bustub::BPlusTree;
   using bustub::BufferPoolManager;
   using bustub::DiskManagerUnlimitedMemory;
+  using bustub::GenericComparator;
+  using bustub::GenericKey;
   using bustub::page_id_t;
+  using bustub::RID;
 
-  argparse::ArgumentParser program("bustub-btree-bench");
-  program.add_argument("--duration").help("run btree bench for n milliseconds");
-
-  try {
-    program.parse_args(argc, argv);
-  } catch (const std::runtime_error &err) {
-    std::cerr << err.what() << std::endl;
-    std::cerr << program;
-    return 1;
-  }
-
-  uint64_t duration_ms = 30000;
-  if (program.present("--duration")) {
-    duration_ms = std::stoi(program.get("--duration"));
-  }
-
-  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>(page_size);
   auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
 
-  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS, duration_ms,
-             LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}, page_size={}\n", TOTAL_KEYS,
+             duration_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE, page_size);
 
   auto key_schema = bustub::ParseCreateStatement("a bigint");
-  bustub::GenericComparator<8> comparator(key_schema.get());
+  GenericComparator<8> comparator(key_schema.get());
 
   page_id_t page_id;
   auto header_page = bpm->NewPageGuarded(&page_id);
 
-  bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>> index("foo_pk", page_id,
-                                                                                            bpm.get(), comparator);
+  // Fill the pages completely, the fanout grows with the page size.
+  auto leaf_max_size = static_cast<int>((page_size - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, RID>));
+  auto internal_max_size =
+      static_cast<int>((page_size - bustub::INTERNAL_PAGE_HEADER_SIZE) / bustub::INTERNAL_PAGE_SLOT_SIZE);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> index("foo_pk", page_id, bpm.get(), comparator, leaf_max_size,
+                                                            internal_max_size);
 
   for (size_t key = 0; key < TOTAL_KEYS; key++) {
     bustub::GenericKey<8> index_key;
@@ -261,7 +255,49 @@ auto main(int argc, char **argv) -> int {
     thread.join();
   }
 
-  total_metrics.Report();
+  return total_metrics.Report();
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-btree-bench");
+  program.add_argument("--duration").help("run btree bench for n milliseconds");
+  program.add_argument("--page-sizes").help("comma separated page sizes to sweep over, e.g. 4096,16384,32768");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 30000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  std::vector<size_t> page_sizes{bustub::BUSTUB_PAGE_SIZE};
+  if (program.present("--page-sizes")) {
+    page_sizes.clear();
+    std::stringstream list(program.get("--page-sizes"));
+    std::string page_size;
+    while (std::getline(list, page_size, ',')) {
+      page_sizes.push_back(std::stoul(page_size));
+    }
+  }
+
+  std::vector<std::pair<double, double>> results;
+  for (auto page_size : page_sizes) {
+    results.push_back(RunBench(page_size, duration_ms));
+  }
+
+  if (page_sizes.size() > 1) {
+    fmt::print("{:>10} {:>14} {:>14}\n", "page_size", "write/s", "read/s");
+    for (size_t i = 0; i < page_sizes.size(); i++) {
+      fmt::print("{:>10} {:>14.0f} {:>14.0f}\n", page_sizes[i], results[i].first, results[i].second);
+    }
+  }
 
   return 0;
 }
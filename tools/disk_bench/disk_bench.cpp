@@ -0,0 +1,191 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_mmap.h"
+#include "storage/disk/disk_manager_posix.h"
+#include "storage/disk/disk_manager_uring.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const char *BENCH_DB_FILE = "disk-bench.db";
+
+struct DiskBenchResult {
+  std::string backend_;
+  double read_per_sec_;
+  double write_per_sec_;
+};
+
+/** @return the disk manager of a backend, an io_uring one with a ring for each of `threads` threads */
+auto MakeDiskManager(const std::string &backend, size_t threads) -> std::unique_ptr<bustub::DiskManager> {
+  if (backend == "fstream") {
+    return std::make_unique<bustub::DiskManager>(BENCH_DB_FILE);
+  }
+  if (backend == "posix") {
+    return std::make_unique<bustub::DiskManagerPosix>(BENCH_DB_FILE, false);
+  }
+  if (backend == "direct") {
+    return std::make_unique<bustub::DiskManagerPosix>(BENCH_DB_FILE, true);
+  }
+  if (backend == "mmap") {
+    return std::make_unique<bustub::DiskManagerMmap>(BENCH_DB_FILE);
+  }
+  if (backend == "compressed") {
+    return std::make_unique<bustub::DiskManagerCompressed>(BENCH_DB_FILE);
+  }
+  if (backend == "uring") {
+    return std::make_unique<bustub::DiskManagerUring>(BENCH_DB_FILE, false, bustub::DISK_SYNC_INTERVAL, threads);
+  }
+  if (backend == "uring-direct") {
+    return std::make_unique<bustub::DiskManagerUring>(BENCH_DB_FILE, true, bustub::DISK_SYNC_INTERVAL, threads);
+  }
+  throw std::runtime_error("unknown backend " + backend);
+}
+
+/**
+ * Read and write random pages of a file with `pages` pages from `threads` threads. Every thread issues batches of
+ * `batch_size` requests from aligned buffers, like buffer pool frames.
+ */
+auto RunBench(const std::string &backend, size_t threads, size_t pages, size_t write_percent, size_t batch_size,
+              uint64_t duration_ms) -> DiskBenchResult {
+  remove(BENCH_DB_FILE);
+  auto disk_manager = MakeDiskManager(backend, threads);
+  std::vector<char> data(bustub::BUSTUB_PAGE_SIZE, 1);
+  for (size_t i = 0; i < pages; i++) {
+    disk_manager->WritePage(static_cast<bustub::page_id_t>(i), data.data());
+  }
+
+  std::atomic<uint64_t> read_cnt{0};
+  std::atomic<uint64_t> write_cnt{0};
+  std::vector<std::thread> workers;
+  auto start_time = ClockMs();
+  for (size_t thread_id = 0; thread_id < threads; thread_id++) {
+    workers.emplace_back([&, thread_id] {
+      std::vector<char *> buffers;
+      for (size_t i = 0; i < batch_size; i++) {
+        buffers.push_back(new (std::align_val_t(bustub::BUSTUB_PAGE_ALIGNMENT)) char[bustub::BUSTUB_PAGE_SIZE]);
+      }
+      std::default_random_engine gen(thread_id);
+      std::uniform_int_distribution<bustub::page_id_t> page_dist(0, static_cast<bustub::page_id_t>(pages - 1));
+      std::uniform_int_distribution<size_t> percent_dist(0, 99);
+      uint64_t reads = 0;
+      uint64_t writes = 0;
+      std::vector<bustub::DiskIo> batch;
+      while (ClockMs() - start_time < duration_ms) {
+        for (size_t i = 0; i < 16; i++) {
+          batch.clear();
+          for (auto *buffer : buffers) {
+            bool is_write = percent_dist(gen) < write_percent;
+            batch.push_back({is_write, page_dist(gen), buffer});
+            is_write ? writes++ : reads++;
+          }
+          if (batch_size == 1) {
+            batch[0].is_write_ ? disk_manager->WritePage(batch[0].page_id_, batch[0].data_)
+                               : disk_manager->ReadPage(batch[0].page_id_, batch[0].data_);
+          } else {
+            disk_manager->ExecuteBatch(batch);
+          }
+        }
+      }
+      read_cnt += reads;
+      write_cnt += writes;
+      for (auto *buffer : buffers) {
+        ::operator delete[](buffer, std::align_val_t(bustub::BUSTUB_PAGE_ALIGNMENT));
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto elapsed = ClockMs() - start_time;
+  disk_manager->ShutDown();
+  remove(BENCH_DB_FILE);
+  remove("disk-bench.log");
+
+  return {backend, read_cnt / static_cast<double>(elapsed) * 1000, write_cnt / static_cast<double>(elapsed) * 1000};
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-disk-bench");
+  program.add_argument("--duration").help("run each backend for n milliseconds");
+  program.add_argument("--threads").help("number of threads issuing requests");
+  program.add_argument("--pages").help("number of pages in the database file");
+  program.add_argument("--write-percent").help("percentage of requests that are writes");
+  program.add_argument("--batch").help("number of requests a thread hands to the disk manager at once");
+  program.add_argument("--backend")
+      .help("only run one backend: fstream, posix, direct, mmap, compressed, uring or uring-direct");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 5000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  size_t threads = 8;
+  if (program.present("--threads")) {
+    threads = std::stoi(program.get("--threads"));
+  }
+
+  size_t pages = 16384;
+  if (program.present("--pages")) {
+    pages = std::stoi(program.get("--pages"));
+  }
+
+  size_t write_percent = 20;
+  if (program.present("--write-percent")) {
+    write_percent = std::stoi(program.get("--write-percent"));
+  }
+
+  size_t batch_size = 1;
+  if (program.present("--batch")) {
+    batch_size = std::stoi(program.get("--batch"));
+  }
+
+  std::vector<std::string> backends{"fstream", "posix", "direct", "mmap", "compressed", "uring", "uring-direct"};
+  if (program.present("--backend")) {
+    backends = {program.get("--backend")};
+  }
+
+  fmt::print(stderr, "[info] duration_ms={}, threads={}, pages={}, write_percent={}, batch={}\n", duration_ms, threads,
+             pages, write_percent, batch_size);
+
+  std::vector<DiskBenchResult> results;
+  for (const auto &backend : backends) {
+    results.push_back(RunBench(backend, threads, pages, write_percent, batch_size, duration_ms));
+  }
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>15} {:>15}\n", "backend", "read/s", "write/s");
+  for (const auto &result : results) {
+    fmt::print("{:>10} {:>15.3f} {:>15.3f}\n", result.backend_, result.read_per_sec_, result.write_per_sec_);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "common/rid.h"
+#include "fmt/core.h"
+#include "storage/page/b_plus_tree_key_search.h"
+#include "test_util.h"  // NOLINT
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+using KeyType = bustub::GenericKey<8>;
+using Comparator = bustub::GenericComparator<8>;
+
+struct KeySearchBenchResult {
+  int node_size_;
+  double binary_per_sec_;
+  double integer_per_sec_;
+};
+
+/**
+ * Search a sorted leaf of `node_size` keys for random keys, half of them in the leaf, for `duration_ms` with the
+ * binary search through the comparator and as long again with the integer search of GenericKey<8> pages.
+ */
+auto RunBench(int node_size, const Comparator &comparator, uint64_t duration_ms) -> KeySearchBenchResult {
+  std::vector<std::pair<KeyType, bustub::RID>> pairs(node_size);
+  for (int i = 0; i < node_size; i++) {
+    pairs[i].first.SetFromInteger(2 * i);
+  }
+  std::default_random_engine gen(node_size);
+  std::uniform_int_distribution<int64_t> key_dist(-1, 2 * node_size);
+  std::vector<KeyType> targets(4096);
+  for (auto &target : targets) {
+    target.SetFromInteger(key_dist(gen));
+  }
+
+  auto run = [&](auto search) {
+    uint64_t lookups = 0;
+    uint64_t checksum = 0;
+    auto start_time = ClockMs();
+    while (ClockMs() - start_time < duration_ms) {
+      for (const auto &target : targets) {
+        checksum += search(target);
+      }
+      lookups += targets.size();
+    }
+    auto elapsed = ClockMs() - start_time;
+    // Keep the searches from being optimized away.
+    if (checksum == 0) {
+      fmt::print(stderr, "[info] checksum=0\n");
+    }
+    return lookups / static_cast<double>(elapsed) * 1000;
+  };
+  double binary_per_sec = run([&](const KeyType &key) {
+    return bustub::BinarySearchPairs(pairs.data(), node_size, key, comparator, false);
+  });
+  double integer_per_sec =
+      run([&](const KeyType &key) { return bustub::SearchPairs(pairs.data(), node_size, key, comparator, false); });
+  return {node_size, binary_per_sec, integer_per_sec};
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-key-search-bench");
+  program.add_argument("--duration").help("run each search on each node size for n milliseconds");
+  program.add_argument("--node-size").help("only run one node size");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 1000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  // Small nodes, then full leaves of 4 KB to 32 KB pages.
+  std::vector<int> node_sizes{16, 32, 64, 128};
+  for (int page_size = 4096; page_size <= 32768; page_size *= 2) {
+    node_sizes.push_back((page_size - 16) / static_cast<int>(sizeof(std::pair<KeyType, bustub::RID>)));
+  }
+  if (program.present("--node-size")) {
+    node_sizes = {std::stoi(program.get("--node-size"))};
+  }
+
+#if defined(__AVX2__)
+  const char *block_scan = "avx2";
+#else
+  const char *block_scan = "scalar";
+#endif
+  fmt::print(stderr, "[info] duration_ms={}, block_scan={}\n", duration_ms, block_scan);
+
+  auto key_schema = bustub::ParseCreateStatement("a bigint");
+  Comparator comparator(key_schema.get());
+  std::vector<KeySearchBenchResult> results;
+  for (int node_size : node_sizes) {
+    results.push_back(RunBench(node_size, comparator, duration_ms));
+  }
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>15} {:>15} {:>10}\n", "node_size", "binary/s", "integer/s", "speedup");
+  for (const auto &result : results) {
+    fmt::print("{:>10} {:>15.0f} {:>15.0f} {:>10.2f}\n", result.node_size_, result.binary_per_sec_,
+               result.integer_per_sec_, result.integer_per_sec_ / result.binary_per_sec_);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/lru_k_replacer.h"
+#include "common/config.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t LRU_K_SIZE = 16;
+static const size_t HITS_PER_MISS = 8;
+
+struct ReplacerBenchResult {
+  size_t frames_;
+  double miss_per_sec_;
+  double access_per_sec_;
+};
+
+/**
+ * Simulate the replacer calls of a buffer pool under a uniform workload: every miss evicts a victim and loads a new
+ * page into it, and every miss is followed by HITS_PER_MISS hits on random resident frames.
+ */
+auto RunBench(size_t frames, uint64_t duration_ms) -> ReplacerBenchResult {
+  using bustub::frame_id_t;
+  using bustub::LRUKReplacer;
+
+  LRUKReplacer replacer(frames, LRU_K_SIZE);
+  for (size_t i = 0; i < frames; i++) {
+    replacer.RecordAccess(static_cast<frame_id_t>(i));
+    replacer.SetEvictable(static_cast<frame_id_t>(i), true);
+  }
+
+  std::default_random_engine gen(frames);
+  std::uniform_int_distribution<frame_id_t> dist(0, static_cast<frame_id_t>(frames - 1));
+
+  uint64_t miss_cnt = 0;
+  uint64_t access_cnt = 0;
+  auto start_time = ClockMs();
+  while (ClockMs() - start_time < duration_ms) {
+    for (size_t i = 0; i < 64; i++) {
+      frame_id_t victim;
+      if (!replacer.Evict(&victim)) {
+        throw std::runtime_error("evict failed");
+      }
+      replacer.RecordAccess(victim);
+      replacer.SetEvictable(victim, true);
+      miss_cnt++;
+
+      for (size_t j = 0; j < HITS_PER_MISS; j++) {
+        auto fid = dist(gen);
+        replacer.RecordAccess(fid);
+        replacer.SetEvictable(fid, false);
+        replacer.SetEvictable(fid, true);
+        access_cnt++;
+      }
+    }
+  }
+  auto elapsed = ClockMs() - start_time;
+
+  return {frames, miss_cnt / static_cast<double>(elapsed) * 1000, access_cnt / static_cast<double>(elapsed) * 1000};
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-bench");
+  program.add_argument("--duration").help("run each pool size for n milliseconds");
+  program.add_argument("--max-frames").help("benchmark pool sizes from 64 up to n frames");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 3000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  size_t max_frames = 65536;
+  if (program.present("--max-frames")) {
+    max_frames = std::stoi(program.get("--max-frames"));
+  }
+
+  fmt::print(stderr, "[info] duration_ms={}, lru_k_size={}, hits_per_miss={}\n", duration_ms, LRU_K_SIZE,
+             HITS_PER_MISS);
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>15} {:>15}\n", "frames", "miss/s", "hit/s");
+  for (size_t frames = 64; frames <= max_frames; frames *= 8) {
+    auto result = RunBench(frames, duration_ms);
+    fmt::print("{:>10} {:>15.3f} {:>15.3f}\n", result.frames_, result.miss_per_sec_, result.access_per_sec_);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}